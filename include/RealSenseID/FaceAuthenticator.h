@@ -11,6 +11,7 @@
 #include "RealSenseID/Faceprints.h"
 #include "RealSenseID/UserFaceprints.h"
 #include "RealSenseID/SerialConfig.h"
+#include "RealSenseID/SessionConfig.h"
 #include "RealSenseID/SignatureCallback.h"
 #include "RealSenseID/Status.h"
 #include "RealSenseID/MatchResultHost.h"
@@ -68,6 +69,14 @@ public:
      */
     void Disconnect();
 
+    /**
+     * Set the session lifetime of the following operations.
+     *
+     * @param[in] config Session configuration
+     * @return Status (Status::Ok on success).
+     */
+    Status SetSessionConfig(const SessionConfig& config);
+
 #ifdef RSID_SECURE
     /**
      * Send updated host ecdsa key to device, sign it with previous ecdsa key (at first pair can sign with dummy key)
@@ -244,6 +253,22 @@ public:
     MatchResultHost MatchFaceprints(Faceprints& new_faceprints, Faceprints& existing_faceprints,
                                     Faceprints& updated_faceprints);
 
+    /**
+     * Match two faceprints to each other in place, on their adaptive (without mask) and enrollment descriptors.
+     * Same result as MatchFaceprints(), for callers that keep the descriptors in their own layout. The caller checks
+     * that both faceprints have the same version.
+     *
+     * @param[in] new_adaptive adaptive descriptor of the new faceprints.
+     * @param[in] existing_adaptive adaptive descriptor of the existing faceprints.
+     * @param[in] existing_enrollment enrollment descriptor of the existing faceprints.
+     * @param[out] updated_adaptive receives the updated adaptive descriptor if the result's 'should_update' is set
+     * (may point to existing_adaptive).
+     * @return MatchResultHost match result, the 'success' field indicates if the two faceprints belong to the same
+     * person.
+     */
+    MatchResultHost MatchDescriptors(const feature_t* new_adaptive, const feature_t* existing_adaptive,
+                                     const feature_t* existing_enrollment, feature_t* updated_adaptive);
+
     /**
      * Get the features descriptor for each user in the device's DB.
      * Number of users pulled is returned through num_of_users.
@@ -13,5 +13,7 @@ namespace RealSenseID
 struct RSID_API SerialConfig
 {
     const char* port = nullptr;
+    bool drain_after_send = false; // linux: wait until every sent byte was transmitted before returning from a send
+    bool event_driven = false;     // linux: wait for received data in ppoll instead of 200ms timed reads
 };
 } // namespace RealSenseID
@@ -0,0 +1,22 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "RealSenseIDExports.h"
+
+namespace RealSenseID
+{
+/**
+ * Session config.
+ * By default every operation starts a new session with the device (key exchange in secure mode).
+ * With resume, a session stays established across operations and a new one is started after max_operations
+ * operations or max_age_seconds seconds. A resumed session the device rejects is renegotiated and the request resent.
+ */
+struct RSID_API SessionConfig
+{
+    bool resume = false;
+    unsigned int max_operations = 1000; // 0 - no limit
+    unsigned int max_age_seconds = 600; // 0 - no limit
+};
+} // namespace RealSenseID
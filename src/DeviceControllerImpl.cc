@@ -32,6 +32,8 @@ Status DeviceControllerImpl::Connect(const SerialConfig& config)
         _serial.reset();
         PacketManager::SerialConfig serial_config;
         serial_config.port = config.port;
+        serial_config.drain_after_send = config.drain_after_send;
+        serial_config.event_driven = config.event_driven;
 
 #ifdef _WIN32
         _serial = std::make_unique<PacketManager::WindowsSerial>(serial_config);
@@ -46,6 +46,11 @@ void FaceAuthenticator::Disconnect()
     _impl->Disconnect();
 }
 
+Status FaceAuthenticator::SetSessionConfig(const SessionConfig& config)
+{
+    return _impl->SetSessionConfig(config);
+}
+
 #ifdef RSID_SECURE
 Status FaceAuthenticator::Pair(const char* ecdsa_host_pubKey, const char* ecdsa_host_pubkey_sig,
                                char* ecdsa_device_pubkey)
@@ -134,6 +139,12 @@ MatchResultHost FaceAuthenticator::MatchFaceprints(Faceprints& new_faceprints, F
     return _impl->MatchFaceprints(new_faceprints, existing_faceprints, updated_faceprints);
 }
 
+MatchResultHost FaceAuthenticator::MatchDescriptors(const feature_t* new_adaptive, const feature_t* existing_adaptive,
+                                                    const feature_t* existing_enrollment, feature_t* updated_adaptive)
+{
+    return _impl->MatchDescriptors(new_adaptive, existing_adaptive, existing_enrollment, updated_adaptive);
+}
+
 Status FaceAuthenticator::GetUsersFaceprints(Faceprints* user_features, unsigned int&num_of_users)
 {
     return _impl->GetUsersFaceprints(user_features, num_of_users);
@@ -79,9 +79,12 @@ Status FaceAuthenticatorImpl::Connect(const SerialConfig& config)
     try
     {
         // disconnect if already connected
+        _session.Close();
         _serial.reset();
         PacketManager::SerialConfig serial_config;
         serial_config.port = config.port;
+        serial_config.drain_after_send = config.drain_after_send;
+        serial_config.event_driven = config.event_driven;
 
 #ifdef _WIN32
         _serial = std::make_unique<PacketManager::WindowsSerial>(serial_config);
@@ -111,6 +114,7 @@ Status FaceAuthenticatorImpl::Connect(const AndroidSerialConfig& config)
     try
     {
         // disconnect if already connected
+        _session.Close();
         _serial.reset();
 
         _serial = std::make_unique<PacketManager::AndroidSerial>(config.fileDescriptor, config.readEndpoint,
@@ -132,9 +136,19 @@ Status FaceAuthenticatorImpl::Connect(const AndroidSerialConfig& config)
 
 void FaceAuthenticatorImpl::Disconnect()
 {
+    _session.Close();
     _serial.reset();
 }
 
+Status FaceAuthenticatorImpl::SetSessionConfig(const SessionConfig& config)
+{
+    _session_policy.resume = config.resume;
+    _session_policy.max_operations = config.max_operations;
+    _session_policy.max_age = std::chrono::seconds {config.max_age_seconds};
+    _session.Close();
+    return Status::Ok;
+}
+
 #ifdef RSID_SECURE
 Status FaceAuthenticatorImpl::Pair(const char* ecdsaHostPubKey, const char* ecdsaHostPubKeySig, char* ecdsaDevicePubKey)
 {
@@ -144,6 +158,7 @@ Status FaceAuthenticatorImpl::Pair(const char* ecdsaHostPubKey, const char* ecds
         return Status::Error;
     }
     LOG_INFO(LOG_TAG, "Pairing start");
+    _session.Close(); // sessions after pairing use the new keys
 
     unsigned char ecdsaSignedHostPubKey[SIGNED_PUBKEY_SIZE];
     ::memset(ecdsaSignedHostPubKey, 0, sizeof(ecdsaSignedHostPubKey));
@@ -189,6 +204,7 @@ Status FaceAuthenticatorImpl::Unpair()
         LOG_ERROR(LOG_TAG, "Not connected to a serial port");
         return Status::Error;
     }
+    _session.Close();
     auto status = _session.Unpair(_serial.get());
     return ToStatus(status);
 }
@@ -243,7 +259,7 @@ Status FaceAuthenticatorImpl::Enroll(EnrollmentCallback& callback, const char* u
         {
             return Status::Error;
         }
-        auto status = _session.Start(_serial.get());
+        auto status = _session.Resume(_serial.get(), _session_policy);
         if (status != PacketManager::SerialStatus::Ok)
         {
             LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -341,7 +357,7 @@ Status FaceAuthenticatorImpl::Authenticate(AuthenticationCallback& callback)
 {
     try
     {
-        auto status = _session.Start(_serial.get());
+        auto status = _session.Resume(_serial.get(), _session_policy);
         if (status != PacketManager::SerialStatus::Ok)
         {
             LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -546,7 +562,7 @@ Status FaceAuthenticatorImpl::RemoveUser(const char* user_id)
         {
             return Status::Error;
         }
-        auto status = _session.Start(_serial.get());
+        auto status = _session.Resume(_serial.get(), _session_policy);
         if (status != PacketManager::SerialStatus::Ok)
         {
             LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -586,7 +602,7 @@ Status FaceAuthenticatorImpl::RemoveAll()
 {
     try
     {
-        auto status = _session.Start(_serial.get());
+        auto status = _session.Resume(_serial.get(), _session_policy);
         if (status != PacketManager::SerialStatus::Ok)
         {
             LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -632,7 +648,7 @@ Status FaceAuthenticatorImpl::SetDeviceConfig(const DeviceConfig& device_config)
         return query_status;
     }
    
-    auto status = _session.Start(_serial.get());
+    auto status = _session.Resume(_serial.get(), _session_policy);
     if (status != PacketManager::SerialStatus::Ok)
     {
         LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -682,7 +698,7 @@ Status FaceAuthenticatorImpl::SetDeviceConfig(const DeviceConfig& device_config)
 
 Status FaceAuthenticatorImpl::QueryDeviceConfig(DeviceConfig& device_config)
 {
-    auto status = _session.Start(_serial.get());
+    auto status = _session.Resume(_serial.get(), _session_policy);
     if (status != PacketManager::SerialStatus::Ok)
     {
         LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -743,7 +759,7 @@ Status FaceAuthenticatorImpl::QueryUserIds(char** user_ids, unsigned int& number
         for (unsigned int i = 0; i < number_of_users && retrieved_user_count < number_of_users; i += arrived_users)
         {
             LOG_DEBUG(LOG_TAG, "Get userids.  So far:%u", i);
-            auto status = _session.Start(_serial.get());
+            auto status = _session.Resume(_serial.get(), _session_policy);
             if (status != PacketManager::SerialStatus::Ok)
             {
                 LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -827,7 +843,7 @@ Status FaceAuthenticatorImpl::QueryNumberOfUsers(unsigned int& number_of_users)
 {
     try
     {
-        auto status = _session.Start(_serial.get());
+        auto status = _session.Resume(_serial.get(), _session_policy);
         if (status != PacketManager::SerialStatus::Ok)
         {
             LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -882,7 +898,7 @@ Status FaceAuthenticatorImpl::Standby()
 {
     try
     {
-        auto status = _session.Start(_serial.get());
+        auto status = _session.Resume(_serial.get(), _session_policy);
         if (status != PacketManager::SerialStatus::Ok)
         {
             LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -931,7 +947,7 @@ Status FaceAuthenticatorImpl::ExtractFaceprintsForEnroll(EnrollFaceprintsExtract
 {
     try
     {
-        auto status = _session.Start(_serial.get());
+        auto status = _session.Resume(_serial.get(), _session_policy);
         if (status != PacketManager::SerialStatus::Ok)
         {
             LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -1098,7 +1114,7 @@ Status FaceAuthenticatorImpl::ExtractFaceprintsForAuth(AuthFaceprintsExtractionC
 {
     try
     {
-        auto status = _session.Start(_serial.get());
+        auto status = _session.Resume(_serial.get(), _session_policy);
         if (status != PacketManager::SerialStatus::Ok)
         {
             LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
@@ -1317,6 +1333,23 @@ MatchResultHost FaceAuthenticatorImpl::MatchFaceprints(Faceprints& new_faceprint
     return finalResult;
 }
 
+MatchResultHost FaceAuthenticatorImpl::MatchDescriptors(const feature_t* new_adaptive,
+                                                        const feature_t* existing_adaptive,
+                                                        const feature_t* existing_enrollment,
+                                                        feature_t* updated_adaptive)
+{
+    MatchResultHost finalResult;
+
+    auto result = Matcher::MatchDescriptors(new_adaptive, existing_adaptive, existing_enrollment, updated_adaptive,
+                                            Matcher::GetDefaultThresholds());
+    finalResult.success = result.success;
+    finalResult.should_update = result.should_update;
+    finalResult.score = result.score;
+    finalResult.confidence = result.confidence;
+
+    return finalResult;
+}
+
 // Validate given user id.
 // Return true if valid, false otherwise.
 bool FaceAuthenticatorImpl::ValidateUserId(const char* user_id)
@@ -1338,7 +1371,7 @@ bool FaceAuthenticatorImpl::ValidateUserId(const char* user_id)
 
 Status FaceAuthenticatorImpl::GetUsersFaceprints(Faceprints* user_features, unsigned int& num_of_users)
 {
-    auto status = _session.Start(_serial.get());
+    auto status = _session.Resume(_serial.get(), _session_policy);
     bool all_is_well = true;
     PacketManager::SerialStatus bad_status = PacketManager::SerialStatus::Ok;
     if (status != PacketManager::SerialStatus::Ok)
@@ -1426,7 +1459,7 @@ Status FaceAuthenticatorImpl::GetUsersFaceprints(Faceprints* user_features, unsi
 Status FaceAuthenticatorImpl::SetUsersFaceprints(UserFaceprints* user_features, unsigned int num_of_users)
 {
     bool all_users_set = true;
-    auto status = _session.Start(_serial.get());
+    auto status = _session.Resume(_serial.get(), _session_policy);
     if (status != PacketManager::SerialStatus::Ok)
     {
         LOG_ERROR(LOG_TAG, "Session start failed with status %d", static_cast<int>(status));
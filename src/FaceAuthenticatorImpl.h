@@ -11,6 +11,7 @@
 #include "RealSenseID/Faceprints.h"
 #include "RealSenseID/UserFaceprints.h"
 #include "RealSenseID/SerialConfig.h"
+#include "RealSenseID/SessionConfig.h"
 #include "RealSenseID/SignatureCallback.h"
 #include "RealSenseID/Status.h"
 #include "RealSenseID/MatchResultHost.h"
@@ -52,6 +53,8 @@ public:
 
     void Disconnect();
 
+    Status SetSessionConfig(const SessionConfig& config);
+
 #ifdef RSID_SECURE
     Status Pair(const char* ecdsaHostPubKey, const char* ecdsaHostPubKeySig, char* ecdsaDevicePubKey);
     Status Unpair();    
@@ -75,6 +78,8 @@ public:
     Status ExtractFaceprintsForAuthLoop(AuthFaceprintsExtractionCallback& callback);
     MatchResultHost MatchFaceprints(Faceprints& new_faceprints, Faceprints& existing_faceprints,
                                     Faceprints& updated_faceprints);
+    MatchResultHost MatchDescriptors(const feature_t* new_adaptive, const feature_t* existing_adaptive,
+                                     const feature_t* existing_enrollment, feature_t* updated_adaptive);
 
     Status GetUsersFaceprints(Faceprints* user_features, unsigned int& num_of_users);
     Status SetUsersFaceprints(UserFaceprints* users_faceprints, unsigned int num_of_users);
@@ -92,6 +97,7 @@ private:
     std::atomic<bool> _cancel_loop {false};
     std::unique_ptr<PacketManager::SerialConnection> _serial;
     Session _session;
+    PacketManager::SessionPolicy _session_policy;
 
     // wait for cancel flag while sleeping upto timeout
     void AuthLoopSleep(std::chrono::milliseconds timeout);
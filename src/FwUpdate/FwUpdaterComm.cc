@@ -32,6 +32,8 @@ FwUpdaterComm::FwUpdaterComm(const char* port_name)
     _read_buffer = new char[ReadBufferSize];
     PacketManager::SerialConfig serial_config;
     serial_config.port = port_name;
+    // each chunk must be fully transmitted before the device is given time to process it
+    serial_config.drain_after_send = true;
 
 #ifdef _WIN32
     _serial = std::make_unique<PacketManager::WindowsSerial>(serial_config);
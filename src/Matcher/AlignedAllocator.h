@@ -0,0 +1,71 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace RealSenseID
+{
+// minimal std allocator returning memory aligned to Alignment bytes (e.g. cache line).
+template <typename T, std::size_t Alignment>
+class AlignedAllocator
+{
+    static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of 2");
+    static_assert(Alignment >= sizeof(void*), "Alignment must be at least pointer size");
+
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        // over-allocate and keep the original pointer just before the aligned block.
+        std::size_t bytes = n * sizeof(T) + Alignment + sizeof(void*);
+        void* raw = std::malloc(bytes);
+        if (raw == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+        std::uintptr_t aligned = (start + Alignment - 1) & ~static_cast<std::uintptr_t>(Alignment - 1);
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+        return reinterpret_cast<T*>(aligned);
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+        if (p != nullptr)
+        {
+            std::free(reinterpret_cast<void**>(p)[-1]);
+        }
+    }
+};
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) noexcept
+{
+    return false;
+}
+} // namespace RealSenseID
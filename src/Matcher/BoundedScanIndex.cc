@@ -0,0 +1,224 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "BoundedScanIndex.h"
+#include "Gallery.h"
+#include "MatcherKernels.h"
+#include "MatcherSimd.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "BoundedScanIndex";
+
+constexpr uint32_t BoundedScanIndex::VectorLength;
+constexpr uint32_t BoundedScanIndex::BlockLength;
+constexpr uint32_t BoundedScanIndex::NumberOfBlocks;
+constexpr uint32_t BoundedScanIndex::FirstBoundBlock;
+
+using block_kernels_t = MatcherKernels::VectorKernels<BoundedScanIndex::BlockLength, feature_t, int32_t>;
+
+// double rounding margin of the bound test - abandoning must never drop a candidate that could beat the best score.
+static const double s_boundMargin = 1.0 - 1e-9;
+
+// sqrt(value), rounded up to float.
+static float RootUp(uint64_t value)
+{
+    double root = std::sqrt(static_cast<double>(value));
+    float rounded = static_cast<float>(root);
+    return (static_cast<double>(rounded) < root) ? std::nextafter(rounded, 2 * rounded + 1) : rounded;
+}
+
+void BoundedScanIndex::Build(const Gallery& gallery)
+{
+    // energy of every feature over the valid users.
+    std::vector<uint64_t> energy(VectorLength, 0);
+    for (std::size_t i = 0; i < gallery.Size(); i++)
+    {
+        if (!gallery.IsValid(i))
+        {
+            continue;
+        }
+        const feature_t* descriptor = gallery.Descriptor(i);
+        for (uint32_t f = 0; f < VectorLength; f++)
+        {
+            energy[f] += static_cast<uint64_t>(static_cast<int32_t>(descriptor[f]) * descriptor[f]);
+        }
+    }
+
+    _permutation.resize(VectorLength);
+    std::iota(_permutation.begin(), _permutation.end(), 0);
+    std::stable_sort(_permutation.begin(), _permutation.end(),
+                     [&energy](uint32_t a, uint32_t b) { return energy[a] > energy[b]; });
+
+    _descriptors.clear();
+    _norms.clear();
+    _valid.clear();
+    _remaining_norms.clear();
+    _descriptors.reserve(gallery.Size() * VectorLength);
+    _norms.reserve(gallery.Size());
+    _valid.reserve(gallery.Size());
+    _remaining_norms.reserve(gallery.Size() * NumberOfBlocks);
+    for (std::size_t i = 0; i < gallery.Size(); i++)
+    {
+        SetUser(gallery, i);
+    }
+}
+
+bool BoundedScanIndex::Update(const Gallery& gallery, std::size_t index)
+{
+    if (_permutation.empty())
+    {
+        LOG_ERROR(LOG_TAG, "Index was not built");
+        return false;
+    }
+
+    const std::size_t size = gallery.Size();
+    _descriptors.resize(size * VectorLength);
+    _norms.resize(size);
+    _valid.resize(size);
+    _remaining_norms.resize(size * NumberOfBlocks);
+
+    if (index < size)
+    {
+        SetUser(gallery, index);
+    }
+    return true;
+}
+
+void BoundedScanIndex::SetUser(const Gallery& gallery, std::size_t index)
+{
+    if (index >= _norms.size())
+    {
+        _descriptors.resize((index + 1) * VectorLength);
+        _norms.resize(index + 1);
+        _valid.resize(index + 1);
+        _remaining_norms.resize((index + 1) * NumberOfBlocks);
+    }
+
+    const feature_t* descriptor = gallery.Descriptor(index);
+    feature_t* permuted = &_descriptors[index * VectorLength];
+    for (uint32_t f = 0; f < VectorLength; f++)
+    {
+        permuted[f] = descriptor[_permutation[f]];
+    }
+
+    _norms[index] = gallery.Norm(index);
+    _valid[index] = gallery.IsValid(index) ? 1 : 0;
+
+    // remaining norm after each block, from the last block back.
+    uint64_t remaining = 0;
+    float* remaining_norms = &_remaining_norms[index * NumberOfBlocks];
+    for (uint32_t b = NumberOfBlocks; b-- > 0;)
+    {
+        remaining_norms[b] = RootUp(remaining);
+        remaining += block_kernels_t::ComputeSums(permuted + b * BlockLength, permuted + b * BlockLength).norm1;
+    }
+}
+
+TagResult BoundedScanIndex::Search(const feature_t* query, match_calc_t threshold, MatchSearchMode mode,
+                                   Stats* stats) const
+{
+    TagResult best;
+    best.score = 0;
+    best.id = -1;
+
+    alignas(64) feature_t permuted[VectorLength];
+    for (uint32_t f = 0; f < VectorLength; f++)
+    {
+        permuted[f] = query[_permutation[f]];
+    }
+
+    const uint32_t query_norm = MatcherKernels::MatcherVectorKernels::ComputeSums(permuted, permuted).norm1;
+    double query_remaining[NumberOfBlocks];
+    uint64_t remaining = 0;
+    for (uint32_t b = NumberOfBlocks; b-- > 0;)
+    {
+        query_remaining[b] = std::sqrt(static_cast<double>(remaining));
+        remaining += block_kernels_t::ComputeSums(permuted + b * BlockLength, permuted + b * BlockLength).norm1;
+    }
+
+    Stats local_stats;
+    const bool early_exit = (mode == MatchSearchMode::FirstAboveThreshold);
+
+    for (std::size_t i = 0; i < _norms.size(); i++)
+    {
+        if (!_valid[i])
+        {
+            continue;
+        }
+        local_stats.scanned++;
+
+        const feature_t* descriptor = &_descriptors[i * VectorLength];
+        const float* remaining_norms = &_remaining_norms[i * NumberOfBlocks];
+
+        // the candidate can't beat the best score if 4096 * bound^2 <= best * norm1 * norm2 (the integer grade never
+        // exceeds 4096 * corr^2 / (norm1 * norm2)), or if the bound is not positive (grade 0).
+        const double limit = s_boundMargin * best.score * query_norm * _norms[i] / RSID_MAX_POSSIBLE_SCORE;
+
+        // the bound can't be tight before most of the energy was seen - the first blocks are multiplied in one go.
+        int32_t corr = MatcherSimd::DotProduct(permuted, descriptor, FirstBoundBlock * BlockLength);
+        uint32_t b = FirstBoundBlock - 1;
+        for (;;)
+        {
+            double bound = corr + query_remaining[b] * remaining_norms[b];
+            if (bound <= 0 || bound * bound < limit || ++b == NumberOfBlocks - 1)
+            {
+                break;
+            }
+
+            corr += block_kernels_t::DotProduct(permuted + b * BlockLength, descriptor + b * BlockLength);
+        }
+        local_stats.blocks += b + 1;
+
+        if (b < NumberOfBlocks - 1)
+        {
+            local_stats.abandoned++;
+            continue;
+        }
+
+        corr += block_kernels_t::DotProduct(permuted + b * BlockLength, descriptor + b * BlockLength);
+        match_calc_t score = Matcher::NormalizeScore(corr, query_norm, _norms[i]);
+        if (score > best.score)
+        {
+            best.score = score;
+            best.id = static_cast<int>(i);
+        }
+
+        if (early_exit && score > threshold)
+        {
+            break;
+        }
+    }
+
+    if (stats != nullptr)
+    {
+        *stats = local_stats;
+    }
+    return best;
+}
+
+ExtendedMatchResult BoundedScanIndex::Match(const Faceprints& new_faceprints, const Gallery& gallery,
+                                            Faceprints& updated_faceprints, const Thresholds& thresholds,
+                                            MatchSearchMode mode, Stats* stats) const
+{
+    if (!Matcher::ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return ExtendedMatchResult();
+    }
+
+    if (Size() != gallery.Size() || _permutation.empty())
+    {
+        LOG_ERROR(LOG_TAG, "Index is not in sync with the gallery (%zu vs %zu users)", Size(), gallery.Size());
+        return ExtendedMatchResult();
+    }
+
+    TagResult best = Search(&new_faceprints.adaptiveDescriptorWithoutMask[0], thresholds.strongThreshold_pNMgNM, mode,
+                            stats);
+
+    return Matcher::FinalizeGalleryMatch(new_faceprints, gallery, best, updated_faceprints, thresholds);
+}
+} // namespace RealSenseID
@@ -0,0 +1,83 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include "AlignedAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RealSenseID
+{
+class Gallery;
+
+// Exact gallery scan with Cauchy-Schwarz early termination.
+//
+// A candidate's dot product is accumulated block by block (16 features). After each block its final correlation is
+// bounded by
+//     corr <= partial_corr + |remaining query| * |remaining gallery vector|
+// and the candidate is abandoned as soon as the ncc grade of that bound can't beat the best score so far (so it can't
+// cross the threshold either). Candidates that are not abandoned are scored with the exact integer ncc, so results are
+// identical to the exhaustive scan (Matcher::MatchFaceprintsToGallery).
+//
+// Features are permuted by decreasing gallery energy (mean square) when the index is built, so most of each vector's
+// energy is in the first blocks and the bound tightens quickly. The index keeps a permuted copy of the gallery search
+// data, aligned with gallery indices.
+class BoundedScanIndex
+{
+public:
+    static constexpr uint32_t VectorLength = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER;
+    static constexpr uint32_t BlockLength = 16;
+    static constexpr uint32_t NumberOfBlocks = VectorLength / BlockLength;
+    // blocks multiplied before the first bound test (earlier tests rarely abandon and cost more than they save).
+    static constexpr uint32_t FirstBoundBlock = NumberOfBlocks * 3 / 4;
+    static_assert(VectorLength % BlockLength == 0, "Vector length must be a multiple of the block length");
+
+    struct Stats
+    {
+        std::size_t scanned = 0;   // valid users visited
+        std::size_t abandoned = 0; // users abandoned before their last block
+        uint64_t blocks = 0;       // blocks multiplied (NumberOfBlocks per user for a full scan)
+    };
+
+    BoundedScanIndex() = default;
+
+    // compute the feature permutation from the gallery and copy its search data.
+    void Build(const Gallery& gallery);
+
+    // refresh user index from the gallery after Gallery::Add/Update/Remove (Remove moves the last user into the removed
+    // index). the index is resized to the gallery size. the permutation is kept (rebuild after large changes).
+    bool Update(const Gallery& gallery, std::size_t index);
+
+    std::size_t Size() const
+    {
+        return _norms.size();
+    }
+
+    // best user, same as the sequential gallery scan: with MatchSearchMode::FirstAboveThreshold the scan stops at the
+    // first user above threshold. result.id is the gallery index (-1 if no user scored above 0).
+    TagResult Search(const feature_t* query, match_calc_t threshold, MatchSearchMode mode,
+                     Stats* stats = nullptr) const;
+
+    // same semantics as Matcher::MatchFaceprintsToGallery() (with mode FirstAboveThreshold). the index must be in sync
+    // with the gallery.
+    ExtendedMatchResult Match(const Faceprints& new_faceprints, const Gallery& gallery, Faceprints& updated_faceprints,
+                              const Thresholds& thresholds,
+                              MatchSearchMode mode = MatchSearchMode::FirstAboveThreshold,
+                              Stats* stats = nullptr) const;
+
+private:
+    void SetUser(const Gallery& gallery, std::size_t index);
+
+    // features in decreasing energy order: permuted[i] = original[_permutation[i]].
+    std::vector<uint32_t> _permutation;
+
+    std::vector<feature_t, AlignedAllocator<feature_t, 64>> _descriptors; // permuted
+    std::vector<uint32_t> _norms;
+    std::vector<uint8_t> _valid;
+    // per user and block b: norm of the features after block b (rounded up, so the bound stays an upper bound).
+    std::vector<float> _remaining_norms;
+};
+} // namespace RealSenseID
@@ -0,0 +1,177 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "DuplicateFinder.h"
+#include "Gallery.h"
+#include "MatcherSimd.h"
+#include "Logger.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "DuplicateFinder";
+
+constexpr std::size_t DuplicateFinder::DefaultTileSize;
+constexpr std::size_t DuplicateFinder::MinTileSize;
+
+DuplicateFinder::DuplicateFinder(std::size_t num_threads, std::size_t tile_size) :
+    _pool(num_threads), _tile_size(std::max(tile_size, MinTileSize))
+{
+}
+
+std::size_t DuplicateFinder::NumberOfTiles(std::size_t number_of_users) const
+{
+    std::size_t blocks = (number_of_users + _tile_size - 1) / _tile_size;
+    return blocks * (blocks + 1) / 2;
+}
+
+void DuplicateFinder::ScoreTile(const Gallery& gallery, std::size_t row_begin, std::size_t row_end,
+                                std::size_t column_begin, std::size_t column_end, match_calc_t threshold,
+                                std::vector<SimilarPair>& pairs)
+{
+    const uint32_t vec_length = Gallery::VectorLength;
+    const bool diagonal = (row_begin == column_begin);
+    const double threshold_norms = (1.0 - 1e-9) * threshold;
+
+    // valid rows of the tile, in groups of 4 (each column descriptor is loaded once per group).
+    std::vector<std::size_t> rows;
+    for (std::size_t i = row_begin; i < row_end; i++)
+    {
+        if (gallery.IsValid(i))
+        {
+            rows.push_back(i);
+        }
+    }
+
+    for (std::size_t r = 0; r < rows.size(); r += 4)
+    {
+        const std::size_t group_size = std::min<std::size_t>(4, rows.size() - r);
+        const feature_t* probes[4];
+        for (std::size_t p = 0; p < 4; p++)
+        {
+            // a short last group repeats its first row (scores of the padding are ignored).
+            probes[p] = gallery.Descriptor(rows[r + (p < group_size ? p : 0)]);
+        }
+
+        // on the diagonal tile only columns after the first row of the group are needed.
+        const std::size_t first_column = diagonal ? rows[r] + 1 : column_begin;
+        for (std::size_t j = first_column; j < column_end; j++)
+        {
+            if (!gallery.IsValid(j))
+            {
+                continue;
+            }
+
+            int32_t corr[4];
+            MatcherSimd::DotProduct4(gallery.Descriptor(j), probes, vec_length, corr);
+            for (std::size_t p = 0; p < group_size; p++)
+            {
+                const std::size_t i = rows[r + p];
+                if (diagonal && j <= i)
+                {
+                    continue;
+                }
+
+                // the integer grade never exceeds 4096 * corr^2 / (norm1 * norm2) (it only truncates), so pairs whose
+                // exact ncc^2 is below the threshold are skipped without normalizing (the margin covers double
+                // rounding).
+                const double corr2 = static_cast<double>(corr[p]) * corr[p];
+                const double norms = static_cast<double>(gallery.Norm(i)) * gallery.Norm(j);
+                if (corr[p] <= 0 || corr2 * RSID_MAX_POSSIBLE_SCORE < threshold_norms * norms)
+                {
+                    continue;
+                }
+
+                // NormalizeScore() is symmetric in its norms, so this is MatchTwoVectors() of either order.
+                match_calc_t score = Matcher::NormalizeScore(corr[p], gallery.Norm(i), gallery.Norm(j));
+                if (score > threshold)
+                {
+                    SimilarPair pair;
+                    pair.first = i;
+                    pair.second = j;
+                    pair.score = score;
+                    pairs.push_back(pair);
+                }
+            }
+        }
+    }
+}
+
+std::size_t DuplicateFinder::FindSimilarPairs(const Gallery& gallery, match_calc_t threshold,
+                                              const TileCallback& callback, std::size_t first_tile,
+                                              const std::atomic<bool>* cancel)
+{
+    const std::size_t number_of_users = gallery.Size();
+    const std::size_t number_of_tiles = NumberOfTiles(number_of_users);
+    if (first_tile >= number_of_tiles)
+    {
+        return number_of_tiles;
+    }
+
+    // tile index -> (row block, column block), row by row over the upper triangle.
+    const std::size_t blocks = (number_of_users + _tile_size - 1) / _tile_size;
+    std::vector<std::pair<std::size_t, std::size_t>> tiles;
+    tiles.reserve(number_of_tiles);
+    for (std::size_t row = 0; row < blocks; row++)
+    {
+        for (std::size_t column = row; column < blocks; column++)
+        {
+            tiles.emplace_back(row, column);
+        }
+    }
+
+    // tiles complete out of order - finished tiles wait here until all tiles before them were reported.
+    std::mutex report_mutex;
+    std::map<std::size_t, std::vector<SimilarPair>> finished;
+    std::size_t next_to_report = first_tile;
+    std::atomic<bool> stop {false};
+
+    _pool.ParallelFor(number_of_tiles - first_tile, [&](std::size_t task) {
+        if (stop.load(std::memory_order_relaxed) || (cancel != nullptr && cancel->load(std::memory_order_relaxed)))
+        {
+            stop.store(true, std::memory_order_relaxed);
+            return;
+        }
+
+        const std::size_t tile = first_tile + task;
+        const std::size_t row_begin = tiles[tile].first * _tile_size;
+        const std::size_t column_begin = tiles[tile].second * _tile_size;
+
+        std::vector<SimilarPair> pairs;
+        ScoreTile(gallery, row_begin, std::min(row_begin + _tile_size, number_of_users), column_begin,
+                  std::min(column_begin + _tile_size, number_of_users), threshold, pairs);
+
+        std::lock_guard<std::mutex> lock(report_mutex);
+        finished[tile] = std::move(pairs);
+        while (!stop.load(std::memory_order_relaxed) && !finished.empty() &&
+               finished.begin()->first == next_to_report)
+        {
+            if (!callback(next_to_report, finished.begin()->second))
+            {
+                stop.store(true, std::memory_order_relaxed);
+            }
+            finished.erase(finished.begin());
+            next_to_report++;
+        }
+    });
+
+    if (next_to_report < number_of_tiles)
+    {
+        LOG_DEBUG(LOG_TAG, "Stopped after tile %zu of %zu", next_to_report, number_of_tiles);
+    }
+
+    return next_to_report;
+}
+
+std::vector<SimilarPair> DuplicateFinder::FindSimilarPairs(const Gallery& gallery, match_calc_t threshold)
+{
+    std::vector<SimilarPair> all_pairs;
+    FindSimilarPairs(gallery, threshold, [&all_pairs](std::size_t, const std::vector<SimilarPair>& pairs) {
+        all_pairs.insert(all_pairs.end(), pairs.begin(), pairs.end());
+        return true;
+    });
+    return all_pairs;
+}
+} // namespace RealSenseID
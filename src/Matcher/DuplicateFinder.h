@@ -0,0 +1,79 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include "WorkerPool.h"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace RealSenseID
+{
+class Gallery;
+
+// pair of gallery users with similar search descriptors (first < second).
+struct SimilarPair
+{
+    std::size_t first = 0;
+    std::size_t second = 0;
+    match_calc_t score = 0;
+};
+
+// All-pairs similarity job over a gallery, e.g. for auditing duplicate enrollments (pairs above identicalThreshold_NM).
+//
+// The N x N score matrix is cut into tiles of tile_size x tile_size users (upper triangle only). Both sides of a tile
+// stay in cache while it is scored, each column descriptor is loaded once for 4 row descriptors, and tiles are scored
+// on a worker pool. Scores are the exact integer ncc of Matcher::MatchTwoVectors().
+//
+// Only pairs above the threshold are kept. They are streamed to the caller tile by tile, in increasing tile order, so
+// a job can be checkpointed after any tile and resumed from the next one.
+class DuplicateFinder
+{
+public:
+    // 256 users x 512 bytes = 128KB per tile side - both sides fit L2.
+    static constexpr std::size_t DefaultTileSize = 256;
+    static constexpr std::size_t MinTileSize = 16;
+
+    // called once per tile, in increasing tile order, from one thread at a time. return false to stop the job.
+    using TileCallback = std::function<bool(std::size_t tile, const std::vector<SimilarPair>& pairs)>;
+
+    // num_threads = 0 uses all hardware threads.
+    explicit DuplicateFinder(std::size_t num_threads = 0, std::size_t tile_size = DefaultTileSize);
+
+    DuplicateFinder(const DuplicateFinder&) = delete;
+    DuplicateFinder& operator=(const DuplicateFinder&) = delete;
+
+    // number of tiles of the job over a gallery of the given size.
+    std::size_t NumberOfTiles(std::size_t number_of_users) const;
+
+    // score tiles [first_tile, NumberOfTiles()) and report the pairs with score > threshold of each tile.
+    // returns the first tile not reported (NumberOfTiles() when the job completed) - the first_tile to resume from.
+    // the gallery must not change between a job and its resumption.
+    std::size_t FindSimilarPairs(const Gallery& gallery, match_calc_t threshold, const TileCallback& callback,
+                                 std::size_t first_tile = 0, const std::atomic<bool>* cancel = nullptr);
+
+    // all pairs with score > threshold, in tile order.
+    std::vector<SimilarPair> FindSimilarPairs(const Gallery& gallery, match_calc_t threshold);
+
+    std::size_t NumThreads() const
+    {
+        return _pool.NumThreads();
+    }
+
+    std::size_t TileSize() const
+    {
+        return _tile_size;
+    }
+
+private:
+    // pairs of tile (row block, column block), row block <= column block.
+    static void ScoreTile(const Gallery& gallery, std::size_t row_begin, std::size_t row_end, std::size_t column_begin,
+                          std::size_t column_end, match_calc_t threshold, std::vector<SimilarPair>& pairs);
+
+    WorkerPool _pool;
+    std::size_t _tile_size;
+};
+} // namespace RealSenseID
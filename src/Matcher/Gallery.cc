@@ -0,0 +1,481 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "Gallery.h"
+#include "GalleryFile.h"
+#include "Matcher.h"
+#include "MatcherSimd.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "Gallery";
+
+constexpr std::size_t Gallery::Alignment;
+constexpr uint32_t Gallery::VectorLength;
+constexpr uint32_t Gallery::DescriptorStride;
+constexpr uint32_t Gallery::CodeWords;
+
+Gallery::Gallery(const Gallery& other)
+    : _version(other._version), _size(other._size), _view(other._view), _mapping(other._mapping),
+      _descriptors(other._descriptors), _norms(other._norms), _valid(other._valid), _codes(other._codes),
+      _faceprints(other._faceprints), _user_ids(other._user_ids)
+{
+    UpdateView();
+}
+
+Gallery::Gallery(Gallery&& other) noexcept
+    : _version(other._version), _size(other._size), _view(other._view), _mapping(std::move(other._mapping)),
+      _descriptors(std::move(other._descriptors)), _norms(std::move(other._norms)), _valid(std::move(other._valid)),
+      _codes(std::move(other._codes)), _faceprints(std::move(other._faceprints)),
+      _user_ids(std::move(other._user_ids))
+{
+    UpdateView();
+    other.Clear();
+}
+
+Gallery& Gallery::operator=(const Gallery& other)
+{
+    if (this != &other)
+    {
+        Gallery copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+Gallery& Gallery::operator=(Gallery&& other) noexcept
+{
+    if (this != &other)
+    {
+        _version = other._version;
+        _size = other._size;
+        _view = other._view;
+        _mapping = std::move(other._mapping);
+        _descriptors = std::move(other._descriptors);
+        _norms = std::move(other._norms);
+        _valid = std::move(other._valid);
+        _codes = std::move(other._codes);
+        _faceprints = std::move(other._faceprints);
+        _user_ids = std::move(other._user_ids);
+        UpdateView();
+        other.Clear();
+    }
+    return *this;
+}
+
+void Gallery::UpdateView()
+{
+    if (_mapping)
+    {
+        return;
+    }
+
+    _view = View();
+    _view.descriptors = _descriptors.data();
+    _view.norms = _norms.data();
+    _view.valid = _valid.data();
+    _view.codes = _codes.data();
+    _view.faceprints = _faceprints.data();
+}
+
+void Gallery::Unmap()
+{
+    if (!_mapping)
+    {
+        return;
+    }
+
+    const std::size_t size = _size;
+    _descriptors.assign(_view.descriptors, _view.descriptors + size * DescriptorStride);
+    _norms.assign(_view.norms, _view.norms + size);
+    _valid.assign(_view.valid, _view.valid + size);
+    _codes.assign(_view.codes, _view.codes + size * CodeWords);
+    _faceprints.assign(_view.faceprints, _view.faceprints + size);
+    _user_ids.clear();
+    _user_ids.reserve(size);
+    for (std::size_t i = 0; i < size; i++)
+    {
+        _user_ids.emplace_back(UserId(i));
+    }
+
+    _mapping.reset();
+    UpdateView();
+}
+
+void Gallery::Reserve(std::size_t number_of_users)
+{
+    Unmap();
+    _descriptors.reserve(number_of_users * DescriptorStride);
+    _norms.reserve(number_of_users);
+    _valid.reserve(number_of_users);
+    _codes.reserve(number_of_users * CodeWords);
+    _faceprints.reserve(number_of_users);
+    _user_ids.reserve(number_of_users);
+}
+
+bool Gallery::Add(const char* user_id, const Faceprints& faceprints)
+{
+    if (user_id == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Null user id");
+        return false;
+    }
+
+    Unmap();
+
+    if (Empty())
+    {
+        _version = faceprints.version;
+    }
+    else if (faceprints.version != _version)
+    {
+        LOG_ERROR(LOG_TAG, "Faceprints version %d doesn't match gallery version %d", faceprints.version, _version);
+        return false;
+    }
+
+    _descriptors.resize(_descriptors.size() + DescriptorStride, 0);
+    _norms.push_back(0);
+    _valid.push_back(0);
+    _codes.resize(_codes.size() + CodeWords, 0);
+    _faceprints.push_back(faceprints);
+    _user_ids.emplace_back(user_id);
+    _size++;
+    UpdateView();
+
+    SetSearchData(_size - 1, faceprints);
+    return true;
+}
+
+bool Gallery::Update(std::size_t index, const Faceprints& faceprints)
+{
+    if (index >= Size())
+    {
+        LOG_ERROR(LOG_TAG, "Invalid gallery index %zu", index);
+        return false;
+    }
+
+    if (faceprints.version != _version)
+    {
+        LOG_ERROR(LOG_TAG, "Faceprints version %d doesn't match gallery version %d", faceprints.version, _version);
+        return false;
+    }
+
+    Unmap();
+    _faceprints[index] = faceprints;
+    SetSearchData(index, faceprints);
+    return true;
+}
+
+bool Gallery::Remove(std::size_t index)
+{
+    if (index >= Size())
+    {
+        LOG_ERROR(LOG_TAG, "Invalid gallery index %zu", index);
+        return false;
+    }
+
+    Unmap();
+
+    std::size_t last = Size() - 1;
+    if (index != last)
+    {
+        std::copy_n(Descriptor(last), DescriptorStride, &_descriptors[index * DescriptorStride]);
+        _norms[index] = _norms[last];
+        _valid[index] = _valid[last];
+        std::copy_n(Code(last), CodeWords, &_codes[index * CodeWords]);
+        _faceprints[index] = _faceprints[last];
+        _user_ids[index] = std::move(_user_ids[last]);
+    }
+
+    _descriptors.resize(last * DescriptorStride);
+    _norms.pop_back();
+    _valid.pop_back();
+    _codes.resize(last * CodeWords);
+    _faceprints.pop_back();
+    _user_ids.pop_back();
+    _size--;
+    UpdateView();
+    return true;
+}
+
+void Gallery::Clear()
+{
+    _version = 0;
+    _descriptors.clear();
+    _norms.clear();
+    _valid.clear();
+    _codes.clear();
+    _faceprints.clear();
+    _user_ids.clear();
+    _size = 0;
+    _mapping.reset();
+    UpdateView();
+}
+
+static uint64_t AlignSection(uint64_t offset)
+{
+    const uint64_t alignment = GalleryFileHeader::SectionAlignment;
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// writes sections at their offsets (zero padding in between) and checksums everything after the header.
+class GalleryFileWriter
+{
+public:
+    explicit GalleryFileWriter(std::ofstream& stream) : _stream(stream), _position(sizeof(GalleryFileHeader))
+    {
+    }
+
+    void Write(uint64_t offset, const void* data, std::size_t size)
+    {
+        static const uint8_t zeros[GalleryFileHeader::SectionAlignment] = {0};
+        while (_position < offset)
+        {
+            std::size_t padding = static_cast<std::size_t>(std::min<uint64_t>(offset - _position, sizeof(zeros)));
+            Append(zeros, padding);
+        }
+        Append(data, size);
+    }
+
+    uint64_t Position() const
+    {
+        return _position;
+    }
+
+    uint64_t Checksum() const
+    {
+        return _checksum.Final();
+    }
+
+private:
+    void Append(const void* data, std::size_t size)
+    {
+        _stream.write(static_cast<const char*>(data), size);
+        _checksum.Update(data, size);
+        _position += size;
+    }
+
+    std::ofstream& _stream;
+    uint64_t _position;
+    GalleryFileChecksum _checksum;
+};
+
+bool Gallery::Save(const char* path) const
+{
+    if (path == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Null path");
+        return false;
+    }
+
+    const uint64_t size = _size;
+
+    // user id table
+    std::vector<uint64_t> user_id_offsets(size + 1, 0);
+    for (std::size_t i = 0; i < size; i++)
+    {
+        user_id_offsets[i + 1] = user_id_offsets[i] + ::strlen(UserId(i)) + 1;
+    }
+
+    GalleryFileHeader header;
+    ::memset(&header, 0, sizeof(header));
+    header.magic = GalleryFileHeader::Magic;
+    header.format_version = GalleryFileHeader::FormatVersion;
+    header.faceprints_version = _version;
+    header.vector_length = VectorLength;
+    header.descriptor_stride = DescriptorStride;
+    header.code_words = CodeWords;
+    header.faceprints_size = sizeof(Faceprints);
+    header.number_of_users = size;
+    header.descriptors_offset = AlignSection(sizeof(GalleryFileHeader));
+    header.norms_offset = AlignSection(header.descriptors_offset + size * DescriptorStride * sizeof(feature_t));
+    header.valid_offset = AlignSection(header.norms_offset + size * sizeof(uint32_t));
+    header.codes_offset = AlignSection(header.valid_offset + size * sizeof(uint8_t));
+    header.faceprints_offset = AlignSection(header.codes_offset + size * CodeWords * sizeof(uint64_t));
+    header.user_id_offsets_offset = AlignSection(header.faceprints_offset + size * sizeof(Faceprints));
+    header.user_id_blob_offset = AlignSection(header.user_id_offsets_offset + (size + 1) * sizeof(uint64_t));
+
+    // write to a temporary file and rename it over the target, so processes that map the old file are not affected
+    // (truncating a mapped file crashes its readers).
+    const std::string temp_path = std::string(path) + ".tmp";
+    std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        LOG_ERROR(LOG_TAG, "Failed to open %s for writing", temp_path.c_str());
+        return false;
+    }
+
+    // header is rewritten with file size and checksum once all sections are written.
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    GalleryFileWriter writer(stream);
+    writer.Write(header.descriptors_offset, _view.descriptors, size * DescriptorStride * sizeof(feature_t));
+    writer.Write(header.norms_offset, _view.norms, size * sizeof(uint32_t));
+    writer.Write(header.valid_offset, _view.valid, size * sizeof(uint8_t));
+    writer.Write(header.codes_offset, _view.codes, size * CodeWords * sizeof(uint64_t));
+    writer.Write(header.faceprints_offset, _view.faceprints, size * sizeof(Faceprints));
+    writer.Write(header.user_id_offsets_offset, user_id_offsets.data(), user_id_offsets.size() * sizeof(uint64_t));
+    writer.Write(header.user_id_blob_offset, nullptr, 0);
+    for (std::size_t i = 0; i < size; i++)
+    {
+        const char* user_id = UserId(i);
+        writer.Write(writer.Position(), user_id, ::strlen(user_id) + 1);
+    }
+
+    header.file_size = writer.Position();
+    header.checksum = writer.Checksum();
+    stream.seekp(0);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.close();
+
+    if (!stream)
+    {
+        LOG_ERROR(LOG_TAG, "Failed writing gallery file %s", temp_path.c_str());
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    if (!ReplaceGalleryFile(temp_path.c_str(), path))
+    {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    LOG_DEBUG(LOG_TAG, "Saved %zu users to %s", _size, path);
+    return true;
+}
+
+static bool SectionInFile(const GalleryFileHeader& header, uint64_t offset, uint64_t size)
+{
+    return offset % GalleryFileHeader::SectionAlignment == 0 && offset >= sizeof(GalleryFileHeader) &&
+           offset <= header.file_size && size <= header.file_size - offset;
+}
+
+bool Gallery::Map(const char* path, bool verify_checksum)
+{
+    if (path == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Null path");
+        return false;
+    }
+
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(path))
+    {
+        return false;
+    }
+
+    if (file->Size() < sizeof(GalleryFileHeader))
+    {
+        LOG_ERROR(LOG_TAG, "Gallery file %s is too small", path);
+        return false;
+    }
+
+    GalleryFileHeader header;
+    ::memcpy(&header, file->Data(), sizeof(header));
+
+    if (header.magic != GalleryFileHeader::Magic || header.format_version != GalleryFileHeader::FormatVersion)
+    {
+        LOG_ERROR(LOG_TAG, "Bad gallery file header, magic:%x, version:%u", header.magic, header.format_version);
+        return false;
+    }
+
+    if (header.vector_length != VectorLength || header.descriptor_stride != DescriptorStride ||
+        header.code_words != CodeWords || header.faceprints_size != sizeof(Faceprints))
+    {
+        LOG_ERROR(LOG_TAG, "Gallery file layout %u/%u/%u/%u doesn't match %u/%u/%u/%zu", header.vector_length,
+                  header.descriptor_stride, header.code_words, header.faceprints_size, VectorLength, DescriptorStride,
+                  CodeWords, sizeof(Faceprints));
+        return false;
+    }
+
+    const uint64_t size = header.number_of_users;
+    if (header.file_size != file->Size() || size > header.file_size ||
+        !SectionInFile(header, header.descriptors_offset, size * DescriptorStride * sizeof(feature_t)) ||
+        !SectionInFile(header, header.norms_offset, size * sizeof(uint32_t)) ||
+        !SectionInFile(header, header.valid_offset, size * sizeof(uint8_t)) ||
+        !SectionInFile(header, header.codes_offset, size * CodeWords * sizeof(uint64_t)) ||
+        !SectionInFile(header, header.faceprints_offset, size * sizeof(Faceprints)) ||
+        !SectionInFile(header, header.user_id_offsets_offset, (size + 1) * sizeof(uint64_t)) ||
+        !SectionInFile(header, header.user_id_blob_offset, 0))
+    {
+        LOG_ERROR(LOG_TAG, "Gallery file %s is truncated or corrupted", path);
+        return false;
+    }
+
+    const uint8_t* data = file->Data();
+    const uint64_t* user_id_offsets = reinterpret_cast<const uint64_t*>(data + header.user_id_offsets_offset);
+    const uint8_t* user_id_blob = data + header.user_id_blob_offset;
+    const uint64_t blob_size = header.file_size - header.user_id_blob_offset;
+    for (uint64_t i = 0; i < size; i++)
+    {
+        // every user id lies inside the blob and is null terminated before the next one starts.
+        const uint64_t begin = user_id_offsets[i];
+        const uint64_t end = user_id_offsets[i + 1];
+        if (begin >= end || end > blob_size || user_id_blob[end - 1] != '\0')
+        {
+            LOG_ERROR(LOG_TAG, "Gallery file %s has a bad user id table (user %llu)", path,
+                      static_cast<unsigned long long>(i));
+            return false;
+        }
+    }
+
+    if (verify_checksum)
+    {
+        GalleryFileChecksum checksum;
+        checksum.Update(data + sizeof(GalleryFileHeader), header.file_size - sizeof(GalleryFileHeader));
+        if (checksum.Final() != header.checksum)
+        {
+            LOG_ERROR(LOG_TAG, "Gallery file %s checksum mismatch", path);
+            return false;
+        }
+    }
+
+    Clear();
+
+    _version = header.faceprints_version;
+    _size = static_cast<std::size_t>(size);
+    _view.descriptors = reinterpret_cast<const feature_t*>(data + header.descriptors_offset);
+    _view.norms = reinterpret_cast<const uint32_t*>(data + header.norms_offset);
+    _view.valid = data + header.valid_offset;
+    _view.codes = reinterpret_cast<const uint64_t*>(data + header.codes_offset);
+    _view.faceprints = reinterpret_cast<const Faceprints*>(data + header.faceprints_offset);
+    _view.user_id_offsets = user_id_offsets;
+    _view.user_id_blob = reinterpret_cast<const char*>(data + header.user_id_blob_offset);
+    _mapping = std::move(file);
+
+    LOG_DEBUG(LOG_TAG, "Mapped %zu users from %s", _size, path);
+    return true;
+}
+
+void Gallery::SetSearchData(std::size_t index, const Faceprints& faceprints)
+{
+    feature_t* descriptor = &_descriptors[index * DescriptorStride];
+    ::memcpy(descriptor, &faceprints.adaptiveDescriptorWithoutMask[0], VectorLength * sizeof(feature_t));
+
+    _valid[index] = Matcher::ValidateFaceprints(faceprints) ? 1 : 0;
+    _norms[index] = MatcherSimd::ComputeSums(descriptor, descriptor, VectorLength).norm1;
+    MakeCode(descriptor, &_codes[index * CodeWords]);
+}
+
+void Gallery::MakeCode(const feature_t* descriptor, uint64_t code[CodeWords])
+{
+    for (uint32_t w = 0; w < CodeWords; w++)
+    {
+        code[w] = 0;
+    }
+
+    for (uint32_t i = 0; i < VectorLength; i++)
+    {
+        if (descriptor[i] > 0)
+        {
+            code[i / 64] |= (1ULL << (i % 64));
+        }
+    }
+}
+} // namespace RealSenseID
@@ -0,0 +1,176 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "MatcherImplDefines.h"
+#include "AlignedAllocator.h"
+#include "RealSenseID/Faceprints.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace RealSenseID
+{
+class MappedFile;
+
+// Search-optimized gallery (structure-of-arrays) for 1:N matching.
+//
+// Hot tier - touched on every query:
+//   * the search descriptor (adaptiveDescriptorWithoutMask) of each user, in one contiguous 64-byte aligned block.
+//   * the precomputed squared norm of each search descriptor.
+//   * a validated flag per user.
+//   * a 256-bit sign code of each search descriptor, for the popcount prefilter (see TwoStageMatcher).
+// Cold tier - touched only on adaptive update or when the caller asks for it:
+//   * the full faceprints and user id of each user.
+//
+// Range validation and version check are done once at insert, instead of on every query.
+//
+// A gallery can be saved to a file (see GalleryFile.h) and mapped back read-only: mapping is O(1), the search block is
+// scanned in place and its pages are shared by all processes mapping the same file. Modifying a mapped gallery first
+// copies it to memory.
+class Gallery
+{
+public:
+    static constexpr std::size_t Alignment = 64;
+    static constexpr uint32_t VectorLength = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER;
+    // descriptors are padded so each one starts on a cache line.
+    static constexpr uint32_t DescriptorStride =
+        static_cast<uint32_t>((VectorLength * sizeof(feature_t) + Alignment - 1) / Alignment * Alignment /
+                              sizeof(feature_t));
+    // sign code: bit i is set if feature i is positive.
+    static constexpr uint32_t CodeWords = (VectorLength + 63) / 64;
+
+    Gallery() = default;
+    Gallery(const Gallery& other);
+    Gallery(Gallery&& other) noexcept;
+    Gallery& operator=(const Gallery& other);
+    Gallery& operator=(Gallery&& other) noexcept;
+
+    void Reserve(std::size_t number_of_users);
+
+    // add user to the gallery. returns false if the faceprints version doesn't match the gallery version.
+    // faceprints that fail range validation are kept (so indices stay aligned with the caller's db) but are marked
+    // invalid and skipped during search.
+    bool Add(const char* user_id, const Faceprints& faceprints);
+
+    // replace faceprints of existing user (e.g. after adaptive update). returns false on bad index/version.
+    bool Update(std::size_t index, const Faceprints& faceprints);
+
+    // remove user at index. the last user is moved into its place (so indices of other users may change).
+    bool Remove(std::size_t index);
+
+    void Clear();
+
+    // write the gallery to a gallery file.
+    bool Save(const char* path) const;
+
+    // replace the gallery with a read-only mapping of a gallery file. header and section bounds are always checked,
+    // the checksum (which reads the whole file) only if verify_checksum is set.
+    bool Map(const char* path, bool verify_checksum = false);
+
+    bool IsMapped() const
+    {
+        return _mapping != nullptr;
+    }
+
+    std::size_t Size() const
+    {
+        return _size;
+    }
+
+    bool Empty() const
+    {
+        return _size == 0;
+    }
+
+    // faceprints version of the gallery users (version of the first inserted user).
+    int Version() const
+    {
+        return _version;
+    }
+
+    const feature_t* Descriptor(std::size_t index) const
+    {
+        return &_view.descriptors[index * DescriptorStride];
+    }
+
+    uint32_t Norm(std::size_t index) const
+    {
+        return _view.norms[index];
+    }
+
+    bool IsValid(std::size_t index) const
+    {
+        return _view.valid[index] != 0;
+    }
+
+    const uint64_t* Code(std::size_t index) const
+    {
+        return &_view.codes[index * CodeWords];
+    }
+
+    // codes of all users, contiguous.
+    const uint64_t* Codes() const
+    {
+        return _view.codes;
+    }
+
+    // sign code of the given search descriptor.
+    static void MakeCode(const feature_t* descriptor, uint64_t code[CodeWords]);
+
+    const char* UserId(std::size_t index) const
+    {
+        return _mapping ? _view.user_id_blob + _view.user_id_offsets[index] : _user_ids[index].c_str();
+    }
+
+    const Faceprints& GetFaceprints(std::size_t index) const
+    {
+        return _view.faceprints[index];
+    }
+
+    // bytes of the hot tier per user (what a query touches).
+    static constexpr std::size_t SearchBytesPerUser()
+    {
+        return DescriptorStride * sizeof(feature_t) + sizeof(uint32_t) + sizeof(uint8_t);
+    }
+
+private:
+    // read-only pointers to the data of every tier, either into the vectors below or into the mapped file.
+    struct View
+    {
+        const feature_t* descriptors = nullptr;
+        const uint32_t* norms = nullptr;
+        const uint8_t* valid = nullptr;
+        const uint64_t* codes = nullptr;
+        const Faceprints* faceprints = nullptr;
+        const uint64_t* user_id_offsets = nullptr; // mapped only
+        const char* user_id_blob = nullptr;        // mapped only
+    };
+
+    void SetSearchData(std::size_t index, const Faceprints& faceprints);
+
+    // point the view at the vectors (no-op for a mapped gallery).
+    void UpdateView();
+
+    // copy a mapped gallery to memory, before it is modified.
+    void Unmap();
+
+    int _version = 0;
+    std::size_t _size = 0;
+    View _view;
+    std::shared_ptr<const MappedFile> _mapping;
+
+    // hot tier
+    std::vector<feature_t, AlignedAllocator<feature_t, Alignment>> _descriptors;
+    std::vector<uint32_t> _norms;
+    std::vector<uint8_t> _valid;
+    std::vector<uint64_t, AlignedAllocator<uint64_t, Alignment>> _codes;
+
+    // cold tier
+    std::vector<Faceprints> _faceprints;
+    std::vector<std::string> _user_ids;
+};
+} // namespace RealSenseID
@@ -0,0 +1,201 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "GalleryFile.h"
+#include "Logger.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "GalleryFile";
+
+constexpr uint32_t GalleryFileHeader::Magic;
+constexpr uint32_t GalleryFileHeader::FormatVersion;
+constexpr std::size_t GalleryFileHeader::SectionAlignment;
+
+static const uint64_t s_fnvPrime = 1099511628211ULL;
+
+void GalleryFileChecksum::UpdateWord(uint64_t word)
+{
+    _hash = (_hash ^ word) * s_fnvPrime;
+}
+
+void GalleryFileChecksum::Update(const void* data, std::size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    // complete a partial word left from the previous call.
+    while (_tail_size > 0 && size > 0)
+    {
+        _tail |= static_cast<uint64_t>(*bytes++) << (8 * _tail_size);
+        size--;
+        if (++_tail_size == sizeof(uint64_t))
+        {
+            UpdateWord(_tail);
+            _tail = 0;
+            _tail_size = 0;
+        }
+    }
+
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), bytes += sizeof(uint64_t))
+    {
+        uint64_t word;
+        ::memcpy(&word, bytes, sizeof(word));
+        UpdateWord(word);
+    }
+
+    for (; size > 0; size--)
+    {
+        _tail |= static_cast<uint64_t>(*bytes++) << (8 * _tail_size++);
+    }
+}
+
+uint64_t GalleryFileChecksum::Final() const
+{
+    if (_tail_size == 0)
+    {
+        return _hash;
+    }
+    return (_hash ^ _tail) * s_fnvPrime;
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const char* path)
+{
+    Close();
+
+    // share delete, so Gallery::Save() can replace the file while it is mapped.
+    HANDLE file = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR(LOG_TAG, "Failed to open %s, error %lu", path, ::GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        LOG_ERROR(LOG_TAG, "Failed to get size of %s (or file is empty)", path);
+        ::CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Failed to map %s, error %lu", path, ::GetLastError());
+        ::CloseHandle(file);
+        return false;
+    }
+
+    void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Failed to map view of %s, error %lu", path, ::GetLastError());
+        ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        return false;
+    }
+
+    _file = file;
+    _mapping = mapping;
+    _data = static_cast<const uint8_t*>(data);
+    _size = static_cast<std::size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (_data != nullptr)
+    {
+        ::UnmapViewOfFile(_data);
+        ::CloseHandle(_mapping);
+        ::CloseHandle(_file);
+    }
+    _data = nullptr;
+    _size = 0;
+    _file = nullptr;
+    _mapping = nullptr;
+}
+#else
+bool MappedFile::Open(const char* path)
+{
+    Close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        LOG_ERROR(LOG_TAG, "Failed to open %s, error %d", path, errno);
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        LOG_ERROR(LOG_TAG, "Failed to get size of %s (or file is empty)", path);
+        ::close(fd);
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    // the mapping keeps its own reference to the file.
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        LOG_ERROR(LOG_TAG, "Failed to map %s, error %d", path, error);
+        return false;
+    }
+
+    _data = static_cast<const uint8_t*>(data);
+    _size = static_cast<std::size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (_data != nullptr)
+    {
+        ::munmap(const_cast<uint8_t*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+}
+#endif // _WIN32
+
+bool ReplaceGalleryFile(const char* from, const char* to)
+{
+#ifdef _WIN32
+    // rename doesn't replace existing files on windows.
+    if (!::MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING))
+    {
+        LOG_ERROR(LOG_TAG, "Failed to move %s to %s, error %lu", from, to, ::GetLastError());
+        return false;
+    }
+#else
+    if (std::rename(from, to) != 0)
+    {
+        LOG_ERROR(LOG_TAG, "Failed to rename %s to %s, error %d", from, to, errno);
+        return false;
+    }
+#endif // _WIN32
+    return true;
+}
+} // namespace RealSenseID
@@ -0,0 +1,99 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace RealSenseID
+{
+// On-disk gallery file (see Gallery::Save() and Gallery::Map()).
+//
+// Layout (host byte order, every section starts on a SectionAlignment boundary):
+//   header
+//   descriptors    - number_of_users x descriptor_stride feature_t, the search block (scanned in place).
+//   norms          - number_of_users x uint32_t
+//   valid          - number_of_users x uint8_t
+//   codes          - number_of_users x code_words uint64_t
+//   faceprints     - number_of_users x Faceprints (cold tier, for adaptive update)
+//   user id offsets- (number_of_users + 1) x uint64_t, offsets into the user id blob
+//   user id blob   - null terminated user ids
+//
+// The checksum covers everything after the header. Checking it touches the whole file, so it is optional on map.
+struct GalleryFileHeader
+{
+    static constexpr uint32_t Magic = 0x46475352; // "RSGF"
+    static constexpr uint32_t FormatVersion = 1;
+    static constexpr std::size_t SectionAlignment = 64;
+
+    uint32_t magic;
+    uint32_t format_version;
+    int32_t faceprints_version;
+    uint32_t vector_length;
+    uint32_t descriptor_stride;
+    uint32_t code_words;
+    uint32_t faceprints_size; // sizeof(Faceprints), guards against struct layout changes
+    uint32_t reserved;
+    uint64_t number_of_users;
+    uint64_t descriptors_offset;
+    uint64_t norms_offset;
+    uint64_t valid_offset;
+    uint64_t codes_offset;
+    uint64_t faceprints_offset;
+    uint64_t user_id_offsets_offset;
+    uint64_t user_id_blob_offset;
+    uint64_t file_size;
+    uint64_t checksum;
+};
+
+// 64-bit FNV-1a over 8-byte words (bytes of a last partial word are zero padded).
+class GalleryFileChecksum
+{
+public:
+    void Update(const void* data, std::size_t size);
+    uint64_t Final() const;
+
+private:
+    void UpdateWord(uint64_t word);
+
+    uint64_t _hash = 14695981039346656037ULL;
+    uint64_t _tail = 0;
+    std::size_t _tail_size = 0;
+};
+
+// read-only memory mapping of a whole file. pages are loaded on first access and shared between processes.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path);
+    void Close();
+
+    const uint8_t* Data() const
+    {
+        return _data;
+    }
+
+    std::size_t Size() const
+    {
+        return _size;
+    }
+
+private:
+    const uint8_t* _data = nullptr;
+    std::size_t _size = 0;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+};
+
+// move the file at from over the file at to (replaced if it exists). readers that mapped the old file keep it.
+bool ReplaceGalleryFile(const char* from, const char* to);
+} // namespace RealSenseID
@@ -0,0 +1,253 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "GalleryFilter.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "GalleryFilter";
+
+static std::size_t NumberOfWordsFor(std::size_t size)
+{
+    return (size + 63) / 64;
+}
+
+GalleryFilter::GalleryFilter(std::size_t size, bool eligible) :
+    _size(size), _words(NumberOfWordsFor(size), eligible ? ~0ULL : 0ULL)
+{
+    ClearTail();
+}
+
+void GalleryFilter::Resize(std::size_t size)
+{
+    _size = size;
+    _words.resize(NumberOfWordsFor(size), 0);
+    ClearTail();
+}
+
+void GalleryFilter::Set(std::size_t index, bool eligible)
+{
+    if (index >= _size)
+    {
+        return;
+    }
+
+    const uint64_t bit = 1ULL << (index % 64);
+    if (eligible)
+    {
+        _words[index / 64] |= bit;
+    }
+    else
+    {
+        _words[index / 64] &= ~bit;
+    }
+}
+
+bool GalleryFilter::Remove(std::size_t index)
+{
+    if (index >= _size)
+    {
+        LOG_ERROR(LOG_TAG, "Invalid index %zu", index);
+        return false;
+    }
+
+    const std::size_t last = _size - 1;
+    Set(index, Test(last));
+    Resize(last);
+    return true;
+}
+
+std::size_t GalleryFilter::Count() const
+{
+    std::size_t count = 0;
+    for (uint64_t word : _words)
+    {
+        // swar bit count.
+        word = word - ((word >> 1) & 0x5555555555555555ULL);
+        word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+        word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        count += static_cast<std::size_t>((word * 0x0101010101010101ULL) >> 56);
+    }
+    return count;
+}
+
+GalleryFilter& GalleryFilter::operator&=(const GalleryFilter& other)
+{
+    // indices beyond other's size are not eligible there.
+    for (std::size_t w = 0; w < _words.size(); w++)
+    {
+        _words[w] &= (w < other._words.size()) ? other._words[w] : 0;
+    }
+    return *this;
+}
+
+GalleryFilter& GalleryFilter::operator|=(const GalleryFilter& other)
+{
+    const std::size_t words = std::min(_words.size(), other._words.size());
+    for (std::size_t w = 0; w < words; w++)
+    {
+        _words[w] |= other._words[w];
+    }
+    ClearTail();
+    return *this;
+}
+
+GalleryFilter& GalleryFilter::AndNot(const GalleryFilter& other)
+{
+    const std::size_t words = std::min(_words.size(), other._words.size());
+    for (std::size_t w = 0; w < words; w++)
+    {
+        _words[w] &= ~other._words[w];
+    }
+    return *this;
+}
+
+void GalleryFilter::ClearTail()
+{
+    if (_size % 64 != 0)
+    {
+        _words.back() &= (1ULL << (_size % 64)) - 1;
+    }
+}
+
+GalleryFilter operator&(GalleryFilter a, const GalleryFilter& b)
+{
+    a &= b;
+    return a;
+}
+
+GalleryFilter operator|(GalleryFilter a, const GalleryFilter& b)
+{
+    a |= b;
+    return a;
+}
+
+void GalleryFilterCache::Set(const std::string& name, GalleryFilter filter)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _filters[name] = std::make_shared<const GalleryFilter>(std::move(filter));
+
+    for (auto it = _compositions.begin(); it != _compositions.end();)
+    {
+        const auto& names = it->second.names;
+        it = (std::find(names.begin(), names.end(), name) != names.end()) ? _compositions.erase(it) : std::next(it);
+    }
+}
+
+GalleryFilterCache::FilterPtr GalleryFilterCache::Get(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _filters.find(name);
+    return it != _filters.end() ? it->second : nullptr;
+}
+
+GalleryFilterCache::FilterPtr GalleryFilterCache::And(const std::vector<std::string>& names)
+{
+    return Compose('&', names);
+}
+
+GalleryFilterCache::FilterPtr GalleryFilterCache::Or(const std::vector<std::string>& names)
+{
+    return Compose('|', names);
+}
+
+GalleryFilterCache::FilterPtr GalleryFilterCache::Compose(char op, std::vector<std::string> names)
+{
+    if (names.empty())
+    {
+        LOG_ERROR(LOG_TAG, "No filters to compose");
+        return nullptr;
+    }
+
+    // And/Or are commutative - one cache entry for any order of the names.
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    std::string key(1, op);
+    for (const auto& name : names)
+    {
+        key += name;
+        key += '\0';
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto cached = _compositions.find(key);
+    if (cached != _compositions.end())
+    {
+        return cached->second.filter;
+    }
+
+    GalleryFilter result;
+    for (std::size_t i = 0; i < names.size(); i++)
+    {
+        auto it = _filters.find(names[i]);
+        if (it == _filters.end())
+        {
+            LOG_ERROR(LOG_TAG, "Unknown filter %s", names[i].c_str());
+            return nullptr;
+        }
+
+        if (i == 0)
+        {
+            result = *it->second;
+        }
+        else if (op == '&')
+        {
+            result &= *it->second;
+        }
+        else
+        {
+            result.Resize(std::max(result.Size(), it->second->Size()));
+            result |= *it->second;
+        }
+    }
+
+    Composition composition;
+    composition.names = std::move(names);
+    composition.filter = std::make_shared<const GalleryFilter>(std::move(result));
+    FilterPtr filter = composition.filter;
+    _compositions[key] = std::move(composition);
+    return filter;
+}
+
+void GalleryFilterCache::Resize(std::size_t size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& entry : _filters)
+    {
+        // filters are shared with running queries - modify a copy.
+        GalleryFilter filter = *entry.second;
+        filter.Resize(size);
+        entry.second = std::make_shared<const GalleryFilter>(std::move(filter));
+    }
+    _compositions.clear();
+}
+
+bool GalleryFilterCache::Remove(std::size_t index)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    bool ok = true;
+    for (auto& entry : _filters)
+    {
+        GalleryFilter filter = *entry.second;
+        ok = filter.Remove(index) && ok;
+        entry.second = std::make_shared<const GalleryFilter>(std::move(filter));
+    }
+    _compositions.clear();
+    return ok;
+}
+
+void GalleryFilterCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _filters.clear();
+    _compositions.clear();
+}
+
+std::size_t GalleryFilterCache::NumberOfCompositions() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _compositions.size();
+}
+} // namespace RealSenseID
@@ -0,0 +1,172 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace RealSenseID
+{
+// Set of eligible gallery indices (e.g. the users a door admits), as a bitmap of 64-user words.
+//
+// A filtered search (Matcher::MatchFaceprintsToGallery() with a filter) visits only the set bits: a zero word skips 64
+// users without touching their search data, so the cost follows the number of eligible users rather than the gallery
+// size. Filters compose with And/Or/AndNot word by word.
+//
+// Indices follow the gallery: call Resize() after Gallery::Add (new users are not eligible until set) and Remove()
+// after Gallery::Remove (which moves the last user into the removed index). Indices beyond Size() are not eligible.
+class GalleryFilter
+{
+public:
+    GalleryFilter() = default;
+
+    // filter of size users, all eligible or none.
+    explicit GalleryFilter(std::size_t size, bool eligible = false);
+
+    std::size_t Size() const
+    {
+        return _size;
+    }
+
+    // new indices are not eligible.
+    void Resize(std::size_t size);
+
+    void Set(std::size_t index, bool eligible = true);
+
+    bool Test(std::size_t index) const
+    {
+        return index < _size && (_words[index / 64] >> (index % 64)) & 1;
+    }
+
+    // same move as Gallery::Remove(): the last index takes the removed index and the filter shrinks by one.
+    bool Remove(std::size_t index);
+
+    // number of eligible users.
+    std::size_t Count() const;
+
+    GalleryFilter& operator&=(const GalleryFilter& other);
+    GalleryFilter& operator|=(const GalleryFilter& other);
+
+    // remove the users of other.
+    GalleryFilter& AndNot(const GalleryFilter& other);
+
+    // visit(index) for every eligible index below limit, in increasing order. words without eligible users are
+    // skipped. visit returns false to stop.
+    template <typename Visit>
+    void ForEach(std::size_t limit, Visit visit) const
+    {
+        limit = (limit < _size) ? limit : _size;
+        const std::size_t words = (limit + 63) / 64;
+        for (std::size_t w = 0; w < words; w++)
+        {
+            uint64_t word = _words[w];
+            if (w == words - 1 && limit % 64 != 0)
+            {
+                word &= (1ULL << (limit % 64)) - 1;
+            }
+
+            while (word != 0)
+            {
+                if (!visit(w * 64 + LowestBit(word)))
+                {
+                    return;
+                }
+                word &= word - 1;
+            }
+        }
+    }
+
+    const uint64_t* Words() const
+    {
+        return _words.data();
+    }
+
+    std::size_t NumberOfWords() const
+    {
+        return _words.size();
+    }
+
+    // index of the lowest set bit of a non-zero word.
+    static inline uint32_t LowestBit(uint64_t word)
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return static_cast<uint32_t>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+        return static_cast<uint32_t>(__builtin_ctzll(word));
+#else
+        uint32_t index = 0;
+        while ((word & 1) == 0)
+        {
+            word >>= 1;
+            index++;
+        }
+        return index;
+#endif
+    }
+
+private:
+    // clear the bits beyond _size in the last word.
+    void ClearTail();
+
+    std::size_t _size = 0;
+    std::vector<uint64_t> _words;
+};
+
+GalleryFilter operator&(GalleryFilter a, const GalleryFilter& b);
+GalleryFilter operator|(GalleryFilter a, const GalleryFilter& b);
+
+// Named filters (e.g. "site:north", "door:lab", "window:night") and their compositions, cached between queries.
+//
+// And()/Or() of a list of names are computed once and kept until one of their filters is replaced, so a door's
+// filter is composed on its first query only. Filters are returned as shared immutable objects: a query keeps using
+// the filter it got even if the cache is updated meanwhile. Thread safe.
+class GalleryFilterCache
+{
+public:
+    using FilterPtr = std::shared_ptr<const GalleryFilter>;
+
+    // add or replace a named filter (drops the cached compositions that use it).
+    void Set(const std::string& name, GalleryFilter filter);
+
+    // nullptr if there is no such filter.
+    FilterPtr Get(const std::string& name) const;
+
+    // users in all / any of the named filters. nullptr if a name is unknown.
+    FilterPtr And(const std::vector<std::string>& names);
+    FilterPtr Or(const std::vector<std::string>& names);
+
+    // apply Gallery::Add/Remove to all filters (see GalleryFilter::Resize/Remove). compositions are recomputed.
+    void Resize(std::size_t size);
+    bool Remove(std::size_t index);
+
+    void Clear();
+
+    // number of cached compositions.
+    std::size_t NumberOfCompositions() const;
+
+private:
+    struct Composition
+    {
+        std::vector<std::string> names;
+        FilterPtr filter;
+    };
+
+    FilterPtr Compose(char op, std::vector<std::string> names);
+
+    mutable std::mutex _mutex;
+    std::unordered_map<std::string, FilterPtr> _filters;
+    std::unordered_map<std::string, Composition> _compositions; // key: operator + sorted names
+};
+} // namespace RealSenseID
@@ -0,0 +1,199 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "HitOrderIndex.h"
+#include "Gallery.h"
+#include "MatcherSimd.h"
+#include "Logger.h"
+#include <algorithm>
+#include <numeric>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "HitOrderIndex";
+
+HitOrderIndex::HitOrderIndex(const Config& config) : _config(config)
+{
+}
+
+void HitOrderIndex::Build(const Gallery& gallery)
+{
+    const std::size_t size = gallery.Size();
+    _order.resize(size);
+    std::iota(_order.begin(), _order.end(), 0);
+    _hits.assign(size, 0);
+    _recent.clear();
+    _in_recent.assign(size, 0);
+    _queries_since_reorder = 0;
+}
+
+bool HitOrderIndex::Update(const Gallery& gallery, std::size_t index)
+{
+    const std::size_t size = gallery.Size();
+    const std::size_t current = _hits.size();
+
+    if (size == current)
+    {
+        // faceprints replaced - the user keeps its place and hits.
+        return index < size;
+    }
+
+    if (size == current + 1 && index == current)
+    {
+        // added user - scanned last until it gets hits.
+        _order.push_back(static_cast<uint32_t>(index));
+        _hits.push_back(0);
+        _in_recent.push_back(0);
+        return true;
+    }
+
+    if (size + 1 == current && index <= size)
+    {
+        // removed user - the former last user (index size) now lives at index.
+        const uint32_t removed = static_cast<uint32_t>(index);
+        const uint32_t moved = static_cast<uint32_t>(size);
+
+        RemoveFromRecent(removed);
+        _order.erase(std::find(_order.begin(), _order.end(), removed));
+        if (moved != removed)
+        {
+            std::replace(_order.begin(), _order.end(), moved, removed);
+            std::replace(_recent.begin(), _recent.end(), moved, removed);
+            _hits[removed] = _hits[moved];
+            _in_recent[removed] = _in_recent[moved];
+        }
+        _hits.pop_back();
+        _in_recent.pop_back();
+        return true;
+    }
+
+    LOG_ERROR(LOG_TAG, "Index is not in sync with the gallery (%zu vs %zu users), rebuilding", current, size);
+    Build(gallery);
+    return false;
+}
+
+TagResult HitOrderIndex::Search(const Gallery& gallery, const feature_t* query, match_calc_t threshold,
+                                MatchSearchMode mode)
+{
+    TagResult best;
+    best.score = 0;
+    best.id = -1;
+
+    if (Size() != gallery.Size())
+    {
+        LOG_ERROR(LOG_TAG, "Index is not in sync with the gallery (%zu vs %zu users)", Size(), gallery.Size());
+        return best;
+    }
+
+    const uint32_t vec_length = Gallery::VectorLength;
+    const uint32_t query_norm = MatcherSimd::ComputeSums(query, query, vec_length).norm1;
+    const bool early_exit = (mode == MatchSearchMode::FirstAboveThreshold);
+    uint64_t comparisons = 0;
+
+    // scores the user, returns true when the scan can stop.
+    auto score_user = [&](uint32_t index) {
+        comparisons++;
+        int32_t corr = MatcherSimd::DotProduct(query, gallery.Descriptor(index), vec_length);
+        match_calc_t score = Matcher::NormalizeScore(corr, query_norm, gallery.Norm(index));
+        if (score > best.score)
+        {
+            best.score = score;
+            best.id = static_cast<int>(index);
+        }
+        return early_exit && score > threshold;
+    };
+
+    bool done = false;
+    for (std::size_t r = 0; r < _recent.size() && !done; r++)
+    {
+        done = gallery.IsValid(_recent[r]) && score_user(_recent[r]);
+    }
+    if (done)
+    {
+        _stats.recent_hits++;
+    }
+
+    // recent users were scored above.
+    for (std::size_t k = 0; k < _order.size() && !done; k++)
+    {
+        const uint32_t index = _order[k];
+        if (_in_recent[index] || !gallery.IsValid(index))
+        {
+            continue;
+        }
+        done = score_user(index);
+    }
+
+    _stats.queries++;
+    _stats.comparisons += comparisons;
+    if (best.score > threshold)
+    {
+        _stats.matches++;
+        RecordHit(static_cast<uint32_t>(best.id));
+    }
+
+    if (_config.reorder_interval > 0 && ++_queries_since_reorder >= _config.reorder_interval)
+    {
+        Reorder();
+    }
+
+    return best;
+}
+
+ExtendedMatchResult HitOrderIndex::Match(const Faceprints& new_faceprints, const Gallery& gallery,
+                                         Faceprints& updated_faceprints, const Thresholds& thresholds,
+                                         MatchSearchMode mode)
+{
+    if (!Matcher::ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return ExtendedMatchResult();
+    }
+
+    TagResult best =
+        Search(gallery, &new_faceprints.adaptiveDescriptorWithoutMask[0], thresholds.strongThreshold_pNMgNM, mode);
+
+    return Matcher::FinalizeGalleryMatch(new_faceprints, gallery, best, updated_faceprints, thresholds);
+}
+
+void HitOrderIndex::Reorder()
+{
+    // stable - users with equal counts keep their relative order (new and never matched users stay last).
+    std::stable_sort(_order.begin(), _order.end(), [this](uint32_t a, uint32_t b) { return _hits[a] > _hits[b]; });
+    for (auto& hits : _hits)
+    {
+        hits >>= 1;
+    }
+
+    _queries_since_reorder = 0;
+    _stats.reorders++;
+}
+
+void HitOrderIndex::RecordHit(uint32_t index)
+{
+    _hits[index]++;
+
+    if (_config.recent_size == 0)
+    {
+        return;
+    }
+
+    RemoveFromRecent(index);
+    if (_recent.size() == _config.recent_size)
+    {
+        _in_recent[_recent.back()] = 0;
+        _recent.pop_back();
+    }
+    _recent.insert(_recent.begin(), index);
+    _in_recent[index] = 1;
+}
+
+void HitOrderIndex::RemoveFromRecent(uint32_t index)
+{
+    auto it = std::find(_recent.begin(), _recent.end(), index);
+    if (it != _recent.end())
+    {
+        _recent.erase(it);
+        _in_recent[index] = 0;
+    }
+}
+} // namespace RealSenseID
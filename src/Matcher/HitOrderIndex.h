@@ -0,0 +1,112 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RealSenseID
+{
+class Gallery;
+
+// Gallery scan in adaptive order, for MatchSearchMode::FirstAboveThreshold searches where a few users produce most of
+// the authentications.
+//
+// The first-above-threshold scan stops at the matched user, so its cost is the matched user's position in the scan.
+// The index counts the matches of every user and every reorder_interval queries re-sorts the scan order by hit count
+// (counts are halved after each reorder, so the order follows the recent traffic). Before the ordered scan it probes
+// the last recent_size matched users - the same person often retries within seconds (e.g. AuthenticateLoop).
+//
+// Scores are the exact gallery scores. The index doesn't copy search data, it holds the scan order and hit counters
+// aligned with gallery indices. Since users are scanned in a different order, with FirstAboveThreshold a query that
+// exceeds the threshold for more than one user may return another one of them than the sequential scan, and equal
+// best scores are resolved by scan order.
+//
+// Search() and Match() update the counters, so calls must be serialized by the caller.
+class HitOrderIndex
+{
+public:
+    struct Config
+    {
+        std::size_t recent_size = 8;         // recently matched users probed first (0 disables the probe)
+        std::size_t reorder_interval = 1024; // queries between reorders (0 disables reordering)
+    };
+
+    struct Stats
+    {
+        uint64_t queries = 0;
+        uint64_t comparisons = 0; // users scored, including the recent probe
+        uint64_t matches = 0;     // queries above threshold
+        uint64_t recent_hits = 0; // matches found by the recent probe
+        uint64_t reorders = 0;
+
+        double AverageComparisons() const
+        {
+            return queries > 0 ? static_cast<double>(comparisons) / queries : 0.0;
+        }
+    };
+
+    HitOrderIndex() = default;
+    explicit HitOrderIndex(const Config& config);
+
+    // scan order = gallery order, counters and recent users cleared.
+    void Build(const Gallery& gallery);
+
+    // sync with the gallery after Gallery::Add (index of the new user), Gallery::Update or Gallery::Remove (index of
+    // the removed user - the gallery moved its last user there). the change is told apart by the gallery size.
+    bool Update(const Gallery& gallery, std::size_t index);
+
+    std::size_t Size() const
+    {
+        return _hits.size();
+    }
+
+    // best user in the current scan order. result.id is the gallery index (-1 if no user scored above 0).
+    // a result above threshold counts as a hit of that user. returns no user if the index is not in sync with the
+    // gallery (see Update()).
+    TagResult Search(const Gallery& gallery, const feature_t* query, match_calc_t threshold,
+                     MatchSearchMode mode = MatchSearchMode::FirstAboveThreshold);
+
+    // same as Matcher::MatchFaceprintsToGallery() on the index's scan order. the index must be in sync with the
+    // gallery.
+    ExtendedMatchResult Match(const Faceprints& new_faceprints, const Gallery& gallery, Faceprints& updated_faceprints,
+                              const Thresholds& thresholds,
+                              MatchSearchMode mode = MatchSearchMode::FirstAboveThreshold);
+
+    // re-sort the scan order by hit count now (Search() does it every reorder_interval queries).
+    void Reorder();
+
+    // gallery indices in scan order.
+    const std::vector<uint32_t>& Order() const
+    {
+        return _order;
+    }
+
+    const Stats& GetStats() const
+    {
+        return _stats;
+    }
+
+    void ResetStats()
+    {
+        _stats = Stats();
+    }
+
+private:
+    void RecordHit(uint32_t index);
+
+    void RemoveFromRecent(uint32_t index);
+
+    Config _config;
+    Stats _stats;
+    std::size_t _queries_since_reorder = 0;
+
+    std::vector<uint32_t> _order;    // scan order
+    std::vector<uint32_t> _hits;     // per gallery index
+    std::vector<uint32_t> _recent;   // most recent first
+    std::vector<uint8_t> _in_recent; // per gallery index - skipped by the ordered scan
+};
+} // namespace RealSenseID
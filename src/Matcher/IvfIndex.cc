@@ -0,0 +1,342 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "IvfIndex.h"
+#include "Gallery.h"
+#include "MatcherSimd.h"
+#include "TopKCandidates.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <random>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "IvfIndex";
+
+constexpr uint32_t IvfIndex::VectorLength;
+
+// k-means uses at most this many samples per list (more samples hardly change the centroids).
+static const std::size_t s_maxTrainSamplesPerList = 64;
+
+static void ToUnitVector(const feature_t* descriptor, float* out)
+{
+    double norm = 0;
+    for (uint32_t i = 0; i < IvfIndex::VectorLength; i++)
+    {
+        out[i] = static_cast<float>(descriptor[i]);
+        norm += static_cast<double>(out[i]) * out[i];
+    }
+
+    float scale = norm > 0 ? static_cast<float>(1.0 / std::sqrt(norm)) : 0.0f;
+    for (uint32_t i = 0; i < IvfIndex::VectorLength; i++)
+    {
+        out[i] *= scale;
+    }
+}
+
+static void Normalize(float* v)
+{
+    double norm = 0;
+    for (uint32_t i = 0; i < IvfIndex::VectorLength; i++)
+    {
+        norm += static_cast<double>(v[i]) * v[i];
+    }
+
+    float scale = norm > 0 ? static_cast<float>(1.0 / std::sqrt(norm)) : 0.0f;
+    for (uint32_t i = 0; i < IvfIndex::VectorLength; i++)
+    {
+        v[i] *= scale;
+    }
+}
+
+static float Dot(const float* a, const float* b)
+{
+    float sum = 0;
+    for (uint32_t i = 0; i < IvfIndex::VectorLength; i++)
+    {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+bool IvfIndex::Train(const std::vector<const feature_t*>& samples, std::size_t number_of_lists,
+                     std::size_t iterations, uint32_t seed)
+{
+    Clear();
+    _centroids.clear();
+    _lists.clear();
+
+    if (samples.empty() || number_of_lists == 0)
+    {
+        LOG_ERROR(LOG_TAG, "Cannot train without samples or lists");
+        return false;
+    }
+
+    const std::size_t dim = VectorLength;
+    const std::size_t nlist = std::min(number_of_lists, samples.size());
+    std::mt19937 rng(seed);
+
+    // init centroids from distinct random samples.
+    std::vector<std::size_t> order(samples.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<float> centroids(nlist * dim);
+    for (std::size_t c = 0; c < nlist; c++)
+    {
+        ToUnitVector(samples[order[c]], &centroids[c * dim]);
+    }
+
+    std::vector<float> sums(nlist * dim);
+    std::vector<std::size_t> counts(nlist);
+    std::vector<float> unit(dim);
+
+    for (std::size_t iter = 0; iter < iterations; iter++)
+    {
+        std::fill(sums.begin(), sums.end(), 0.0f);
+        std::fill(counts.begin(), counts.end(), 0);
+
+        for (const feature_t* sample : samples)
+        {
+            ToUnitVector(sample, unit.data());
+
+            std::size_t best = 0;
+            float best_dot = Dot(unit.data(), &centroids[0]);
+            for (std::size_t c = 1; c < nlist; c++)
+            {
+                float dot = Dot(unit.data(), &centroids[c * dim]);
+                if (dot > best_dot)
+                {
+                    best_dot = dot;
+                    best = c;
+                }
+            }
+
+            float* sum = &sums[best * dim];
+            for (std::size_t i = 0; i < dim; i++)
+            {
+                sum[i] += unit[i];
+            }
+            counts[best]++;
+        }
+
+        std::uniform_int_distribution<std::size_t> pick(0, samples.size() - 1);
+        for (std::size_t c = 0; c < nlist; c++)
+        {
+            if (counts[c] == 0)
+            {
+                // re-seed empty list with a random sample.
+                ToUnitVector(samples[pick(rng)], &centroids[c * dim]);
+                continue;
+            }
+            std::copy_n(&sums[c * dim], dim, &centroids[c * dim]);
+            Normalize(&centroids[c * dim]);
+        }
+    }
+
+    _centroids = std::move(centroids);
+    _lists.resize(nlist);
+
+    LOG_DEBUG(LOG_TAG, "Trained %zu lists on %zu samples", nlist, samples.size());
+    return true;
+}
+
+bool IvfIndex::Train(const Gallery& gallery, std::size_t number_of_lists, std::size_t max_samples,
+                     std::size_t iterations, uint32_t seed)
+{
+    std::vector<const feature_t*> samples;
+    samples.reserve(gallery.Size());
+    for (std::size_t i = 0; i < gallery.Size(); i++)
+    {
+        if (gallery.IsValid(i))
+        {
+            samples.push_back(gallery.Descriptor(i));
+        }
+    }
+
+    max_samples = std::min(max_samples, number_of_lists * s_maxTrainSamplesPerList);
+    if (samples.size() > max_samples)
+    {
+        std::mt19937 rng(seed);
+        std::shuffle(samples.begin(), samples.end(), rng);
+        samples.resize(max_samples);
+    }
+
+    return Train(samples, number_of_lists, iterations, seed);
+}
+
+std::vector<uint32_t> IvfIndex::ClosestLists(const feature_t* descriptor, std::size_t count) const
+{
+    const std::size_t nlist = _lists.size();
+    count = std::min(count, nlist);
+
+    std::vector<float> unit(VectorLength);
+    ToUnitVector(descriptor, unit.data());
+
+    std::vector<float> dots(nlist);
+    for (std::size_t c = 0; c < nlist; c++)
+    {
+        dots[c] = Dot(unit.data(), &_centroids[c * VectorLength]);
+    }
+
+    std::vector<uint32_t> lists(nlist);
+    std::iota(lists.begin(), lists.end(), 0);
+    std::partial_sort(lists.begin(), lists.begin() + count, lists.end(),
+                      [&dots](uint32_t a, uint32_t b) { return dots[a] > dots[b]; });
+    lists.resize(count);
+    return lists;
+}
+
+bool IvfIndex::Add(int id, const feature_t* descriptor, int version)
+{
+    if (!IsTrained())
+    {
+        LOG_ERROR(LOG_TAG, "Index is not trained");
+        return false;
+    }
+
+    if (descriptor == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Null pointer detected : Skipping function.");
+        return false;
+    }
+
+    if (Size() == 0)
+    {
+        _version = version;
+    }
+    else if (version != _version)
+    {
+        LOG_ERROR(LOG_TAG, "Faceprints version %d doesn't match index version %d", version, _version);
+        return false;
+    }
+
+    Remove(id);
+
+    uint32_t list_index = ClosestLists(descriptor, 1)[0];
+    InvertedList& list = _lists[list_index];
+
+    std::size_t position = list.ids.size();
+    list.vectors.resize((position + 1) * VectorLength);
+    ::memcpy(&list.vectors[position * VectorLength], descriptor, VectorLength * sizeof(feature_t));
+    list.norms.push_back(MatcherSimd::ComputeSums(descriptor, descriptor, VectorLength).norm1);
+    list.ids.push_back(id);
+
+    Location location;
+    location.list = list_index;
+    location.position = static_cast<uint32_t>(position);
+    _locations[id] = location;
+    return true;
+}
+
+bool IvfIndex::AddGallery(const Gallery& gallery)
+{
+    for (std::size_t i = 0; i < gallery.Size(); i++)
+    {
+        if (gallery.IsValid(i) && !Add(static_cast<int>(i), gallery.Descriptor(i), gallery.Version()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IvfIndex::Remove(int id)
+{
+    auto it = _locations.find(id);
+    if (it == _locations.end())
+    {
+        return false;
+    }
+
+    InvertedList& list = _lists[it->second.list];
+    const std::size_t position = it->second.position;
+    const std::size_t last = list.ids.size() - 1;
+
+    // move last entry of the list into the removed slot.
+    if (position != last)
+    {
+        std::copy_n(&list.vectors[last * VectorLength], VectorLength, &list.vectors[position * VectorLength]);
+        list.norms[position] = list.norms[last];
+        list.ids[position] = list.ids[last];
+        _locations[list.ids[position]].position = static_cast<uint32_t>(position);
+    }
+
+    list.vectors.resize(last * VectorLength);
+    list.norms.pop_back();
+    list.ids.pop_back();
+    _locations.erase(id);
+    return true;
+}
+
+void IvfIndex::Clear()
+{
+    for (auto& list : _lists)
+    {
+        list.vectors.clear();
+        list.norms.clear();
+        list.ids.clear();
+    }
+    _locations.clear();
+    _version = 0;
+}
+
+std::vector<MatchCandidate> IvfIndex::Search(const Faceprints& new_faceprints, std::size_t k, std::size_t nprobe,
+                                             const Thresholds& thresholds) const
+{
+    std::size_t number_of_compares = 0;
+    return Search(new_faceprints, k, nprobe, thresholds, number_of_compares);
+}
+
+std::vector<MatchCandidate> IvfIndex::Search(const Faceprints& new_faceprints, std::size_t k, std::size_t nprobe,
+                                             const Thresholds& thresholds, std::size_t& number_of_compares) const
+{
+    number_of_compares = 0;
+    std::vector<MatchCandidate> candidates;
+
+    if (!IsTrained() || k == 0)
+    {
+        return candidates;
+    }
+
+    if (!Matcher::ValidateFaceprints(new_faceprints))
+    {
+        LOG_ERROR(LOG_TAG, "Faceprints vector failed range validation.");
+        return candidates;
+    }
+
+    if (Size() > 0 && new_faceprints.version != _version)
+    {
+        LOG_ERROR(LOG_TAG, "Faceprints version %d doesn't match index version %d", new_faceprints.version, _version);
+        return candidates;
+    }
+
+    const feature_t* queryFea = &new_faceprints.adaptiveDescriptorWithoutMask[0];
+    const uint32_t queryNorm = MatcherSimd::ComputeSums(queryFea, queryFea, VectorLength).norm1;
+
+    TopKCandidates topk(std::min(k, Size()));
+    for (uint32_t list_index : ClosestLists(queryFea, std::max<std::size_t>(nprobe, 1)))
+    {
+        const InvertedList& list = _lists[list_index];
+        for (std::size_t i = 0; i < list.ids.size(); i++)
+        {
+            int32_t corr = MatcherSimd::DotProduct(queryFea, &list.vectors[i * VectorLength], VectorLength);
+            topk.Push(list.ids[i], Matcher::NormalizeScore(corr, queryNorm, list.norms[i]));
+        }
+        number_of_compares += list.ids.size();
+    }
+
+    candidates = topk.Sorted();
+
+    ExtendedMatchResult unused;
+    for (auto& candidate : candidates)
+    {
+        candidate.confidence = Matcher::CalculateConfidence(candidate.score, thresholds.strongThreshold_pNMgNM, unused);
+    }
+
+    return candidates;
+}
+} // namespace RealSenseID
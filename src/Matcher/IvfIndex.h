@@ -0,0 +1,106 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include "AlignedAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace RealSenseID
+{
+class Gallery;
+
+// Inverted-file (IVF) approximate nearest neighbour index over faceprints search descriptors, for galleries that are
+// too large for an exhaustive scan.
+//
+// Descriptors are clustered by spherical k-means (ncc is a cosine similarity) into inverted lists. A query scans only
+// the nprobe lists whose centroids are closest to it, and every candidate in these lists is scored with the exact
+// integer ncc (identical to Matcher::MatchTwoVectors), so thresholds and confidence keep their meaning.
+// The index keeps its own copy of the descriptors so each list is scanned contiguously.
+//
+// Users can be added and removed at any time after training. Ids are chosen by the caller (e.g. gallery index).
+class IvfIndex
+{
+public:
+    static constexpr uint32_t VectorLength = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER;
+
+    IvfIndex() = default;
+
+    // train the coarse quantizer with spherical k-means over the given descriptors.
+    // clears the index (users must be added after training).
+    bool Train(const std::vector<const feature_t*>& samples, std::size_t number_of_lists, std::size_t iterations = 10,
+               uint32_t seed = 0);
+
+    // train on (a sample of at most max_samples) valid gallery users.
+    bool Train(const Gallery& gallery, std::size_t number_of_lists, std::size_t max_samples = 100000,
+               std::size_t iterations = 10, uint32_t seed = 0);
+
+    bool IsTrained() const
+    {
+        return !_lists.empty();
+    }
+
+    // add descriptor under the given id (replaces existing descriptor with the same id).
+    // version is the faceprints version of the descriptor: the first added user sets the index version, users of
+    // other versions are rejected (as are queries of other versions).
+    bool Add(int id, const feature_t* descriptor, int version);
+
+    // add all valid gallery users, with gallery index as id.
+    bool AddGallery(const Gallery& gallery);
+
+    bool Remove(int id);
+
+    void Clear();
+
+    std::size_t Size() const
+    {
+        return _locations.size();
+    }
+
+    std::size_t NumberOfLists() const
+    {
+        return _lists.size();
+    }
+
+    // faceprints version of the indexed users.
+    int Version() const
+    {
+        return _version;
+    }
+
+    // K best candidates (sorted by descending exact score) among the users of the nprobe closest lists.
+    // candidate userId is the id given to Add().
+    std::vector<MatchCandidate> Search(const Faceprints& new_faceprints, std::size_t k, std::size_t nprobe,
+                                       const Thresholds& thresholds) const;
+
+    // same as above, also returns the number of exact comparisons made.
+    std::vector<MatchCandidate> Search(const Faceprints& new_faceprints, std::size_t k, std::size_t nprobe,
+                                       const Thresholds& thresholds, std::size_t& number_of_compares) const;
+
+private:
+    struct InvertedList
+    {
+        std::vector<feature_t, AlignedAllocator<feature_t, 64>> vectors;
+        std::vector<uint32_t> norms;
+        std::vector<int> ids;
+    };
+
+    struct Location
+    {
+        uint32_t list;
+        uint32_t position;
+    };
+
+    // index of the closest centroid(s) to the descriptor, closest first.
+    std::vector<uint32_t> ClosestLists(const feature_t* descriptor, std::size_t count) const;
+
+    std::vector<float> _centroids; // number_of_lists x VectorLength, unit length.
+    std::vector<InvertedList> _lists;
+    std::unordered_map<int, Location> _locations;
+    int _version = 0;
+};
+} // namespace RealSenseID
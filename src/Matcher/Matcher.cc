@@ -5,6 +5,11 @@
 #include "Logger.h"
 #include "RealSenseID/Faceprints.h"
 #include "ExtendedFaceprints.h"
+#include "MatcherSimd.h"
+#include "MatcherKernels.h"
+#include "Gallery.h"
+#include "GalleryFilter.h"
+#include "TopKCandidates.h"
 #include <cmath>
 #include <assert.h>
 #include <cstring>
@@ -15,9 +20,10 @@
 
 /*
 RSID-MATCHER INFO: Functions implementation here in Matcher.cc uses integer arithmetic and tailored to integer-valued
-feature-vectors with: (1) length 256 (2) integer valued features in range [-1023,+1023]. Adjustments and checks will be
-taken if (1) vectors length becomes more than 256 (2) features value range becomes wider than [-1023,+1023].
-RSID-MARCHER INFO: Such adjustments/checks may be required due to accumulators and bit shifts used.
+feature-vectors with integer valued features in range [-1023,+1023]. Adjustments and checks will be taken if features
+value range becomes wider than [-1023,+1023].
+RSID-MARCHER INFO: Vectors up to MatcherKernels::MaxLength<int32_t>() features (2052) are accumulated in 32 bit (SIMD
+kernels), longer vectors in 64 bit (see MatcherKernels.h).
 */
 
 namespace RealSenseID
@@ -28,6 +34,7 @@ static const char* LOG_TAG = "Matcher";
 
 static const match_calc_t s_maxFeatureValue = static_cast<match_calc_t>(RSID_MAX_FEATURE_VALUE);
 static const match_calc_t s_minPossibleScore = static_cast<match_calc_t>(RSID_MIN_POSSIBLE_SCORE);
+static const uint32_t s_maxNormForShifts = 1u << 28;
 
 static const match_calc_t s_identicalThreshold_M = static_cast<match_calc_t>(RSID_IDENTICAL_THRESHOLD_M);
 static const match_calc_t s_identicalThreshold_NM = static_cast<match_calc_t>(RSID_IDENTICAL_THRESHOLD_NM);
@@ -169,11 +176,6 @@ static void SetToDefaultThresholds(Thresholds& thresholds)
 
 bool Matcher::ValidateFaceprints(const Faceprints& faceprints, bool check_enrollment_vector)
 {
-    // TODO - carefull handling in MatchTwoVectors() may be required for vectors longer than 256.
-    static_assert((RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER <= 256),
-                  "Vector length is higher than 256 - may need careful test and check, due to integer arithmetics and "
-                  "overflow risk!");
-
     static_assert((static_cast<int>(RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER) == NUM_OF_RECOGNITION_FEATURES),
                   "Faceprints feature vector length mismatch - please check!");
 
@@ -335,102 +337,479 @@ ExtendedMatchResult Matcher::MatchFaceprintsToArray(const Faceprints& new_facepr
     return result;
 }
 
-bool Matcher::UpdateAverageVector(feature_t* updated_faceprints_vec, const feature_t* orig_faceprints_vec, 
-                                    const Thresholds& thresholds, const uint32_t vec_length)                             
+bool Matcher::GetScores(const Faceprints& new_faceprints, const Gallery& gallery, TagResult& result,
+                        match_calc_t threshold, const GalleryFilter* filter)
 {
-    
-    // TODO yossidan - handle with/without mask vectors properly (as needed).
+    // initialize.
+    result.score = 0;
+    result.id = -1;
 
-    if((nullptr == orig_faceprints_vec) || (nullptr == updated_faceprints_vec))
+    if (gallery.Empty())
     {
-        LOG_ERROR(LOG_TAG, "Null pointer detected : Skipping function.");
         return false;
     }
-    // Explain - as long as the avg vector is "too far" from the orig vector, we
-    // want to update the avg vector with more samples of the orig vector.
-    // hence refreshing the avg to be more similar to the orig vector.
-   
-    match_calc_t match_score = 0;
-    MatchTwoVectors(updated_faceprints_vec, orig_faceprints_vec, &match_score, vec_length);
 
-    // adding limit on number of iterations, e.g. if one vector is all zeros we'll get 
-    // deadlock here.
-    uint32_t cnt_iter = 0;
-    while ((match_score < thresholds.identicalThreshold_NM))
+    const feature_t* queryFea = &new_faceprints.adaptiveDescriptorWithoutMask[0];
+    const uint32_t vec_length = Gallery::VectorLength;
+
+    // the query norm is calculated once, gallery norms were calculated at insert.
+    const uint32_t queryNorm = MatcherSimd::ComputeSums(queryFea, queryFea, vec_length).norm1;
+
+    match_calc_t maxScore = s_minPossibleScore;
+    int maxSubject = -1;
+
+    // scores the subject, returns false when the scan can stop.
+    auto scoreSubject = [&](size_t subjectIndex) {
+        // invalid vectors were reported at insert.
+        if (!gallery.IsValid(subjectIndex))
+        {
+            return true;
+        }
+
+        int32_t corr = MatcherSimd::DotProduct(queryFea, gallery.Descriptor(subjectIndex), vec_length);
+        match_calc_t adaptedScore = NormalizeScore(corr, queryNorm, gallery.Norm(subjectIndex));
+
+        if (adaptedScore > maxScore)
+        {
+            maxScore = adaptedScore;
+            maxSubject = static_cast<int>(subjectIndex);
+        }
+
+        return adaptedScore <= threshold;
+    };
+
+    if (filter != nullptr)
     {
-        LOG_DEBUG(LOG_TAG, "----> Avg vector is far from orig vector. Doing update while() loop : count = %d. score = %d.", 
-            cnt_iter, match_score);
+        filter->ForEach(gallery.Size(), scoreSubject);
+    }
+    else
+    {
+        for (size_t subjectIndex = 0; subjectIndex < gallery.Size(); subjectIndex++)
+        {
+            if (!scoreSubject(subjectIndex))
+            {
+                break;
+            }
+        }
+    }
 
-        BlendAverageVector(updated_faceprints_vec, orig_faceprints_vec, vec_length);
+    result.score = maxScore;
+    result.id = maxSubject;
 
-        MatchTwoVectors(updated_faceprints_vec, orig_faceprints_vec, &match_score, vec_length);
+    return true;
+}
 
-        cnt_iter++;
-        if(cnt_iter > 10)
+ExtendedMatchResult Matcher::MatchFaceprintsToGallery(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                      Faceprints& updated_faceprints)
+{
+    return MatchFaceprintsToGallery(new_faceprints, gallery, updated_faceprints, GetDefaultThresholds());
+}
+
+ExtendedMatchResult Matcher::MatchFaceprintsToGallery(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                      Faceprints& updated_faceprints, const Thresholds& thresholds)
+{
+    if (!ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return ExtendedMatchResult();
+    }
+
+    TagResult scoresResult;
+    match_calc_t threshold = thresholds.strongThreshold_pNMgNM;
+
+    if (!GetScores(new_faceprints, gallery, scoresResult, threshold))
+    {
+        LOG_ERROR(LOG_TAG, "Failed during GetScores() - please check.");
+        return ExtendedMatchResult();
+    }
+
+    return FinalizeGalleryMatch(new_faceprints, gallery, scoresResult, updated_faceprints, thresholds);
+}
+
+ExtendedMatchResult Matcher::MatchFaceprintsToGallery(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                      const GalleryFilter& filter, Faceprints& updated_faceprints,
+                                                      const Thresholds& thresholds)
+{
+    if (!ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return ExtendedMatchResult();
+    }
+
+    TagResult scoresResult;
+    if (!GetScores(new_faceprints, gallery, scoresResult, thresholds.strongThreshold_pNMgNM, &filter))
+    {
+        LOG_ERROR(LOG_TAG, "Failed during GetScores() - please check.");
+        return ExtendedMatchResult();
+    }
+
+    return FinalizeGalleryMatch(new_faceprints, gallery, scoresResult, updated_faceprints, thresholds);
+}
+
+std::vector<ExtendedMatchResult> Matcher::MatchFaceprintsBatch(const std::vector<Faceprints>& new_faceprints,
+                                                               const Gallery& gallery,
+                                                               std::vector<Faceprints>& updated_faceprints,
+                                                               const Thresholds& thresholds)
+{
+    // number of gallery users scored against all probes before moving on (64 x 512 bytes = 32KB, fits L1).
+    static const size_t s_batchBlockSize = 64;
+    static const size_t s_probesPerKernel = 4;
+
+    const size_t numberOfProbes = new_faceprints.size();
+    const size_t numberOfSubjects = gallery.Size();
+    const uint32_t vec_length = Gallery::VectorLength;
+    const match_calc_t threshold = thresholds.strongThreshold_pNMgNM;
+
+    std::vector<ExtendedMatchResult> results(numberOfProbes);
+    updated_faceprints.resize(numberOfProbes);
+
+    std::vector<TagResult> scores(numberOfProbes);
+    std::vector<uint32_t> queryNorms(numberOfProbes, 0);
+    std::vector<size_t> activeProbes;
+    std::vector<size_t> validProbes;
+
+    for (size_t probe = 0; probe < numberOfProbes; probe++)
+    {
+        if (!ValidateGalleryQuery(new_faceprints[probe], gallery))
         {
-            LOG_DEBUG(LOG_TAG, "----> Update while() loop count reached the limit of %d iterations. Breaking the while() loop with score = %d.", 
-                cnt_iter, match_score);
+            continue;
+        }
 
-            break;
+        const feature_t* queryFea = &new_faceprints[probe].adaptiveDescriptorWithoutMask[0];
+        queryNorms[probe] = MatcherSimd::ComputeSums(queryFea, queryFea, vec_length).norm1;
+        scores[probe].score = s_minPossibleScore;
+        scores[probe].id = -1;
+        activeProbes.push_back(probe);
+        validProbes.push_back(probe);
+    }
+
+    // probes are dropped from the scan once they crossed the threshold (same early exit as GetScores).
+    std::vector<uint8_t> done(numberOfProbes, 0);
+
+    for (size_t blockBegin = 0; blockBegin < numberOfSubjects && !activeProbes.empty(); blockBegin += s_batchBlockSize)
+    {
+        const size_t blockEnd = std::min(blockBegin + s_batchBlockSize, numberOfSubjects);
+
+        for (size_t group = 0; group < activeProbes.size(); group += s_probesPerKernel)
+        {
+            const size_t groupSize = std::min(s_probesPerKernel, activeProbes.size() - group);
+
+            // pad a partial group by repeating its last probe.
+            const feature_t* probes[s_probesPerKernel];
+            for (size_t p = 0; p < s_probesPerKernel; p++)
+            {
+                size_t probe = activeProbes[group + std::min(p, groupSize - 1)];
+                probes[p] = &new_faceprints[probe].adaptiveDescriptorWithoutMask[0];
+            }
+
+            for (size_t subjectIndex = blockBegin; subjectIndex < blockEnd; subjectIndex++)
+            {
+                if (!gallery.IsValid(subjectIndex))
+                {
+                    continue;
+                }
+
+                int32_t corr[s_probesPerKernel];
+                MatcherSimd::DotProduct4(gallery.Descriptor(subjectIndex), probes, vec_length, corr);
+
+                for (size_t p = 0; p < groupSize; p++)
+                {
+                    size_t probe = activeProbes[group + p];
+                    if (done[probe])
+                    {
+                        continue;
+                    }
+
+                    match_calc_t adaptedScore = NormalizeScore(corr[p], queryNorms[probe], gallery.Norm(subjectIndex));
+                    if (adaptedScore > scores[probe].score)
+                    {
+                        scores[probe].score = adaptedScore;
+                        scores[probe].id = static_cast<int>(subjectIndex);
+                    }
+
+                    if (adaptedScore > threshold)
+                    {
+                        done[probe] = 1;
+                    }
+                }
+            }
         }
+
+        activeProbes.erase(std::remove_if(activeProbes.begin(), activeProbes.end(),
+                                          [&done](size_t probe) { return done[probe] != 0; }),
+                           activeProbes.end());
+    }
+
+    for (size_t probe : validProbes)
+    {
+        results[probe] =
+            FinalizeGalleryMatch(new_faceprints[probe], gallery, scores[probe], updated_faceprints[probe], thresholds);
+    }
+
+    return results;
+}
+
+bool Matcher::ValidateGalleryQuery(const Faceprints& new_faceprints, const Gallery& gallery)
+{
+    if (!ValidateFaceprints(new_faceprints))
+    {
+        LOG_ERROR(LOG_TAG, "Faceprints vector failed range validation.");
+        return false;
+    }
+
+    if (gallery.Empty())
+    {
+        LOG_ERROR(LOG_TAG, "Gallery is empty.");
+        return false;
+    }
+
+    if (new_faceprints.version != gallery.Version())
+    {
+        LOG_ERROR(LOG_TAG, "version mismatch between 2 vectors. Skipping this match()!");
+        return false;
     }
 
     return true;
 }
 
-static void ConvertFaceprintsToExtendedFaceprints(const Faceprints& faceprints, ExtendedFaceprints& extended_faceprints)
+ExtendedMatchResult Matcher::FinalizeGalleryMatch(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                  const TagResult& scores, Faceprints& updated_faceprints,
+                                                  const Thresholds& thresholds)
+{
+    ExtendedMatchResult result;
+    match_calc_t threshold = thresholds.strongThreshold_pNMgNM;
+    const bool valid_id = (scores.id >= 0) && (static_cast<size_t>(scores.id) < gallery.Size());
+
+    // the search scores come from the gallery's search tier (descriptors, norms and valid flags), which a mapped
+    // gallery takes from disk as-is. recompute the winner's score from its faceprints before accepting it.
+    match_calc_t score = 0;
+    if (valid_id)
+    {
+        const Faceprints& winner = gallery.GetFaceprints(static_cast<size_t>(scores.id));
+        if (ValidateFaceprints(winner))
+        {
+            MatchTwoVectors(&new_faceprints.adaptiveDescriptorWithoutMask[0],
+                            &winner.adaptiveDescriptorWithoutMask[0], &score, Gallery::VectorLength);
+        }
+        if (score != scores.score)
+        {
+            LOG_ERROR(LOG_TAG, "Gallery search data of user_index %d doesn't match its faceprints.", scores.id);
+        }
+    }
+
+    result.maxScore = score;
+    result.isSame = score > threshold;
+    result.isIdentical = (score > thresholds.identicalThreshold_NM);
+    result.userId = scores.id;
+    result.confidence = CalculateConfidence(score, threshold, result);
+    result.should_update = (result.maxScore >= thresholds.updateThreshold_NM) && result.isSame;
+
+    if (result.should_update)
+    {
+        UpdateAdaptiveFaceprints(new_faceprints, gallery.GetFaceprints(static_cast<size_t>(scores.id)),
+                                 updated_faceprints, thresholds);
+    }
+
+    return result;
+}
+
+std::vector<MatchCandidate> Matcher::MatchFaceprintsTopK(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                         size_t k, const Thresholds& thresholds, MatchSearchMode mode)
+{
+    std::vector<MatchCandidate> candidates;
+
+    if (k == 0 || !ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return candidates;
+    }
+
+    const feature_t* queryFea = &new_faceprints.adaptiveDescriptorWithoutMask[0];
+    const uint32_t vec_length = Gallery::VectorLength;
+    const uint32_t queryNorm = MatcherSimd::ComputeSums(queryFea, queryFea, vec_length).norm1;
+    const match_calc_t threshold = thresholds.strongThreshold_pNMgNM;
+    const bool early_exit = (mode == MatchSearchMode::FirstAboveThreshold);
+
+    // k above the gallery size asks for every user; don't reserve more than that.
+    TopKCandidates topk(std::min(k, gallery.Size()));
+    int numberOfSubjects = static_cast<int>(gallery.Size());
+
+    for (int subjectIndex = 0; subjectIndex < numberOfSubjects; subjectIndex++)
+    {
+        if (!gallery.IsValid(subjectIndex))
+        {
+            continue;
+        }
+
+        int32_t corr = MatcherSimd::DotProduct(queryFea, gallery.Descriptor(subjectIndex), vec_length);
+        match_calc_t score = NormalizeScore(corr, queryNorm, gallery.Norm(subjectIndex));
+        topk.Push(subjectIndex, score);
+
+        if (early_exit && score > threshold)
+        {
+            break;
+        }
+    }
+
+    candidates = topk.Sorted();
+
+    ExtendedMatchResult unused;
+    for (auto& candidate : candidates)
+    {
+        candidate.confidence = CalculateConfidence(candidate.score, threshold, unused);
+    }
+
+    return candidates;
+}
+
+// runs the kernel matching the vector length: fixed length for the model's vectors, 64-bit sums for long vectors.
+template <typename Function>
+static uint32_t WithUpdateKernels(uint32_t vec_length, Function function)
+{
+    if (vec_length == RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER)
+    {
+        return function(MatcherKernels::MatcherVectorKernels());
+    }
+    if (vec_length <= MatcherKernels::MaxLength<int32_t>())
+    {
+        return function(MatcherKernels::VectorKernels<MatcherKernels::DynamicLength, feature_t, int32_t>());
+    }
+    return function(MatcherKernels::VectorKernels<MatcherKernels::DynamicLength, feature_t, int64_t>());
+}
+
+void Matcher::UpdateAdaptiveFaceprints(const Faceprints& new_faceprints, const Faceprints& existing_faceprints,
+                                       Faceprints& updated_faceprints, const Thresholds& thresholds)
+{
+    updated_faceprints = existing_faceprints;
+
+    // blend the current avg vector with the new vector, and make sure the blended avg vector is not too far from
+    // enrollment vector - same as BlendAverageVector() + UpdateAverageVector(), with incremental sums.
+    MatcherKernels::MatcherVectorKernels::AdaptiveUpdate(&updated_faceprints.adaptiveDescriptorWithoutMask[0],
+                                                         &new_faceprints.adaptiveDescriptorWithoutMask[0],
+                                                         &updated_faceprints.enrollmentDescriptor[0],
+                                                         thresholds.identicalThreshold_NM);
+}
+
+bool Matcher::UpdateAverageVector(feature_t* updated_faceprints_vec, const feature_t* orig_faceprints_vec, 
+                                    const Thresholds& thresholds, const uint32_t vec_length)                             
 {
-    extended_faceprints.faceprints.version = faceprints.version;
     
-    static_assert(sizeof(extended_faceprints.faceprints.adaptiveDescriptorWithoutMask) == sizeof(faceprints.adaptiveDescriptorWithoutMask), "updated faceprints (with mask) sizes don't match");
-    ::memcpy(&extended_faceprints.faceprints.adaptiveDescriptorWithoutMask[0], &faceprints.adaptiveDescriptorWithoutMask[0], sizeof(faceprints.adaptiveDescriptorWithoutMask));
+    // TODO yossidan - handle with/without mask vectors properly (as needed).
 
-    static_assert(sizeof(extended_faceprints.faceprints.adaptiveDescriptorWithMask) == sizeof(faceprints.adaptiveDescriptorWithMask), "updated faceprints (without) sizes don't match");
-    ::memcpy(&extended_faceprints.faceprints.adaptiveDescriptorWithMask[0], &faceprints.adaptiveDescriptorWithMask[0], sizeof(faceprints.adaptiveDescriptorWithMask));
+    if((nullptr == orig_faceprints_vec) || (nullptr == updated_faceprints_vec))
+    {
+        LOG_ERROR(LOG_TAG, "Null pointer detected : Skipping function.");
+        return false;
+    }
+    // Explain - as long as the avg vector is "too far" from the orig vector, we
+    // want to update the avg vector with more samples of the orig vector.
+    // hence refreshing the avg to be more similar to the orig vector.
+    //
+    // adding limit on number of iterations (11 blends), e.g. if one vector is all zeros we'll get deadlock here.
+    //
+    // every blend round updates the dot product and norm of the avg vector in the same pass (the norm of the orig
+    // vector doesn't change), instead of blending and then re-matching the two vectors.
+    uint32_t rounds = WithUpdateKernels(vec_length, [&](auto kernels) {
+        return decltype(kernels)::Update(updated_faceprints_vec, orig_faceprints_vec, thresholds.identicalThreshold_NM,
+                                         vec_length);
+    });
+
+    if (rounds > 0)
+    {
+        LOG_DEBUG(LOG_TAG, "----> Avg vector was far from orig vector. Did %u update rounds.", rounds);
+    }
 
-    static_assert(sizeof(extended_faceprints.faceprints.enrollmentDescriptor) == sizeof(faceprints.enrollmentDescriptor), "enrollment faceprints sizes don't match");
-    ::memcpy(&extended_faceprints.faceprints.enrollmentDescriptor[0], &faceprints.enrollmentDescriptor[0], sizeof(faceprints.enrollmentDescriptor));
+    return true;
 }
 
 MatchResultInternal Matcher::MatchFaceprints(const Faceprints& new_faceprints, const Faceprints& existing_faceprints, Faceprints& updated_faceprints)
 {
-    // init match result
+    Thresholds thresholds;
+    SetToDefaultThresholds(thresholds);
+    return MatchFaceprints(new_faceprints, existing_faceprints, updated_faceprints, thresholds);
+}
+
+MatchResultInternal Matcher::MatchFaceprints(const Faceprints& new_faceprints, const Faceprints& existing_faceprints,
+                                             Faceprints& updated_faceprints, const Thresholds& thresholds)
+{
+    // same result as MatchFaceprintsToArray() with a single user, without building the array (no copies, no
+    // allocations) and without logging unless an error occurs.
     MatchResultInternal matchResult;
-    matchResult.success = false;
-    matchResult.should_update = false;
-    matchResult.score = 0;
-    matchResult.confidence = 0;
 
     if (!ValidateFaceprints(new_faceprints)) 
-	{
+    {
         LOG_ERROR(LOG_TAG, "new faceprints vector : failed range validation.");
-		return matchResult;	
-	}
-    
+        return matchResult;
+    }
+
     if (!ValidateFaceprints(existing_faceprints)) 
-	{
+    {
         LOG_ERROR(LOG_TAG, "existing faceprints vector : failed range validation.");
-		return matchResult;	
-	}
+        return matchResult;
+    }
+
+    if (!IsSameVersion(new_faceprints, existing_faceprints))
+    {
+        LOG_ERROR(LOG_TAG, "version mismatch between 2 vectors. Skipping this match()!");
+        return matchResult;
+    }
+
+    matchResult = ScoreSinglePair(&new_faceprints.adaptiveDescriptorWithoutMask[0],
+                                  &existing_faceprints.adaptiveDescriptorWithoutMask[0], thresholds);
+
+    if (matchResult.should_update)
+    {
+        UpdateAdaptiveFaceprints(new_faceprints, existing_faceprints, updated_faceprints, thresholds);
+    }
+
+    return matchResult;
+}
+
+MatchResultInternal Matcher::MatchDescriptors(const feature_t* new_adaptive, const feature_t* existing_adaptive,
+                                              const feature_t* existing_enrollment, feature_t* updated_adaptive,
+                                              const Thresholds& thresholds)
+{
+    MatchResultInternal matchResult;
+
+    if ((nullptr == new_adaptive) || (nullptr == existing_adaptive) || (nullptr == existing_enrollment) ||
+        (nullptr == updated_adaptive))
+    {
+        LOG_ERROR(LOG_TAG, "Null pointer detected : Skipping function.");
+        return matchResult;
+    }
+
+    if (!ValidateVector(new_adaptive) || !ValidateVector(existing_adaptive))
+    {
+        LOG_ERROR(LOG_TAG, "Vector (faceprint) validation failed!");
+        return matchResult;
+    }
 
-    // init existing faceprints array
-    ExtendedFaceprints existing_extended_faceprints;
-    ConvertFaceprintsToExtendedFaceprints(existing_faceprints, existing_extended_faceprints);
-    std::vector<ExtendedFaceprints> existing_faceprints_array = {existing_extended_faceprints};
+    matchResult = ScoreSinglePair(new_adaptive, existing_adaptive, thresholds);
 
-    // match using shared code
-    ExtendedMatchResult result = MatchFaceprintsToArray(new_faceprints, existing_faceprints_array, updated_faceprints);
+    if (matchResult.should_update)
+    {
+        // std::memmove - the updated vector may be the existing one (update in place).
+        const uint32_t vec_length = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER;
+        std::memmove(updated_adaptive, existing_adaptive, vec_length * sizeof(feature_t));
+        MatcherKernels::MatcherVectorKernels::AdaptiveUpdate(updated_adaptive, new_adaptive, existing_enrollment,
+                                                             thresholds.identicalThreshold_NM);
+    }
 
-    LOG_DEBUG(LOG_TAG, "Match score: %f, confidence: %f, isSame: %d, shouldUpdate: %d", float(result.maxScore), float(result.confidence), 
-                result.isSame, result.should_update);
+    return matchResult;
+}
 
-    // set results into output struct
-    matchResult.score = result.maxScore;
-    matchResult.confidence = result.confidence;
-    matchResult.success = result.isSame;
+MatchResultInternal Matcher::ScoreSinglePair(const feature_t* new_adaptive, const feature_t* existing_adaptive,
+                                             const Thresholds& thresholds)
+{
+    const match_calc_t threshold = thresholds.strongThreshold_pNMgNM;
 
-    matchResult.should_update = result.should_update;
+    match_calc_t score = s_minPossibleScore;
+    MatchTwoVectors(new_adaptive, existing_adaptive, &score);
+    score = std::max(score, s_minPossibleScore);
 
+    ExtendedMatchResult unused;
+    MatchResultInternal matchResult;
+    matchResult.score = score;
+    matchResult.success = score > threshold;
+    matchResult.confidence = CalculateConfidence(score, threshold, unused);
+    matchResult.should_update = (score >= thresholds.updateThreshold_NM) && matchResult.success;
     return matchResult;
 }
 
@@ -480,21 +859,14 @@ void Matcher::BlendAverageVector(feature_t* user_average_faceprints, const featu
         return; 
     }
 
-    int history_weight = RSID_UPDATE_GALLERY_HISTORY_WEIGHT;
-    int round_value = (history_weight + 1);
-    for (uint32_t i = 0; i < vec_length ; ++i)
+    if (vec_length == RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER)
     {
-        int32_t v = static_cast<int32_t>(user_average_faceprints[i]);
-        v *= 2 * history_weight;
-        v += 2 * (int)(user_new_faceprints[i]);
-        v = (v >= 0) ? (v + round_value) : (v - round_value);
-        v /= (2 * round_value);
-
-        short feature_value = static_cast<short>(v);
-        feature_value = (feature_value > s_maxFeatureValue) ? s_maxFeatureValue : feature_value;
-        feature_value = (feature_value < -s_maxFeatureValue) ? -s_maxFeatureValue : feature_value;
-
-        user_average_faceprints[i] = static_cast<short>(v);
+        MatcherKernels::MatcherVectorKernels::Blend(user_average_faceprints, user_new_faceprints);
+    }
+    else
+    {
+        MatcherKernels::VectorKernels<MatcherKernels::DynamicLength>::Blend(user_average_faceprints,
+                                                                           user_new_faceprints, vec_length);
     }
 }
 
@@ -585,10 +957,11 @@ void Matcher::MatchTwoVectors(const feature_t* T1, const feature_t* T2, match_ca
     // Correct calculation is expected if :
     //
     // (1) all feature vector values are integers in range R = (-1024, +1024).
-    // (2) length of vectors is 256.
+    // (2) length of vectors is up to MatcherKernels::MaxLength<int32_t>() (2052) for the 32-bit SIMD kernels.
+    //     longer vectors are accumulated in 64 bit.
     //
-    // IMPORTANT : If one of the assumptions is violated (longer vectors, or wider range R) - then the calculation may
-    // be incorrect due to overflow during bit shifts.
+    // IMPORTANT : If the range assumption is violated (wider range R) - then the calculation may be incorrect due to
+    // overflow during bit shifts.
     // We validate these conditions in ValidateFaceprints().
     //
     // The calculated ncc will be an integer in range [0, 4096], with 4096 expected for equal vectors (that satisfy the
@@ -600,41 +973,40 @@ void Matcher::MatchTwoVectors(const feature_t* T1, const feature_t* T2, match_ca
         return; 
     }
 
-    //  "Matcher may require carefull adjustments and checks for vectors longer than 256."
-    if (vec_length > 256)
+    if (vec_length > MatcherKernels::MaxLength<int32_t>())
     {
-        LOG_ERROR(LOG_TAG, "Vector length > 256 : Matcher may require carefull adjustments. Skipping this function, please check!");
-
-        *retprob = 0;
-        
+        *retprob = MatcherKernels::VectorKernels<MatcherKernels::DynamicLength, feature_t, int64_t>::Match(T1, T2,
+                                                                                                        vec_length);
         return;
     }
 
-    uint32_t nfeatures = vec_length;
-    
-    int32_t corr = 0;
+    MatcherSimd::VectorSums sums = MatcherSimd::ComputeSums(T1, T2, vec_length);
+
+    *retprob = NormalizeScore(sums.corr, sums.norm1, sums.norm2);
+}
+
+match_calc_t Matcher::NormalizeScore(int32_t corr, uint32_t norm1, uint32_t norm2)
+{
+    // turns the integer sums of MatchTwoVectors() into the ncc grade in range [0, 4096].
     int32_t min_corr = 0;
     uint32_t ucorr = 0;
-    uint32_t norm1 = 0;
-    uint32_t norm2 = 0;
 
-    for (uint32_t i = 0; i < nfeatures; ++i)
-    {
-        int32_t t1 = static_cast<int32_t>(T1[i]);
-        int32_t t2 = static_cast<int32_t>(T2[i]);
+    // negative correlation will be considered as 0 correlation.
+    ucorr = static_cast<uint32_t>(std::max(corr, min_corr));
 
-        corr += t1 * t2;
-        norm1 += t1 * t1;
-        norm2 += t2 * t2;
+    // the shifts below keep their precision for norms up to 28 bits (256 features). sums of longer vectors are scaled
+    // down by the same power of 2, which keeps corr^2 / (norm1 * norm2).
+    while (std::max(norm1, norm2) >= s_maxNormForShifts)
+    {
+        ucorr >>= 1;
+        norm1 >>= 1;
+        norm2 >>= 1;
     }
 
     // protect division by 0.
     norm1 = (norm1 == 0) ? 1 : norm1;
     norm2 = (norm2 == 0) ? 1 : norm2;
 
-    // negative correlation will be considered as 0 correlation.
-    ucorr = static_cast<uint32_t>(std::max(corr, min_corr));
-
     short norm1_msb = GetMsb(norm1);
     short norm2_msb = GetMsb(norm2);
     short corr_msb = GetMsb(ucorr);
@@ -668,7 +1040,7 @@ void Matcher::MatchTwoVectors(const feature_t* T1, const feature_t* T2, match_ca
 
     // LOG_DEBUG(LOG_TAG, "ncc result: -----> grade = %u", grade);
 
-    *retprob = static_cast<match_calc_t>(grade);
+    return static_cast<match_calc_t>(grade);
 }
 
 } // namespace RealSenseID
@@ -13,6 +13,8 @@ using feature_t = short;
 using match_calc_t = short;
 
 class ExtendedFaceprints;
+class Gallery;
+class GalleryFilter;
 
 struct ExtendedMatchResult
 {
@@ -40,6 +42,20 @@ struct TagResult
     match_calc_t similarityScore = 0;
 };
 
+// single candidate of a top-k search.
+struct MatchCandidate
+{
+    int userId = -1; // gallery index
+    match_calc_t score = 0;
+    match_calc_t confidence = 0;
+};
+
+enum class MatchSearchMode
+{
+    Exhaustive,         // score every user in the gallery.
+    FirstAboveThreshold // stop at the first user above strongThreshold_pNMgNM (lowest latency).
+};
+
 struct Thresholds
 {   
     // naming convention here :
@@ -67,6 +83,19 @@ public:
     // match single vs. single faceprints. Returns updated faceprints if update conditions fulfilled (indicated in result.should_update).
     static MatchResultInternal MatchFaceprints(const Faceprints& new_faceprints, const Faceprints& existing_faceprints, Faceprints& updated_faceprints);
 
+    // same as above, with thresholds provided by caller. no allocations, and nothing is logged unless an error occurs -
+    // suitable for 1:1 matches in a loop over a host-side database.
+    static MatchResultInternal MatchFaceprints(const Faceprints& new_faceprints, const Faceprints& existing_faceprints,
+                                               Faceprints& updated_faceprints, const Thresholds& thresholds);
+
+    // single vs. single on the adaptive (without mask) and enrollment vectors in place, for callers that keep vectors
+    // in their own layout (e.g. the C wrapper's structs). if result.should_update, updated_adaptive receives the
+    // adaptive update of existing_adaptive (updated_adaptive may point to existing_adaptive to update it in place);
+    // otherwise it is not written. vectors are RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER long.
+    static MatchResultInternal MatchDescriptors(const feature_t* new_adaptive, const feature_t* existing_adaptive,
+                                                const feature_t* existing_enrollment, feature_t* updated_adaptive,
+                                                const Thresholds& thresholds);
+
     // match single vs. an array of faceprints. Used e.g. when matching user against a set of users in the database.
     // returns updated faceprints if update conditions fulfilled (indicated in result.should_update). 
     // internal thresholds will be used.
@@ -81,13 +110,69 @@ public:
                                                       const std::vector<ExtendedFaceprints>& existing_faceprints_array,
                                                       Faceprints& updated_faceprints, const Thresholds& thresholds);
 
+    // match single vs. a search-optimized gallery (validated once at insert, norms precomputed).
+    // returns updated faceprints if update conditions fulfilled (indicated in result.should_update).
+    // result.userId is the gallery index of the best match. internal thresholds will be used.
+    static ExtendedMatchResult MatchFaceprintsToGallery(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                        Faceprints& updated_faceprints);
+
+    // same as above, with thresholds provided by caller.
+    static ExtendedMatchResult MatchFaceprintsToGallery(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                        Faceprints& updated_faceprints, const Thresholds& thresholds);
+
+    // same as above, scanning only the users in filter (e.g. the users a door admits). users not in the filter are
+    // skipped without touching their search data, so the cost follows filter.Count() rather than the gallery size.
+    static ExtendedMatchResult MatchFaceprintsToGallery(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                        const GalleryFilter& filter, Faceprints& updated_faceprints,
+                                                        const Thresholds& thresholds);
     
+    // match single vs. gallery and return the K best candidates (sorted by descending score) in a single pass.
+    // with MatchSearchMode::FirstAboveThreshold the scan stops once a score exceeds strongThreshold_pNMgNM, so only
+    // the users scanned up to that point are ranked.
+    // no adaptive update is done here - use MatchFaceprintsToGallery() for that.
+    static std::vector<MatchCandidate> MatchFaceprintsTopK(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                           size_t k, const Thresholds& thresholds,
+                                                           MatchSearchMode mode = MatchSearchMode::Exhaustive);
+
+    // match many probes (e.g. all faces found in a frame) vs. gallery in one pass. The gallery is scanned in blocks
+    // and each gallery vector is loaded once for up to 4 probes.
+    // results[i] and updated_faceprints[i] are identical to MatchFaceprintsToGallery(new_faceprints[i], ...).
+    static std::vector<ExtendedMatchResult> MatchFaceprintsBatch(const std::vector<Faceprints>& new_faceprints,
+                                                                 const Gallery& gallery,
+                                                                 std::vector<Faceprints>& updated_faceprints,
+                                                                 const Thresholds& thresholds);
+
+    static Thresholds GetDefaultThresholds();
+
     // checks the faceprints vector coordinates are in valid range [-1023,+1023]. 
     // if check_enrollment_vector=false it validates the adaptive faceprints, otherwise it validates the enrollment faceprints.
     static bool ValidateFaceprints(const Faceprints& faceprints, bool check_enrollment_vector=false);
-    
-    
+
+    // building blocks for gallery search engines (e.g. ParallelMatcher) that score the gallery on their own.
+
+    // checks new faceprints can be matched against the gallery (range, non-empty gallery, same version).
+    static bool ValidateGalleryQuery(const Faceprints& new_faceprints, const Gallery& gallery);
+
+    // ncc grade from the dot product and squared norms calculated in MatchTwoVectors().
+    static match_calc_t NormalizeScore(int32_t corr, uint32_t norm1, uint32_t norm2);
+
+    // fill match result (and updated faceprints if should_update) from best gallery score.
+    static ExtendedMatchResult FinalizeGalleryMatch(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                    const TagResult& scores, Faceprints& updated_faceprints,
+                                                    const Thresholds& thresholds);
+
+    // blend new faceprints into existing user's adaptive vector, keeping it close to the enrollment vector.
+    static void UpdateAdaptiveFaceprints(const Faceprints& new_faceprints, const Faceprints& existing_faceprints,
+                                         Faceprints& updated_faceprints, const Thresholds& thresholds);
+
+    static match_calc_t CalculateConfidence(match_calc_t score, match_calc_t threshold, ExtendedMatchResult& result);
+
 private:
+    // rsid-matcher-bench measures and cross-checks the vector-level primitives below.
+    friend class MatcherBenchAccess;
+
+    static short GetMsb(const uint32_t ux);
+
     static void MatchTwoVectors(const feature_t* T1, const feature_t* T2, match_calc_t* retprob,
                                 const uint32_t vec_length = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER);
 
@@ -96,11 +181,6 @@ private:
 
     static bool UpdateAverageVector(feature_t* updated_faceprints_vec, const feature_t* orig_faceprints_vec,
                                     const Thresholds& thresholds, const uint32_t vec_length = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER);
-                                    
-
-    static Thresholds GetDefaultThresholds();
-
-    static short GetMsb(const uint32_t ux);
 
     static void FaceMatch(const Faceprints& new_faceprints,
                           const std::vector<ExtendedFaceprints>& existing_faceprints_array, ExtendedMatchResult& result,
@@ -110,7 +190,13 @@ private:
                           const std::vector<ExtendedFaceprints>& existing_faceprints_array, TagResult& result,
                           match_calc_t threshold);
 
-    static match_calc_t CalculateConfidence(match_calc_t score, match_calc_t threshold, ExtendedMatchResult& result);
+    // scans the users in filter only, if a filter is given.
+    static bool GetScores(const Faceprints& new_faceprints, const Gallery& gallery, TagResult& result,
+                          match_calc_t threshold, const GalleryFilter* filter = nullptr);
+
+    // score and match flags of a single pair of (validated) adaptive vectors.
+    static MatchResultInternal ScoreSinglePair(const feature_t* new_adaptive, const feature_t* existing_adaptive,
+                                               const Thresholds& thresholds);
 
     static bool ValidateVector(const feature_t* T1, const uint32_t vec_length = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER);
 
@@ -0,0 +1,270 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Compile-time specialized matcher kernels (ncc sums, score, adaptive blend/update).
+//
+// The kernels are templates on the vector length, the feature type and the accumulator type:
+// * fixed length (e.g. VectorKernels<256>) - loops have a constant trip count, so the compiler fully unrolls and
+//   vectorizes them. DynamicLength takes the length at runtime instead.
+// * integer features - integer arithmetic only, bit-identical to Matcher/MatcherSimd for int32_t accumulators.
+//   int64_t accumulators serve vectors too long for 32-bit sums (see MaxLength()).
+// * float features - double accumulation, same score scale [0, 4096].
+namespace RealSenseID
+{
+namespace MatcherKernels
+{
+static constexpr uint32_t DynamicLength = 0;
+
+// default accumulator of a feature type.
+template <typename Feature>
+struct DefaultAccumulator
+{
+    using type = int32_t;
+};
+
+template <>
+struct DefaultAccumulator<float>
+{
+    using type = double;
+};
+
+// norms are unsigned for integer accumulators (sums of squares).
+template <typename Accumulator, bool Integral = std::is_integral<Accumulator>::value>
+struct NormType
+{
+    using type = typename std::make_unsigned<Accumulator>::type;
+};
+
+template <typename Accumulator>
+struct NormType<Accumulator, false>
+{
+    using type = Accumulator;
+};
+
+template <typename Accumulator>
+struct Sums
+{
+    using norm_t = typename NormType<Accumulator>::type;
+
+    Accumulator corr = 0;
+    norm_t norm1 = 0;
+    norm_t norm2 = 0;
+};
+
+// longest integer vector whose sums can't overflow Accumulator (features in [-RSID_MAX_FEATURE_VALUE, +]).
+template <typename Accumulator>
+constexpr uint64_t MaxLength()
+{
+    return static_cast<uint64_t>(std::numeric_limits<Accumulator>::max()) /
+           (static_cast<uint64_t>(RSID_MAX_FEATURE_VALUE) * RSID_MAX_FEATURE_VALUE);
+}
+
+// ncc grade in range [0, 4096] from the sums, using the integer normalization of Matcher::NormalizeScore(). sums beyond
+// 32 bit are scaled down by the same power of 2 first (which keeps corr^2 / (norm1 * norm2)).
+template <typename Accumulator>
+inline match_calc_t Score(const Sums<Accumulator>& sums, std::true_type /* integral */)
+{
+    if (sizeof(Accumulator) <= sizeof(int32_t))
+    {
+        return Matcher::NormalizeScore(static_cast<int32_t>(sums.corr), static_cast<uint32_t>(sums.norm1),
+                                       static_cast<uint32_t>(sums.norm2));
+    }
+
+    // |corr| <= max(norm1, norm2) (cauchy-schwarz), so fitting the norms into 31 bits fits corr as well.
+    uint64_t max_norm = std::max<uint64_t>(sums.norm1, sums.norm2);
+    int shift = 0;
+    while ((max_norm >> shift) > static_cast<uint64_t>(std::numeric_limits<int32_t>::max()))
+    {
+        shift++;
+    }
+
+    int64_t corr = static_cast<int64_t>(sums.corr);
+    corr = corr < 0 ? 0 : (corr >> shift);
+    return Matcher::NormalizeScore(static_cast<int32_t>(corr), static_cast<uint32_t>(sums.norm1 >> shift),
+                                   static_cast<uint32_t>(sums.norm2 >> shift));
+}
+
+template <typename Accumulator>
+inline match_calc_t Score(const Sums<Accumulator>& sums, std::false_type /* floating point */)
+{
+    // same scale as the integer grade: 4096 * ncc^2, negative correlation considered as 0.
+    double corr = std::max(static_cast<double>(sums.corr), 0.0);
+    double norm1 = sums.norm1 > 0 ? static_cast<double>(sums.norm1) : 1.0;
+    double norm2 = sums.norm2 > 0 ? static_cast<double>(sums.norm2) : 1.0;
+    double grade = std::floor(RSID_MAX_POSSIBLE_SCORE * (corr / norm1) * (corr / norm2));
+    return static_cast<match_calc_t>(std::min(grade, static_cast<double>(RSID_MAX_POSSIBLE_SCORE)));
+}
+
+template <uint32_t VectorLength, typename Feature = feature_t,
+          typename Accumulator = typename DefaultAccumulator<Feature>::type>
+struct VectorKernels
+{
+    using sums_t = Sums<Accumulator>;
+    using norm_t = typename sums_t::norm_t;
+
+    static_assert(std::is_integral<Feature>::value == std::is_integral<Accumulator>::value,
+                  "Integer features need an integer accumulator (and float features a floating point one)");
+    static_assert(!std::is_integral<Accumulator>::value || VectorLength <= MaxLength<Accumulator>(),
+                  "Vector length may overflow the accumulator - use a wider one");
+
+    // the length loops run to - a compile time constant unless DynamicLength.
+    static inline uint32_t Length(uint32_t vec_length)
+    {
+        return VectorLength != DynamicLength ? VectorLength : vec_length;
+    }
+
+    static inline sums_t ComputeSums(const Feature* T1, const Feature* T2, uint32_t vec_length = VectorLength)
+    {
+        Accumulator corr = 0;
+        norm_t norm1 = 0;
+        norm_t norm2 = 0;
+
+        const uint32_t length = Length(vec_length);
+        for (uint32_t i = 0; i < length; ++i)
+        {
+            Accumulator t1 = static_cast<Accumulator>(T1[i]);
+            Accumulator t2 = static_cast<Accumulator>(T2[i]);
+
+            corr += t1 * t2;
+            norm1 += static_cast<norm_t>(t1 * t1);
+            norm2 += static_cast<norm_t>(t2 * t2);
+        }
+
+        sums_t sums;
+        sums.corr = corr;
+        sums.norm1 = norm1;
+        sums.norm2 = norm2;
+        return sums;
+    }
+
+    static inline Accumulator DotProduct(const Feature* T1, const Feature* T2, uint32_t vec_length = VectorLength)
+    {
+        Accumulator corr = 0;
+        const uint32_t length = Length(vec_length);
+        for (uint32_t i = 0; i < length; ++i)
+        {
+            corr += static_cast<Accumulator>(T1[i]) * static_cast<Accumulator>(T2[i]);
+        }
+        return corr;
+    }
+
+    // ncc grade in range [0, 4096], same as Matcher::MatchTwoVectors().
+    static inline match_calc_t Match(const Feature* T1, const Feature* T2, uint32_t vec_length = VectorLength)
+    {
+        return Score(ComputeSums(T1, T2, vec_length), std::is_integral<Accumulator>());
+    }
+
+    // avg = round((w * avg + new) / (w + 1)) for history weight w, same as Matcher::BlendAverageVector().
+    static inline void Blend(Feature* average, const Feature* new_vec, uint32_t vec_length = VectorLength)
+    {
+        const uint32_t length = Length(vec_length);
+        for (uint32_t i = 0; i < length; ++i)
+        {
+            average[i] = BlendFeature(average[i], new_vec[i], std::is_integral<Feature>());
+        }
+    }
+
+    // Blend(average, new_vec) fused with the sums of the blended average and other, in a single pass.
+    // sums.norm2 (the norm of other) is given by the caller - it doesn't change between blend rounds.
+    static inline sums_t BlendAndSums(Feature* average, const Feature* new_vec, const Feature* other, norm_t other_norm,
+                                      uint32_t vec_length = VectorLength)
+    {
+        Accumulator corr = 0;
+        norm_t norm1 = 0;
+
+        const uint32_t length = Length(vec_length);
+        for (uint32_t i = 0; i < length; ++i)
+        {
+            Feature blended = BlendFeature(average[i], new_vec[i], std::is_integral<Feature>());
+            average[i] = blended;
+
+            Accumulator t1 = static_cast<Accumulator>(blended);
+            corr += t1 * static_cast<Accumulator>(other[i]);
+            norm1 += static_cast<norm_t>(t1 * t1);
+        }
+
+        sums_t sums;
+        sums.corr = corr;
+        sums.norm1 = norm1;
+        sums.norm2 = other_norm;
+        return sums;
+    }
+
+    // blend the original vector into the average until they are identical (at most 11 times), same as
+    // Matcher::UpdateAverageVector(). every round is one fused blend + dot product pass, the norm of the original
+    // vector is computed once. returns the number of blend rounds.
+    static inline uint32_t Update(Feature* average, const Feature* orig, match_calc_t identical_threshold,
+                                  uint32_t vec_length = VectorLength)
+    {
+        sums_t sums = ComputeSums(average, orig, vec_length);
+        return UpdateFrom(sums, average, orig, identical_threshold, vec_length);
+    }
+
+    // the adaptive update of Matcher::MatchFaceprintsToGallery(): blend the new vector into the average, then
+    // Update() it towards the original (enrollment) vector. returns the number of Update() rounds.
+    static inline uint32_t AdaptiveUpdate(Feature* average, const Feature* new_vec, const Feature* orig,
+                                          match_calc_t identical_threshold, uint32_t vec_length = VectorLength)
+    {
+        const norm_t orig_norm = ComputeSums(orig, orig, vec_length).norm1;
+        sums_t sums = BlendAndSums(average, new_vec, orig, orig_norm, vec_length);
+        return UpdateFrom(sums, average, orig, identical_threshold, vec_length);
+    }
+
+private:
+    // Update() rounds, starting from the sums of the current average and the original vector.
+    static inline uint32_t UpdateFrom(sums_t sums, Feature* average, const Feature* orig,
+                                      match_calc_t identical_threshold, uint32_t vec_length)
+    {
+        uint32_t rounds = 0;
+        while (Score(sums, std::is_integral<Accumulator>()) < identical_threshold && rounds <= 10)
+        {
+            sums = BlendAndSums(average, orig, orig, sums.norm2, vec_length);
+            rounds++;
+        }
+        return rounds;
+    }
+
+    static inline Feature BlendFeature(Feature average, Feature new_feature, std::true_type /* integral */)
+    {
+        // v = int((2 * w * avg + 2 * new +/- (w + 1)) / (2 * (w + 1))) - rounds half away from zero.
+        const int32_t history_weight = RSID_UPDATE_GALLERY_HISTORY_WEIGHT;
+        const int32_t round_value = history_weight + 1;
+
+        int32_t v = 2 * history_weight * static_cast<int32_t>(average) + 2 * static_cast<int32_t>(new_feature);
+        v = (v >= 0) ? (v + round_value) : (v - round_value);
+
+        if ((round_value & 1) == 0)
+        {
+            return static_cast<Feature>(v / (2 * round_value));
+        }
+
+        // v / (2 * (w + 1)) truncated towards 0, via float multiply (vectorizes, unlike integer division). exact:
+        // for odd w + 1, v is odd and the divisor even, so the quotient is at least 1 / (2 * (w + 1)) away from an
+        // integer - far above the float error for |v| < 2^17.
+        const float inverse_divisor = 1.0f / static_cast<float>(2 * round_value);
+        return static_cast<Feature>(static_cast<int32_t>(static_cast<float>(v) * inverse_divisor));
+    }
+
+    static inline Feature BlendFeature(Feature average, Feature new_feature, std::false_type /* floating point */)
+    {
+        const Feature history_weight = static_cast<Feature>(RSID_UPDATE_GALLERY_HISTORY_WEIGHT);
+        return (history_weight * average + new_feature) / (history_weight + 1);
+    }
+};
+
+// kernels of the recognition model's vectors (64-bit accumulation if the model's vectors are too long for 32 bit).
+using MatcherVectorKernels =
+    VectorKernels<RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER, feature_t,
+                  std::conditional<RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER <= MaxLength<int32_t>(), int32_t,
+                                   int64_t>::type>;
+} // namespace MatcherKernels
+} // namespace RealSenseID
@@ -0,0 +1,603 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "MatcherSimd.h"
+#include "MatcherKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RSID_MATCHER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RSID_MATCHER_NEON 1
+#include <arm_neon.h>
+#endif
+
+// allow compiling the avx2/sse4.1 kernels without enabling these instruction sets for the whole library.
+// the kernels are only called after cpuid reported support for them.
+#if defined(RSID_MATCHER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RSID_TARGET(isa) __attribute__((target(isa)))
+#else
+#define RSID_TARGET(isa)
+#endif
+
+namespace RealSenseID
+{
+namespace MatcherSimd
+{
+using sums_func_t = VectorSums (*)(const feature_t*, const feature_t*, uint32_t);
+using dot_func_t = int32_t (*)(const feature_t*, const feature_t*, uint32_t);
+using dot4_func_t = void (*)(const feature_t*, const feature_t* const[4], uint32_t, int32_t[4]);
+using hamming_func_t = void (*)(const uint64_t*, const uint64_t*, std::size_t, uint16_t*);
+
+static const std::size_t s_codeWords = 4; // 256 bit codes
+
+using scalar_kernels_t = MatcherKernels::VectorKernels<MatcherKernels::DynamicLength, feature_t, int32_t>;
+// fixed length - fully unrolled/vectorized by the compiler (used on cpus without a SIMD kernel).
+using fixed_scalar_kernels_t = MatcherKernels::VectorKernels<RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER, feature_t,
+                                                             int32_t>;
+
+VectorSums ComputeSumsScalar(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    scalar_kernels_t::sums_t kernel_sums = vec_length == RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER
+                                               ? fixed_scalar_kernels_t::ComputeSums(T1, T2)
+                                               : scalar_kernels_t::ComputeSums(T1, T2, vec_length);
+
+    VectorSums sums;
+    sums.corr = kernel_sums.corr;
+    sums.norm1 = kernel_sums.norm1;
+    sums.norm2 = kernel_sums.norm2;
+    return sums;
+}
+
+int32_t DotProductScalar(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    if (vec_length == RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER)
+    {
+        return fixed_scalar_kernels_t::DotProduct(T1, T2);
+    }
+    return scalar_kernels_t::DotProduct(T1, T2, vec_length);
+}
+
+void DotProduct4Scalar(const feature_t* gallery_vec, const feature_t* const probes[4], uint32_t vec_length,
+                       int32_t out[4])
+{
+    for (int p = 0; p < 4; p++)
+    {
+        out[p] = DotProductScalar(probes[p], gallery_vec, vec_length);
+    }
+}
+
+static inline uint32_t PopCountScalar(uint64_t x)
+{
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<uint32_t>((x * 0x0101010101010101ULL) >> 56);
+}
+
+void HammingDistances256Scalar(const uint64_t* query_code, const uint64_t* codes, std::size_t count,
+                               uint16_t* distances)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const uint64_t* code = codes + i * s_codeWords;
+        uint32_t distance = 0;
+        for (std::size_t w = 0; w < s_codeWords; w++)
+        {
+            distance += PopCountScalar(query_code[w] ^ code[w]);
+        }
+        distances[i] = static_cast<uint16_t>(distance);
+    }
+}
+
+// adds the scalar tail [first, vec_length) of DotProduct4() into out.
+static void AddScalarTail4(const feature_t* gallery_vec, const feature_t* const probes[4], uint32_t first,
+                           uint32_t vec_length, int32_t out[4])
+{
+    for (int p = 0; p < 4; p++)
+    {
+        int32_t tail = DotProductScalar(probes[p] + first, gallery_vec + first, vec_length - first);
+        out[p] = static_cast<int32_t>(static_cast<uint32_t>(out[p]) + static_cast<uint32_t>(tail));
+    }
+}
+
+// adds the scalar tail [first, vec_length) into sums.
+static void AddScalarTail(const feature_t* T1, const feature_t* T2, uint32_t first, uint32_t vec_length,
+                          VectorSums& sums)
+{
+    if (first < vec_length)
+    {
+        VectorSums tail = ComputeSumsScalar(T1 + first, T2 + first, vec_length - first);
+        sums.corr = static_cast<int32_t>(static_cast<uint32_t>(sums.corr) + static_cast<uint32_t>(tail.corr));
+        sums.norm1 += tail.norm1;
+        sums.norm2 += tail.norm2;
+    }
+}
+
+#ifdef RSID_MATCHER_X86
+RSID_TARGET("sse4.1") static inline uint32_t HorizontalSum128(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+}
+
+// pmaddwd multiplies 8 pairs of int16 and adds adjacent products into 4 int32 lanes.
+// with features in [-1023, 1023] each pair sum fits easily in int32, so no precision is lost.
+RSID_TARGET("sse4.1") static VectorSums ComputeSumsSse41(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    __m128i corr = _mm_setzero_si128();
+    __m128i norm1 = _mm_setzero_si128();
+    __m128i norm2 = _mm_setzero_si128();
+
+    uint32_t i = 0;
+    for (; i + 8 <= vec_length; i += 8)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(T1 + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(T2 + i));
+
+        corr = _mm_add_epi32(corr, _mm_madd_epi16(a, b));
+        norm1 = _mm_add_epi32(norm1, _mm_madd_epi16(a, a));
+        norm2 = _mm_add_epi32(norm2, _mm_madd_epi16(b, b));
+    }
+
+    VectorSums sums;
+    sums.corr = static_cast<int32_t>(HorizontalSum128(corr));
+    sums.norm1 = HorizontalSum128(norm1);
+    sums.norm2 = HorizontalSum128(norm2);
+    AddScalarTail(T1, T2, i, vec_length, sums);
+    return sums;
+}
+
+RSID_TARGET("sse4.1") static int32_t DotProductSse41(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    __m128i corr = _mm_setzero_si128();
+
+    uint32_t i = 0;
+    for (; i + 8 <= vec_length; i += 8)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(T1 + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(T2 + i));
+        corr = _mm_add_epi32(corr, _mm_madd_epi16(a, b));
+    }
+
+    uint32_t result = HorizontalSum128(corr) + static_cast<uint32_t>(DotProductScalar(T1 + i, T2 + i, vec_length - i));
+    return static_cast<int32_t>(result);
+}
+
+RSID_TARGET("avx2") static inline uint32_t HorizontalSum256(__m256i v)
+{
+    __m128i v128 = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return HorizontalSum128(v128);
+}
+
+RSID_TARGET("avx2") static VectorSums ComputeSumsAvx2(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    __m256i corr = _mm256_setzero_si256();
+    __m256i norm1 = _mm256_setzero_si256();
+    __m256i norm2 = _mm256_setzero_si256();
+
+    uint32_t i = 0;
+    for (; i + 16 <= vec_length; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(T1 + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(T2 + i));
+
+        corr = _mm256_add_epi32(corr, _mm256_madd_epi16(a, b));
+        norm1 = _mm256_add_epi32(norm1, _mm256_madd_epi16(a, a));
+        norm2 = _mm256_add_epi32(norm2, _mm256_madd_epi16(b, b));
+    }
+
+    VectorSums sums;
+    sums.corr = static_cast<int32_t>(HorizontalSum256(corr));
+    sums.norm1 = HorizontalSum256(norm1);
+    sums.norm2 = HorizontalSum256(norm2);
+    AddScalarTail(T1, T2, i, vec_length, sums);
+    return sums;
+}
+
+RSID_TARGET("avx2") static int32_t DotProductAvx2(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    // two independent accumulators to hide the pmaddwd latency.
+    __m256i corr0 = _mm256_setzero_si256();
+    __m256i corr1 = _mm256_setzero_si256();
+
+    uint32_t i = 0;
+    for (; i + 32 <= vec_length; i += 32)
+    {
+        __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(T1 + i));
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(T2 + i));
+        __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(T1 + i + 16));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(T2 + i + 16));
+        corr0 = _mm256_add_epi32(corr0, _mm256_madd_epi16(a0, b0));
+        corr1 = _mm256_add_epi32(corr1, _mm256_madd_epi16(a1, b1));
+    }
+    for (; i + 16 <= vec_length; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(T1 + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(T2 + i));
+        corr0 = _mm256_add_epi32(corr0, _mm256_madd_epi16(a, b));
+    }
+
+    uint32_t result = HorizontalSum256(_mm256_add_epi32(corr0, corr1)) +
+                      static_cast<uint32_t>(DotProductScalar(T1 + i, T2 + i, vec_length - i));
+    return static_cast<int32_t>(result);
+}
+
+RSID_TARGET("sse4.1") static void DotProduct4Sse41(const feature_t* gallery_vec, const feature_t* const probes[4],
+                                                  uint32_t vec_length, int32_t out[4])
+{
+    __m128i corr[4] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+
+    uint32_t i = 0;
+    for (; i + 8 <= vec_length; i += 8)
+    {
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gallery_vec + i));
+        for (int p = 0; p < 4; p++)
+        {
+            __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(probes[p] + i));
+            corr[p] = _mm_add_epi32(corr[p], _mm_madd_epi16(q, g));
+        }
+    }
+
+    for (int p = 0; p < 4; p++)
+    {
+        out[p] = static_cast<int32_t>(HorizontalSum128(corr[p]));
+    }
+    AddScalarTail4(gallery_vec, probes, i, vec_length, out);
+}
+
+RSID_TARGET("avx2") static void DotProduct4Avx2(const feature_t* gallery_vec, const feature_t* const probes[4],
+                                                uint32_t vec_length, int32_t out[4])
+{
+    __m256i corr0 = _mm256_setzero_si256();
+    __m256i corr1 = _mm256_setzero_si256();
+    __m256i corr2 = _mm256_setzero_si256();
+    __m256i corr3 = _mm256_setzero_si256();
+
+    uint32_t i = 0;
+    for (; i + 16 <= vec_length; i += 16)
+    {
+        __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gallery_vec + i));
+        __m256i q0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(probes[0] + i));
+        __m256i q1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(probes[1] + i));
+        __m256i q2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(probes[2] + i));
+        __m256i q3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(probes[3] + i));
+        corr0 = _mm256_add_epi32(corr0, _mm256_madd_epi16(q0, g));
+        corr1 = _mm256_add_epi32(corr1, _mm256_madd_epi16(q1, g));
+        corr2 = _mm256_add_epi32(corr2, _mm256_madd_epi16(q2, g));
+        corr3 = _mm256_add_epi32(corr3, _mm256_madd_epi16(q3, g));
+    }
+
+    out[0] = static_cast<int32_t>(HorizontalSum256(corr0));
+    out[1] = static_cast<int32_t>(HorizontalSum256(corr1));
+    out[2] = static_cast<int32_t>(HorizontalSum256(corr2));
+    out[3] = static_cast<int32_t>(HorizontalSum256(corr3));
+    AddScalarTail4(gallery_vec, probes, i, vec_length, out);
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+RSID_TARGET("popcnt") static void HammingDistances256Popcnt(const uint64_t* query_code, const uint64_t* codes,
+                                                            std::size_t count, uint16_t* distances)
+{
+    const uint64_t q0 = query_code[0], q1 = query_code[1], q2 = query_code[2], q3 = query_code[3];
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const uint64_t* code = codes + i * s_codeWords;
+        uint64_t distance = _mm_popcnt_u64(q0 ^ code[0]) + _mm_popcnt_u64(q1 ^ code[1]) +
+                            _mm_popcnt_u64(q2 ^ code[2]) + _mm_popcnt_u64(q3 ^ code[3]);
+        distances[i] = static_cast<uint16_t>(distance);
+    }
+}
+#endif
+
+static void CpuId(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++)
+    {
+        regs[i] = static_cast<uint32_t>(info[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t XGetBv()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif // RSID_MATCHER_X86
+
+#ifdef RSID_MATCHER_NEON
+static inline uint32_t HorizontalSumNeon(int32x4_t v)
+{
+    uint32x4_t u = vreinterpretq_u32_s32(v);
+    return vgetq_lane_u32(u, 0) + vgetq_lane_u32(u, 1) + vgetq_lane_u32(u, 2) + vgetq_lane_u32(u, 3);
+}
+
+static VectorSums ComputeSumsNeon(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    int32x4_t corr = vdupq_n_s32(0);
+    int32x4_t norm1 = vdupq_n_s32(0);
+    int32x4_t norm2 = vdupq_n_s32(0);
+
+    uint32_t i = 0;
+    for (; i + 8 <= vec_length; i += 8)
+    {
+        int16x8_t a = vld1q_s16(T1 + i);
+        int16x8_t b = vld1q_s16(T2 + i);
+
+        corr = vmlal_s16(corr, vget_low_s16(a), vget_low_s16(b));
+        corr = vmlal_s16(corr, vget_high_s16(a), vget_high_s16(b));
+        norm1 = vmlal_s16(norm1, vget_low_s16(a), vget_low_s16(a));
+        norm1 = vmlal_s16(norm1, vget_high_s16(a), vget_high_s16(a));
+        norm2 = vmlal_s16(norm2, vget_low_s16(b), vget_low_s16(b));
+        norm2 = vmlal_s16(norm2, vget_high_s16(b), vget_high_s16(b));
+    }
+
+    VectorSums sums;
+    sums.corr = static_cast<int32_t>(HorizontalSumNeon(corr));
+    sums.norm1 = HorizontalSumNeon(norm1);
+    sums.norm2 = HorizontalSumNeon(norm2);
+    AddScalarTail(T1, T2, i, vec_length, sums);
+    return sums;
+}
+
+static int32_t DotProductNeon(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    int32x4_t corr = vdupq_n_s32(0);
+
+    uint32_t i = 0;
+    for (; i + 8 <= vec_length; i += 8)
+    {
+        int16x8_t a = vld1q_s16(T1 + i);
+        int16x8_t b = vld1q_s16(T2 + i);
+        corr = vmlal_s16(corr, vget_low_s16(a), vget_low_s16(b));
+        corr = vmlal_s16(corr, vget_high_s16(a), vget_high_s16(b));
+    }
+
+    uint32_t result = HorizontalSumNeon(corr) + static_cast<uint32_t>(DotProductScalar(T1 + i, T2 + i, vec_length - i));
+    return static_cast<int32_t>(result);
+}
+
+static void DotProduct4Neon(const feature_t* gallery_vec, const feature_t* const probes[4], uint32_t vec_length,
+                            int32_t out[4])
+{
+    int32x4_t corr[4] = {vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0)};
+
+    uint32_t i = 0;
+    for (; i + 8 <= vec_length; i += 8)
+    {
+        int16x8_t g = vld1q_s16(gallery_vec + i);
+        for (int p = 0; p < 4; p++)
+        {
+            int16x8_t q = vld1q_s16(probes[p] + i);
+            corr[p] = vmlal_s16(corr[p], vget_low_s16(q), vget_low_s16(g));
+            corr[p] = vmlal_s16(corr[p], vget_high_s16(q), vget_high_s16(g));
+        }
+    }
+
+    for (int p = 0; p < 4; p++)
+    {
+        out[p] = static_cast<int32_t>(HorizontalSumNeon(corr[p]));
+    }
+    AddScalarTail4(gallery_vec, probes, i, vec_length, out);
+}
+
+static void HammingDistances256Neon(const uint64_t* query_code, const uint64_t* codes, std::size_t count,
+                                    uint16_t* distances)
+{
+    const uint8x16_t q_low = vreinterpretq_u8_u64(vld1q_u64(query_code));
+    const uint8x16_t q_high = vreinterpretq_u8_u64(vld1q_u64(query_code + 2));
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const uint64_t* code = codes + i * s_codeWords;
+        uint8x16_t x_low = veorq_u8(q_low, vreinterpretq_u8_u64(vld1q_u64(code)));
+        uint8x16_t x_high = veorq_u8(q_high, vreinterpretq_u8_u64(vld1q_u64(code + 2)));
+        uint16x8_t bits = vpaddlq_u8(vaddq_u8(vcntq_u8(x_low), vcntq_u8(x_high)));
+        uint64x2_t sum = vpaddlq_u32(vpaddlq_u16(bits));
+        distances[i] = static_cast<uint16_t>(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+    }
+}
+#endif // RSID_MATCHER_NEON
+
+Isa DetectIsa()
+{
+#if defined(RSID_MATCHER_X86)
+    uint32_t regs[4] = {0};
+    CpuId(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+    if (max_leaf < 1)
+    {
+        return Isa::Scalar;
+    }
+
+    CpuId(1, 0, regs);
+    const bool has_sse41 = (regs[2] & (1u << 19)) != 0;
+    const bool has_osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool has_avx = (regs[2] & (1u << 28)) != 0;
+
+    bool has_avx2 = false;
+    // avx2 requires the os to save the ymm registers on context switch (xcr0 bits 1,2).
+    if (max_leaf >= 7 && has_osxsave && has_avx && ((XGetBv() & 0x6) == 0x6))
+    {
+        CpuId(7, 0, regs);
+        has_avx2 = (regs[1] & (1u << 5)) != 0;
+    }
+
+    if (has_avx2)
+    {
+        return Isa::Avx2;
+    }
+    return has_sse41 ? Isa::Sse41 : Isa::Scalar;
+#elif defined(RSID_MATCHER_NEON)
+    return Isa::Neon;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+static sums_func_t GetSumsFunc(Isa isa)
+{
+    // never return a kernel the cpu can't run
+    Isa supported = DetectIsa();
+    switch (isa)
+    {
+#if defined(RSID_MATCHER_X86)
+    case Isa::Avx2:
+        if (supported == Isa::Avx2)
+        {
+            return &ComputeSumsAvx2;
+        }
+        return supported == Isa::Sse41 ? &ComputeSumsSse41 : &ComputeSumsScalar;
+    case Isa::Sse41:
+        return (supported == Isa::Avx2 || supported == Isa::Sse41) ? &ComputeSumsSse41 : &ComputeSumsScalar;
+#elif defined(RSID_MATCHER_NEON)
+    case Isa::Neon:
+        return &ComputeSumsNeon;
+#endif
+    default:
+        return &ComputeSumsScalar;
+    }
+}
+
+static dot_func_t GetDotFunc(Isa isa)
+{
+    switch (isa)
+    {
+#if defined(RSID_MATCHER_X86)
+    case Isa::Avx2:
+        return &DotProductAvx2;
+    case Isa::Sse41:
+        return &DotProductSse41;
+#elif defined(RSID_MATCHER_NEON)
+    case Isa::Neon:
+        return &DotProductNeon;
+#endif
+    default:
+        return &DotProductScalar;
+    }
+}
+
+static hamming_func_t GetHammingFunc(Isa isa)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    // popcnt has its own cpuid bit (leaf 1, ecx bit 23), independent of the vector extensions.
+    uint32_t regs[4] = {0};
+    CpuId(1, 0, regs);
+    if ((regs[2] & (1u << 23)) != 0)
+    {
+        return &HammingDistances256Popcnt;
+    }
+#elif defined(RSID_MATCHER_NEON)
+    if (isa == Isa::Neon)
+    {
+        return &HammingDistances256Neon;
+    }
+#endif
+    (void)isa;
+    return &HammingDistances256Scalar;
+}
+
+static dot4_func_t GetDot4Func(Isa isa)
+{
+    switch (isa)
+    {
+#if defined(RSID_MATCHER_X86)
+    case Isa::Avx2:
+        return &DotProduct4Avx2;
+    case Isa::Sse41:
+        return &DotProduct4Sse41;
+#elif defined(RSID_MATCHER_NEON)
+    case Isa::Neon:
+        return &DotProduct4Neon;
+#endif
+    default:
+        return &DotProduct4Scalar;
+    }
+}
+
+struct Dispatch
+{
+    Isa isa;
+    sums_func_t sums_func;
+    dot_func_t dot_func;
+    dot4_func_t dot4_func;
+    hamming_func_t hamming_func;
+
+    Dispatch()
+    {
+        isa = DetectIsa();
+        sums_func = GetSumsFunc(isa);
+        dot_func = GetDotFunc(isa);
+        dot4_func = GetDot4Func(isa);
+        hamming_func = GetHammingFunc(isa);
+    }
+};
+
+static const Dispatch& GetDispatch()
+{
+    static const Dispatch dispatch;
+    return dispatch;
+}
+
+Isa ActiveIsa()
+{
+    return GetDispatch().isa;
+}
+
+const char* IsaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Sse41:
+        return "sse4.1";
+    case Isa::Avx2:
+        return "avx2";
+    case Isa::Neon:
+        return "neon";
+    default:
+        return "scalar";
+    }
+}
+
+VectorSums ComputeSums(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    return GetDispatch().sums_func(T1, T2, vec_length);
+}
+
+VectorSums ComputeSums(const feature_t* T1, const feature_t* T2, uint32_t vec_length, Isa isa)
+{
+    return GetSumsFunc(isa)(T1, T2, vec_length);
+}
+
+int32_t DotProduct(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    return GetDispatch().dot_func(T1, T2, vec_length);
+}
+
+void DotProduct4(const feature_t* gallery_vec, const feature_t* const probes[4], uint32_t vec_length, int32_t out[4])
+{
+    GetDispatch().dot4_func(gallery_vec, probes, vec_length, out);
+}
+
+void HammingDistances256(const uint64_t* query_code, const uint64_t* codes, std::size_t count, uint16_t* distances)
+{
+    GetDispatch().hamming_func(query_code, codes, count, distances);
+}
+} // namespace MatcherSimd
+} // namespace RealSenseID
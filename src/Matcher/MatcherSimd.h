@@ -0,0 +1,64 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "RealSenseID/Faceprints.h"
+#include <cstddef>
+#include <cstdint>
+
+// SIMD kernels for the integer ncc used by the matcher.
+// All kernels produce exactly the same sums as the scalar reference implementation (integer arithmetic only),
+// so scores are bit-identical regardless of the instruction set selected at runtime.
+namespace RealSenseID
+{
+namespace MatcherSimd
+{
+enum class Isa
+{
+    Scalar,
+    Sse41,
+    Avx2,
+    Neon
+};
+
+struct VectorSums
+{
+    int32_t corr = 0;
+    uint32_t norm1 = 0;
+    uint32_t norm2 = 0;
+};
+
+// best instruction set supported by the running cpu (detected once, using cpuid on x86).
+Isa DetectIsa();
+
+// instruction set used by the dispatched kernels below.
+Isa ActiveIsa();
+
+const char* IsaName(Isa isa);
+
+// dot product and both squared norms of T1, T2 - using the dispatched kernel.
+VectorSums ComputeSums(const feature_t* T1, const feature_t* T2, uint32_t vec_length);
+
+// same as above, but with explicit instruction set (falls back to scalar if not supported by this build/cpu).
+VectorSums ComputeSums(const feature_t* T1, const feature_t* T2, uint32_t vec_length, Isa isa);
+
+// dot product only - for searching against gallery vectors with precomputed norms.
+int32_t DotProduct(const feature_t* T1, const feature_t* T2, uint32_t vec_length);
+
+// dot products of one gallery vector with 4 probes - the gallery vector is loaded once for all of them.
+// used by the batch (many probes x gallery) search.
+void DotProduct4(const feature_t* gallery_vec, const feature_t* const probes[4], uint32_t vec_length, int32_t out[4]);
+
+// hamming distances between a 256-bit query code and count 256-bit codes (4 x uint64 each).
+void HammingDistances256(const uint64_t* query_code, const uint64_t* codes, std::size_t count, uint16_t* distances);
+
+// scalar reference implementations.
+VectorSums ComputeSumsScalar(const feature_t* T1, const feature_t* T2, uint32_t vec_length);
+int32_t DotProductScalar(const feature_t* T1, const feature_t* T2, uint32_t vec_length);
+void DotProduct4Scalar(const feature_t* gallery_vec, const feature_t* const probes[4], uint32_t vec_length,
+                       int32_t out[4]);
+void HammingDistances256Scalar(const uint64_t* query_code, const uint64_t* codes, std::size_t count,
+                               uint16_t* distances);
+} // namespace MatcherSimd
+} // namespace RealSenseID
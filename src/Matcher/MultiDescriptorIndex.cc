@@ -0,0 +1,212 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "MultiDescriptorIndex.h"
+#include "Gallery.h"
+#include "MatcherSimd.h"
+#include "Logger.h"
+#include <algorithm>
+#include <limits>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "MultiDescriptorIndex";
+
+constexpr uint32_t MultiDescriptorIndex::NumberOfDescriptors;
+
+namespace
+{
+// descriptor pair scored for a probe type.
+struct DescriptorPair
+{
+    GalleryDescriptor descriptor;
+    match_calc_t threshold;
+};
+} // namespace
+
+static const feature_t* GetDescriptor(const Faceprints& faceprints, GalleryDescriptor descriptor)
+{
+    switch (descriptor)
+    {
+    case GalleryDescriptor::AdaptiveWithMask:
+        return &faceprints.adaptiveDescriptorWithMask[0];
+    case GalleryDescriptor::Enrollment:
+        return &faceprints.enrollmentDescriptor[0];
+    default:
+        return &faceprints.adaptiveDescriptorWithoutMask[0];
+    }
+}
+
+// same range check as Matcher::ValidateFaceprints(), for any descriptor.
+static bool IsInRange(const feature_t* vec)
+{
+    for (uint32_t i = 0; i < Gallery::VectorLength; i++)
+    {
+        if (vec[i] > RSID_MAX_FEATURE_VALUE || vec[i] < -RSID_MAX_FEATURE_VALUE)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MultiDescriptorIndex::Build(const Gallery& gallery)
+{
+    _norms.assign(gallery.Size() * NumberOfDescriptors, 0);
+    for (std::size_t i = 0; i < gallery.Size(); i++)
+    {
+        SetUser(gallery, i);
+    }
+}
+
+bool MultiDescriptorIndex::Update(const Gallery& gallery, std::size_t index)
+{
+    _norms.resize(gallery.Size() * NumberOfDescriptors, 0);
+    if (index < gallery.Size())
+    {
+        SetUser(gallery, index);
+    }
+    return true;
+}
+
+void MultiDescriptorIndex::SetUser(const Gallery& gallery, std::size_t index)
+{
+    uint32_t* norms = &_norms[index * NumberOfDescriptors];
+    const Faceprints& faceprints = gallery.GetFaceprints(index);
+
+    // the search descriptor was validated at insert.
+    norms[static_cast<int>(GalleryDescriptor::AdaptiveWithoutMask)] = gallery.IsValid(index) ? gallery.Norm(index) : 0;
+
+    for (auto descriptor : {GalleryDescriptor::AdaptiveWithMask, GalleryDescriptor::Enrollment})
+    {
+        const feature_t* vec = GetDescriptor(faceprints, descriptor);
+        uint32_t norm = 0;
+        if (IsInRange(vec))
+        {
+            norm = MatcherSimd::ComputeSums(vec, vec, Gallery::VectorLength).norm1;
+        }
+        else
+        {
+            LOG_ERROR(LOG_TAG, "Descriptor %d of user %zu failed range validation, skipped in search",
+                      static_cast<int>(descriptor), index);
+        }
+        norms[static_cast<int>(descriptor)] = norm;
+    }
+}
+
+DescriptorMatch MultiDescriptorIndex::Search(const Gallery& gallery, const feature_t* query, bool probe_has_mask,
+                                             const Thresholds& thresholds, MatchSearchMode mode) const
+{
+    DescriptorMatch best;
+
+    DescriptorPair pairs[NumberOfDescriptors];
+    uint32_t number_of_pairs = 0;
+    if (probe_has_mask)
+    {
+        pairs[number_of_pairs++] = {GalleryDescriptor::AdaptiveWithMask, thresholds.strongThreshold_pMgM};
+        pairs[number_of_pairs++] = {GalleryDescriptor::AdaptiveWithoutMask, thresholds.strongThreshold_pMgNM};
+        pairs[number_of_pairs++] = {GalleryDescriptor::Enrollment, thresholds.strongThreshold_pMgNM};
+    }
+    else
+    {
+        pairs[number_of_pairs++] = {GalleryDescriptor::AdaptiveWithoutMask, thresholds.strongThreshold_pNMgNM};
+        pairs[number_of_pairs++] = {GalleryDescriptor::Enrollment, thresholds.strongThreshold_pNMgNM};
+    }
+
+    const uint32_t vec_length = Gallery::VectorLength;
+    const uint32_t query_norm = MatcherSimd::ComputeSums(query, query, vec_length).norm1;
+    const bool early_exit = (mode == MatchSearchMode::FirstAboveThreshold);
+    int best_margin = std::numeric_limits<int>::min();
+
+    const std::size_t number_of_users = std::min(Size(), gallery.Size());
+    for (std::size_t i = 0; i < number_of_users; i++)
+    {
+        // invalid users were reported at insert.
+        if (!gallery.IsValid(i))
+        {
+            continue;
+        }
+
+        const uint32_t* norms = &_norms[i * NumberOfDescriptors];
+        const Faceprints& faceprints = gallery.GetFaceprints(i);
+
+        // the descriptors of all pairs in one sweep (unused slots repeat the last one, which is already in cache).
+        const feature_t* descriptors[4];
+        for (uint32_t p = 0; p < 4; p++)
+        {
+            descriptors[p] = GetDescriptor(faceprints, pairs[std::min(p, number_of_pairs - 1)].descriptor);
+        }
+        int32_t corr[4];
+        MatcherSimd::DotProduct4(query, descriptors, vec_length, corr);
+
+        bool above_threshold = false;
+        for (uint32_t p = 0; p < number_of_pairs; p++)
+        {
+            const int d = static_cast<int>(pairs[p].descriptor);
+            if (norms[d] == 0)
+            {
+                continue;
+            }
+
+            match_calc_t score = Matcher::NormalizeScore(corr[p], query_norm, norms[d]);
+            int margin = static_cast<int>(score) - pairs[p].threshold;
+            above_threshold = above_threshold || (margin > 0);
+            if (score > 0 && margin > best_margin)
+            {
+                best_margin = margin;
+                best.id = static_cast<int>(i);
+                best.score = score;
+                best.threshold = pairs[p].threshold;
+                best.descriptor = pairs[p].descriptor;
+            }
+        }
+
+        if (early_exit && above_threshold)
+        {
+            break;
+        }
+    }
+
+    return best;
+}
+
+ExtendedMatchResult MultiDescriptorIndex::Match(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                Faceprints& updated_faceprints, const Thresholds& thresholds,
+                                                MatchSearchMode mode, DescriptorMatch* match) const
+{
+    if (!Matcher::ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return ExtendedMatchResult();
+    }
+
+    if (Size() != gallery.Size())
+    {
+        LOG_ERROR(LOG_TAG, "Index is not in sync with the gallery (%zu vs %zu users)", Size(), gallery.Size());
+        return ExtendedMatchResult();
+    }
+
+    const bool has_mask = HasMask(new_faceprints);
+    DescriptorMatch best =
+        Search(gallery, &new_faceprints.adaptiveDescriptorWithoutMask[0], has_mask, thresholds, mode);
+    if (match != nullptr)
+    {
+        *match = best;
+    }
+
+    ExtendedMatchResult result;
+    result.maxScore = best.score;
+    result.userId = best.id;
+    result.isSame = (best.id >= 0) && (best.score > best.threshold);
+    result.isIdentical = best.score > (has_mask ? thresholds.identicalThreshold_M : thresholds.identicalThreshold_NM);
+    result.confidence = Matcher::CalculateConfidence(best.score, best.threshold, result);
+    result.should_update = !has_mask && result.isSame && (best.score >= thresholds.updateThreshold_NM);
+
+    if (result.should_update)
+    {
+        Matcher::UpdateAdaptiveFaceprints(new_faceprints, gallery.GetFaceprints(static_cast<std::size_t>(best.id)),
+                                          updated_faceprints, thresholds);
+    }
+
+    return result;
+}
+} // namespace RealSenseID
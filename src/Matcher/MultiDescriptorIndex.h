@@ -0,0 +1,90 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RealSenseID
+{
+class Gallery;
+
+// descriptors of a gallery user's faceprints.
+enum class GalleryDescriptor : uint8_t
+{
+    AdaptiveWithoutMask = 0,
+    AdaptiveWithMask = 1,
+    Enrollment = 2
+};
+
+// best gallery user of a mask-aware search, with the descriptor pair that decided it.
+struct DescriptorMatch
+{
+    int id = -1;                // gallery index (-1 if no descriptor scored above 0)
+    match_calc_t score = 0;     // score of the deciding pair
+    match_calc_t threshold = 0; // strong threshold of the deciding pair
+    GalleryDescriptor descriptor = GalleryDescriptor::AdaptiveWithoutMask;
+};
+
+// Mask-aware gallery search: the probe is scored against all relevant descriptors of every user, and each descriptor
+// pair is decided with its own strong threshold:
+//   probe without mask: adaptive without mask, enrollment                  (strongThreshold_pNMgNM)
+//   probe with mask:    adaptive with mask                                 (strongThreshold_pMgM)
+//                       adaptive without mask, enrollment                  (strongThreshold_pMgNM)
+// A user matches if any pair exceeds its threshold. Users are ranked by their best score above threshold (score minus
+// threshold of the pair), so with equal thresholds the best user is the one with the highest score.
+//
+// The three descriptors of a user are adjacent in its faceprints, and they are scored together in a single sweep
+// (MatcherSimd::DotProduct4 - each probe chunk is loaded once for all of them). The probe norm is computed once per
+// query, the descriptor norms once per user (Build/Update). Empty descriptors (e.g. a user without an adaptive with-mask
+// vector yet) and descriptors that fail range validation are skipped.
+//
+// The probe has a mask if its hasMask element (RSID_INDEX_IN_FEATURS_VECTOR_HAS_MASK) is set.
+class MultiDescriptorIndex
+{
+public:
+    static constexpr uint32_t NumberOfDescriptors = 3;
+
+    MultiDescriptorIndex() = default;
+
+    // norms of every user's descriptors.
+    void Build(const Gallery& gallery);
+
+    // refresh user index from the gallery after Gallery::Add/Update/Remove (Remove moves the last user into the removed
+    // index). the index is resized to the gallery size.
+    bool Update(const Gallery& gallery, std::size_t index);
+
+    std::size_t Size() const
+    {
+        return _norms.size() / NumberOfDescriptors;
+    }
+
+    static bool HasMask(const Faceprints& faceprints)
+    {
+        return faceprints.adaptiveDescriptorWithoutMask[RSID_INDEX_IN_FEATURS_VECTOR_HAS_MASK] != 0;
+    }
+
+    // best user. with MatchSearchMode::FirstAboveThreshold the scan stops at the first user with a pair above its
+    // threshold.
+    DescriptorMatch Search(const Gallery& gallery, const feature_t* query, bool probe_has_mask,
+                           const Thresholds& thresholds,
+                           MatchSearchMode mode = MatchSearchMode::FirstAboveThreshold) const;
+
+    // mask-aware Matcher::MatchFaceprintsToGallery(): isSame and confidence use the threshold of the deciding pair,
+    // isIdentical the identical threshold of the probe type. the adaptive (without mask) vector is updated as in
+    // MatchFaceprintsToGallery() for probes without mask - there is no adaptive update of the with-mask vector yet.
+    ExtendedMatchResult Match(const Faceprints& new_faceprints, const Gallery& gallery, Faceprints& updated_faceprints,
+                              const Thresholds& thresholds,
+                              MatchSearchMode mode = MatchSearchMode::FirstAboveThreshold,
+                              DescriptorMatch* match = nullptr) const;
+
+private:
+    void SetUser(const Gallery& gallery, std::size_t index);
+
+    // NumberOfDescriptors per user, in GalleryDescriptor order. 0 for descriptors that are skipped.
+    std::vector<uint32_t> _norms;
+};
+} // namespace RealSenseID
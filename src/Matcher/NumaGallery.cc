@@ -0,0 +1,441 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "NumaGallery.h"
+#include "Gallery.h"
+#include "MatcherSimd.h"
+#include "Logger.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "NumaGallery";
+
+constexpr std::size_t NumaGallery::ChunkSize;
+
+// Threads pinned to one node. A job runs once on every thread (job(thread_index)); Start() returns immediately so
+// jobs of several nodes run at the same time, Wait() blocks until the job completed. Jobs are serialized: Start()
+// returns the job lock, which the caller passes to Wait(), and the next Start() waits until then.
+class NumaGallery::NodeWorkers
+{
+public:
+    NodeWorkers(const NumaNode& node, std::size_t num_threads)
+    {
+        _threads.reserve(num_threads);
+        for (std::size_t i = 0; i < num_threads; i++)
+        {
+            _threads.emplace_back(&NodeWorkers::ThreadLoop, this, i, node.cpus);
+        }
+
+        // pinning is reported, so wait for all threads to try it.
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done_cv.wait(lock, [&] { return _started == _threads.size(); });
+    }
+
+    ~NodeWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _work_cv.notify_all();
+
+        for (auto& thread : _threads)
+        {
+            thread.join();
+        }
+    }
+
+    std::size_t NumThreads() const
+    {
+        return _threads.size();
+    }
+
+    std::size_t NumPinned() const
+    {
+        return _pinned;
+    }
+
+    std::unique_lock<std::mutex> Start(std::function<void(std::size_t)> job)
+    {
+        std::unique_lock<std::mutex> job_lock(_job_mutex);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _job = std::move(job);
+            _pending = _threads.size();
+            _generation++;
+        }
+        _work_cv.notify_all();
+        return job_lock;
+    }
+
+    // job_lock is the lock returned by Start(), released when the job completed.
+    void Wait(std::unique_lock<std::mutex> job_lock)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _done_cv.wait(lock, [this] { return _pending == 0; });
+            _job = nullptr;
+        }
+        job_lock.unlock();
+    }
+
+private:
+    void ThreadLoop(std::size_t index, std::vector<int> cpus)
+    {
+        bool pinned = PinCurrentThread(cpus);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pinned += pinned ? 1 : 0;
+            _started++;
+        }
+        _done_cv.notify_all();
+
+        uint64_t seen_generation = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _work_cv.wait(lock, [&] { return _stop || _generation != seen_generation; });
+                if (_stop)
+                {
+                    return;
+                }
+                seen_generation = _generation;
+            }
+
+            // _job is not modified until all threads checked in.
+            _job(index);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_pending == 0)
+            {
+                _done_cv.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> _threads;
+
+    std::mutex _job_mutex; // serializes jobs
+    std::mutex _mutex;
+    std::condition_variable _work_cv;
+    std::condition_variable _done_cv;
+
+    std::function<void(std::size_t)> _job;
+    std::size_t _pending = 0;
+    std::size_t _started = 0;
+    std::size_t _pinned = 0;
+    uint64_t _generation = 0;
+    bool _stop = false;
+};
+
+struct NumaGallery::Node
+{
+    NumaNode topology;
+    std::unique_ptr<NodeWorkers> workers;
+
+    // search data of gallery indices [begin, end): descriptors, then norms, then valid flags, in one buffer.
+    PlacedBuffer memory;
+    feature_t* descriptors = nullptr;
+    uint32_t* norms = nullptr;
+    uint8_t* valid = nullptr;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+};
+
+// scan state of one query on one node, owned by the query (the node may start the next query's scan as soon as this
+// one completed).
+struct NumaGallery::Scan
+{
+    std::atomic<std::size_t> next_chunk {0};
+    std::vector<TagResult> thread_best;
+    std::unique_lock<std::mutex> job_lock; // node's job lock, held from StartScan() to WaitScan()
+};
+
+NumaGallery::NumaGallery(const Config& config) : _config(config)
+{
+    std::vector<NumaNode> topology = DiscoverNumaNodes();
+    if (_config.max_nodes > 0 && topology.size() > _config.max_nodes)
+    {
+        topology.resize(_config.max_nodes);
+    }
+
+    for (const auto& numa_node : topology)
+    {
+        std::size_t threads = _config.threads_per_node > 0 ? _config.threads_per_node : numa_node.cpus.size();
+        std::unique_ptr<Node> node(new Node());
+        node->topology = numa_node;
+        node->workers.reset(new NodeWorkers(numa_node, std::max<std::size_t>(threads, 1)));
+        _nodes.push_back(std::move(node));
+    }
+}
+
+NumaGallery::~NumaGallery() = default;
+
+std::vector<NumaGallery::NodeInfo> NumaGallery::Nodes() const
+{
+    std::vector<NodeInfo> nodes;
+    for (const auto& node : _nodes)
+    {
+        NodeInfo info;
+        info.node = node->topology.id;
+        info.threads = node->workers->NumThreads();
+        info.pinned_threads = node->workers->NumPinned();
+        info.begin = node->begin;
+        info.end = node->end;
+        info.bytes = node->memory.Bytes();
+        info.backing = node->memory.Backing();
+        info.bound = node->memory.IsBound();
+        nodes.push_back(info);
+    }
+    return nodes;
+}
+
+bool NumaGallery::Build(const Gallery& gallery)
+{
+    _size = 0;
+    const std::size_t number_of_users = gallery.Size();
+
+    std::size_t total_threads = 0;
+    for (const auto& node : _nodes)
+    {
+        total_threads += node->workers->NumThreads();
+    }
+
+    // partitions are proportional to the node's threads, so all nodes finish a scan at the same time.
+    std::size_t threads_before = 0;
+    for (auto& node : _nodes)
+    {
+        if (_config.mode == NumaMode::Partition)
+        {
+            node->begin = number_of_users * threads_before / total_threads;
+            threads_before += node->workers->NumThreads();
+            node->end = number_of_users * threads_before / total_threads;
+        }
+        else
+        {
+            node->begin = 0;
+            node->end = number_of_users;
+        }
+
+        node->memory.Free();
+        node->descriptors = nullptr;
+        node->norms = nullptr;
+        node->valid = nullptr;
+
+        const std::size_t rows = node->end - node->begin;
+        if (rows == 0)
+        {
+            continue;
+        }
+
+        const std::size_t descriptor_bytes = rows * Gallery::DescriptorStride * sizeof(feature_t);
+        const std::size_t bytes = descriptor_bytes + rows * sizeof(uint32_t) + rows * sizeof(uint8_t);
+        if (!node->memory.Allocate(bytes, _config.huge_pages, _config.bind_memory ? node->topology.id : -1))
+        {
+            LOG_ERROR(LOG_TAG, "Failed to allocate %zu bytes for node %d", bytes, node->topology.id);
+            return false;
+        }
+
+        char* data = static_cast<char*>(node->memory.Data());
+        node->descriptors = reinterpret_cast<feature_t*>(data);
+        node->norms = reinterpret_cast<uint32_t*>(data + descriptor_bytes);
+        node->valid = reinterpret_cast<uint8_t*>(data + descriptor_bytes + rows * sizeof(uint32_t));
+    }
+
+    // the node's own threads write (first touch) its copy.
+    std::vector<std::unique_lock<std::mutex>> job_locks;
+    job_locks.reserve(_nodes.size());
+    for (auto& node : _nodes)
+    {
+        Node* target = node.get();
+        const std::size_t threads = target->workers->NumThreads();
+        job_locks.push_back(target->workers->Start([this, target, threads, &gallery](std::size_t thread) {
+            const std::size_t rows = target->end - target->begin;
+            CopyRows(*target, gallery, target->begin + rows * thread / threads,
+                     target->begin + rows * (thread + 1) / threads);
+        }));
+    }
+    for (std::size_t n = 0; n < _nodes.size(); n++)
+    {
+        _nodes[n]->workers->Wait(std::move(job_locks[n]));
+    }
+
+    _size = number_of_users;
+    return true;
+}
+
+bool NumaGallery::Update(const Gallery& gallery, std::size_t index)
+{
+    if (gallery.Size() != _size)
+    {
+        return Build(gallery);
+    }
+
+    for (auto& node : _nodes)
+    {
+        if (index >= node->begin && index < node->end)
+        {
+            CopyRows(*node, gallery, index, index + 1);
+        }
+    }
+    return true;
+}
+
+void NumaGallery::CopyRows(Node& node, const Gallery& gallery, std::size_t begin, std::size_t end)
+{
+    for (std::size_t i = begin; i < end; i++)
+    {
+        const std::size_t row = i - node.begin;
+        ::memcpy(&node.descriptors[row * Gallery::DescriptorStride], gallery.Descriptor(i),
+                 Gallery::DescriptorStride * sizeof(feature_t));
+        node.norms[row] = gallery.Norm(i);
+        node.valid[row] = gallery.IsValid(i) ? 1 : 0;
+    }
+}
+
+void NumaGallery::StartScan(Node& node, const feature_t* query, uint32_t query_norm, match_calc_t threshold,
+                            bool early_exit, std::atomic<bool>& stop, Scan& scan)
+{
+    scan.thread_best.assign(node.workers->NumThreads(), TagResult());
+    Node* target = &node;
+    Scan* state = &scan;
+    std::atomic<bool>* stop_flag = &stop;
+
+    scan.job_lock = node.workers->Start([=](std::size_t thread) {
+        const uint32_t vec_length = Gallery::VectorLength;
+        const std::size_t rows = target->end - target->begin;
+        TagResult best;
+        best.score = 0;
+        best.id = -1;
+
+        for (;;)
+        {
+            const std::size_t begin = state->next_chunk.fetch_add(1) * ChunkSize;
+            if (begin >= rows)
+            {
+                break;
+            }
+            const std::size_t end = std::min(begin + ChunkSize, rows);
+
+            for (std::size_t row = begin; row < end; row++)
+            {
+                if (stop_flag->load(std::memory_order_relaxed))
+                {
+                    state->thread_best[thread] = best;
+                    return;
+                }
+
+                if (!target->valid[row])
+                {
+                    continue;
+                }
+
+                const feature_t* descriptor = &target->descriptors[row * Gallery::DescriptorStride];
+                int32_t corr = MatcherSimd::DotProduct(query, descriptor, vec_length);
+                match_calc_t score = Matcher::NormalizeScore(corr, query_norm, target->norms[row]);
+
+                if (score > best.score)
+                {
+                    best.score = score;
+                    best.id = static_cast<int>(target->begin + row);
+                }
+
+                if (early_exit && score > threshold)
+                {
+                    stop_flag->store(true, std::memory_order_relaxed);
+                    state->thread_best[thread] = best;
+                    return;
+                }
+            }
+        }
+
+        state->thread_best[thread] = best;
+    });
+}
+
+TagResult NumaGallery::WaitScan(Node& node, Scan& scan)
+{
+    node.workers->Wait(std::move(scan.job_lock));
+
+    // chunks are handed out dynamically - on equal scores keep the lowest index (same as the sequential scan).
+    TagResult best;
+    best.score = 0;
+    best.id = -1;
+    for (const auto& result : scan.thread_best)
+    {
+        if (result.score > best.score || (result.score == best.score && result.id >= 0 && result.id < best.id))
+        {
+            best = result;
+        }
+    }
+    return best;
+}
+
+TagResult NumaGallery::Search(const feature_t* query, match_calc_t threshold, MatchSearchMode mode)
+{
+    TagResult best;
+    best.score = 0;
+    best.id = -1;
+    if (_size == 0 || _nodes.empty())
+    {
+        return best;
+    }
+
+    const uint32_t query_norm = MatcherSimd::ComputeSums(query, query, Gallery::VectorLength).norm1;
+    const bool early_exit = (mode == MatchSearchMode::FirstAboveThreshold);
+    std::atomic<bool> stop {false};
+
+    if (_config.mode == NumaMode::Replicate)
+    {
+        Node& node = *_nodes[_next_node.fetch_add(1) % _nodes.size()];
+        Scan scan;
+        StartScan(node, query, query_norm, threshold, early_exit, stop, scan);
+        return WaitScan(node, scan);
+    }
+
+    // all nodes in node order (concurrent searches lock the nodes in the same order).
+    std::unique_ptr<Scan[]> scans(new Scan[_nodes.size()]);
+    for (std::size_t n = 0; n < _nodes.size(); n++)
+    {
+        StartScan(*_nodes[n], query, query_norm, threshold, early_exit, stop, scans[n]);
+    }
+
+    // partitions are in index order, so strict '>' keeps the lowest index on equal scores.
+    for (std::size_t n = 0; n < _nodes.size(); n++)
+    {
+        TagResult node_best = WaitScan(*_nodes[n], scans[n]);
+        if (node_best.score > best.score)
+        {
+            best = node_best;
+        }
+    }
+    return best;
+}
+
+ExtendedMatchResult NumaGallery::Match(const Faceprints& new_faceprints, const Gallery& gallery,
+                                       Faceprints& updated_faceprints, const Thresholds& thresholds,
+                                       MatchSearchMode mode)
+{
+    if (!Matcher::ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return ExtendedMatchResult();
+    }
+
+    if (Size() != gallery.Size())
+    {
+        LOG_ERROR(LOG_TAG, "Placed copy is not in sync with the gallery (%zu vs %zu users)", Size(), gallery.Size());
+        return ExtendedMatchResult();
+    }
+
+    TagResult scores =
+        Search(&new_faceprints.adaptiveDescriptorWithoutMask[0], thresholds.strongThreshold_pNMgNM, mode);
+    return Matcher::FinalizeGalleryMatch(new_faceprints, gallery, scores, updated_faceprints, thresholds);
+}
+} // namespace RealSenseID
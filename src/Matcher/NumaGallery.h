@@ -0,0 +1,110 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include "NumaPlacement.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace RealSenseID
+{
+class Gallery;
+
+enum class NumaMode
+{
+    Partition, // each node holds a slice of the gallery, a query is scanned by all nodes
+    Replicate  // each node holds the whole gallery, a query is scanned by one node (nodes serve queries in parallel)
+};
+
+// Copy of the gallery search data (descriptors, norms, valid flags) placed for large-gallery scans.
+//
+// Each NUMA node gets its own search threads, pinned to the node's cpus, and its own copy of its part of the search
+// data, allocated with the requested hugepage backing and bound to the node. The node's threads write the copy, so
+// the pages are local even where binding is not allowed. Scans then read local memory only, and hugepages remove most
+// of the TLB misses of streaming a gallery of hundreds of MB.
+//
+// Everything degrades gracefully: without NUMA information (single node machines, containers without /sys) there is
+// one node with all allowed cpus, hugepages fall back to transparent hugepages and then to regular pages, and pinning
+// or binding failures leave placement to the kernel. Nodes() reports what was obtained.
+//
+// Scores are identical to the gallery scan. Build() again after the gallery size changes; Update() refreshes a user.
+// Searches can run concurrently with each other (not with Build/Update).
+class NumaGallery
+{
+public:
+    // 2048 users x 512 bytes = 1MB of descriptors per task (same as ParallelMatcher shards).
+    static constexpr std::size_t ChunkSize = 2048;
+
+    struct Config
+    {
+        NumaMode mode = NumaMode::Partition;
+        HugePages huge_pages = HugePages::Transparent;
+        bool bind_memory = true;          // bind each copy to its node (first touch places it otherwise)
+        std::size_t threads_per_node = 0; // 0 - one thread per allowed cpu of the node
+        std::size_t max_nodes = 0;        // 0 - all nodes
+    };
+
+    // placement obtained for a node.
+    struct NodeInfo
+    {
+        int node = 0;
+        std::size_t threads = 0;
+        std::size_t pinned_threads = 0;
+        std::size_t begin = 0; // gallery indices held by the node
+        std::size_t end = 0;
+        std::size_t bytes = 0;
+        HugePages backing = HugePages::None;
+        bool bound = false;
+    };
+
+    explicit NumaGallery(const Config& config);
+    ~NumaGallery();
+
+    NumaGallery(const NumaGallery&) = delete;
+    NumaGallery& operator=(const NumaGallery&) = delete;
+
+    // copy the gallery search data to the nodes. returns false if memory could not be allocated.
+    bool Build(const Gallery& gallery);
+
+    // refresh user index after Gallery::Update (or Add/Remove, which rebuild as the size changed).
+    bool Update(const Gallery& gallery, std::size_t index);
+
+    std::size_t Size() const
+    {
+        return _size;
+    }
+
+    std::vector<NodeInfo> Nodes() const;
+
+    // best user, same as the gallery scan. with MatchSearchMode::FirstAboveThreshold the first node thread to cross
+    // the threshold stops the others (like ParallelMatcher, which user is returned then depends on timing).
+    TagResult Search(const feature_t* query, match_calc_t threshold, MatchSearchMode mode);
+
+    // same semantics as Matcher::MatchFaceprintsToGallery(). must be built from this gallery.
+    ExtendedMatchResult Match(const Faceprints& new_faceprints, const Gallery& gallery, Faceprints& updated_faceprints,
+                              const Thresholds& thresholds,
+                              MatchSearchMode mode = MatchSearchMode::FirstAboveThreshold);
+
+private:
+    class NodeWorkers;
+    struct Node;
+    struct Scan;
+
+    void CopyRows(Node& node, const Gallery& gallery, std::size_t begin, std::size_t end);
+
+    // scan of the node's rows into per-thread results. runs on the node's threads.
+    void StartScan(Node& node, const feature_t* query, uint32_t query_norm, match_calc_t threshold, bool early_exit,
+                   std::atomic<bool>& stop, Scan& scan);
+    TagResult WaitScan(Node& node, Scan& scan);
+
+    Config _config;
+    std::vector<std::unique_ptr<Node>> _nodes;
+    std::size_t _size = 0;
+    std::atomic<std::size_t> _next_node {0}; // round robin of NumaMode::Replicate
+};
+} // namespace RealSenseID
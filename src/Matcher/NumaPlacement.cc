@@ -0,0 +1,336 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "NumaPlacement.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "NumaPlacement";
+
+static const std::size_t s_pageSize = 4096;
+static const std::size_t s_hugePageSize = 2 * 1024 * 1024;
+static const std::size_t s_gigaPageSize = 1024 * 1024 * 1024;
+
+static std::size_t RoundUp(std::size_t value, std::size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+const char* HugePagesName(HugePages huge_pages)
+{
+    switch (huge_pages)
+    {
+    case HugePages::Transparent:
+        return "transparent";
+    case HugePages::Explicit2MB:
+        return "hugetlb-2MB";
+    case HugePages::Explicit1GB:
+        return "hugetlb-1GB";
+    default:
+        return "none";
+    }
+}
+
+#ifdef __linux__
+// mbind() without libnuma.
+static const int s_mpolPreferred = 1;
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+static std::vector<int> ParseCpuList(const std::string& list)
+{
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ','))
+    {
+        if (range.empty() || range == "\n")
+        {
+            continue;
+        }
+        std::size_t dash = range.find('-');
+        int first = std::atoi(range.c_str());
+        int last = (dash == std::string::npos) ? first : std::atoi(range.c_str() + dash + 1);
+        for (int cpu = first; cpu <= last; cpu++)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::vector<NumaNode> DiscoverNumaNodes()
+{
+    // cpus the process may run on (cpuset of the container, taskset).
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool have_affinity = (sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    auto is_allowed = [&](int cpu) {
+        return !have_affinity || (cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed));
+    };
+
+    std::vector<NumaNode> nodes;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string online_list;
+    if (online && std::getline(online, online_list))
+    {
+        for (int id : ParseCpuList(online_list))
+        {
+            std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+            std::string list;
+            if (!cpulist || !std::getline(cpulist, list))
+            {
+                continue;
+            }
+
+            NumaNode node;
+            node.id = id;
+            for (int cpu : ParseCpuList(list))
+            {
+                if (is_allowed(cpu))
+                {
+                    node.cpus.push_back(cpu);
+                }
+            }
+
+            // memory-only nodes and nodes outside the cpuset can't run search threads.
+            if (!node.cpus.empty())
+            {
+                nodes.push_back(node);
+            }
+        }
+    }
+
+    if (nodes.empty())
+    {
+        NumaNode node;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (have_affinity ? CPU_ISSET(cpu, &allowed) : cpu < static_cast<int>(std::thread::hardware_concurrency()))
+            {
+                node.cpus.push_back(cpu);
+            }
+        }
+        nodes.push_back(node);
+    }
+
+    return nodes;
+}
+
+bool PinCurrentThread(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+    // pid 0 is the calling thread. unlike pthread_setaffinity_np, also available on android (bionic).
+    return !cpus.empty() && sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+bool PlacedBuffer::Allocate(std::size_t bytes, HugePages huge_pages, int node)
+{
+    Free();
+    if (bytes == 0)
+    {
+        return false;
+    }
+
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    if (huge_pages == HugePages::Explicit1GB)
+    {
+        std::size_t size = RoundUp(bytes, s_gigaPageSize);
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), -1, 0);
+        if (data != MAP_FAILED)
+        {
+            _mapping = data;
+            _mapping_bytes = size;
+            _backing = HugePages::Explicit1GB;
+        }
+        else
+        {
+            huge_pages = HugePages::Explicit2MB;
+        }
+    }
+
+    if (_mapping == nullptr && huge_pages == HugePages::Explicit2MB)
+    {
+        std::size_t size = RoundUp(bytes, s_hugePageSize);
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+        if (data != MAP_FAILED)
+        {
+            _mapping = data;
+            _mapping_bytes = size;
+            _backing = HugePages::Explicit2MB;
+        }
+        else
+        {
+            // no (or not enough) pages in the hugetlb pool.
+            huge_pages = HugePages::Transparent;
+        }
+    }
+
+    if (_mapping == nullptr)
+    {
+        // transparent hugepages only back 2MB aligned ranges - map one extra hugepage and trim to alignment.
+        const bool transparent = (huge_pages == HugePages::Transparent);
+        std::size_t size = transparent ? RoundUp(bytes, s_hugePageSize) : RoundUp(bytes, s_pageSize);
+        std::size_t map_size = transparent ? size + s_hugePageSize : size;
+        void* data = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (data == MAP_FAILED)
+        {
+            LOG_ERROR(LOG_TAG, "Failed to map %zu bytes", map_size);
+            return false;
+        }
+
+        char* begin = static_cast<char*>(data);
+        if (transparent)
+        {
+            char* aligned = reinterpret_cast<char*>(RoundUp(reinterpret_cast<std::uintptr_t>(begin), s_hugePageSize));
+            std::size_t head = static_cast<std::size_t>(aligned - begin);
+            if (head > 0)
+            {
+                ::munmap(begin, head);
+            }
+            std::size_t tail = map_size - head - size;
+            if (tail > 0)
+            {
+                ::munmap(aligned + size, tail);
+            }
+            begin = aligned;
+            map_size = size;
+        }
+
+        _mapping = begin;
+        _mapping_bytes = map_size;
+        _backing = (transparent && ::madvise(begin, size, MADV_HUGEPAGE) == 0) ? HugePages::Transparent
+                                                                               : HugePages::None;
+    }
+
+    if (node >= 0 && node < 64)
+    {
+        // preferred (not strict) - allocation still succeeds when the node is out of memory. fails with EPERM/ENOSYS
+        // in some containers, then first touch decides.
+        unsigned long mask = 1UL << node;
+        _bound = (::syscall(SYS_mbind, _mapping, _mapping_bytes, s_mpolPreferred, &mask, sizeof(mask) * 8, 0) == 0);
+    }
+
+    _data = _mapping;
+    _bytes = bytes;
+    return true;
+}
+
+void PlacedBuffer::Free()
+{
+    if (_mapping != nullptr)
+    {
+        ::munmap(_mapping, _mapping_bytes);
+    }
+    _data = nullptr;
+    _bytes = 0;
+    _mapping = nullptr;
+    _mapping_bytes = 0;
+    _backing = HugePages::None;
+    _bound = false;
+}
+#else
+std::vector<NumaNode> DiscoverNumaNodes()
+{
+    NumaNode node;
+    const int count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    for (int cpu = 0; cpu < count; cpu++)
+    {
+        node.cpus.push_back(cpu);
+    }
+    return {node};
+}
+
+bool PinCurrentThread(const std::vector<int>&)
+{
+    return false;
+}
+
+bool PlacedBuffer::Allocate(std::size_t bytes, HugePages, int)
+{
+    Free();
+    if (bytes == 0)
+    {
+        return false;
+    }
+
+    // page aligned heap block, the original pointer is kept in _mapping.
+    std::size_t size = RoundUp(bytes, s_pageSize) + s_pageSize;
+    void* raw = std::malloc(size);
+    if (raw == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Failed to allocate %zu bytes", size);
+        return false;
+    }
+
+    _mapping = raw;
+    _mapping_bytes = size;
+    _data = reinterpret_cast<void*>(RoundUp(reinterpret_cast<std::uintptr_t>(raw), s_pageSize));
+    _bytes = bytes;
+    return true;
+}
+
+void PlacedBuffer::Free()
+{
+    std::free(_mapping);
+    _data = nullptr;
+    _bytes = 0;
+    _mapping = nullptr;
+    _mapping_bytes = 0;
+    _backing = HugePages::None;
+    _bound = false;
+}
+#endif
+
+PlacedBuffer::~PlacedBuffer()
+{
+    Free();
+}
+
+PlacedBuffer::PlacedBuffer(PlacedBuffer&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+PlacedBuffer& PlacedBuffer::operator=(PlacedBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        Free();
+        std::swap(_data, other._data);
+        std::swap(_bytes, other._bytes);
+        std::swap(_mapping, other._mapping);
+        std::swap(_mapping_bytes, other._mapping_bytes);
+        std::swap(_backing, other._backing);
+        std::swap(_bound, other._bound);
+    }
+    return *this;
+}
+} // namespace RealSenseID
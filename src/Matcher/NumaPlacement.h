@@ -0,0 +1,85 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Memory and thread placement helpers for large galleries: hugepage backed buffers, NUMA node discovery, node binding
+// and thread pinning. Everything degrades to plain memory / a single node when the platform, the kernel or the
+// container doesn't allow it - the result reports what was actually obtained.
+namespace RealSenseID
+{
+enum class HugePages
+{
+    None,        // regular pages
+    Transparent, // 2MB aligned region + madvise(MADV_HUGEPAGE) (transparent hugepages in madvise mode)
+    Explicit2MB, // MAP_HUGETLB from the 2MB hugetlb pool, falls back to Transparent
+    Explicit1GB  // MAP_HUGETLB from the 1GB hugetlb pool, falls back to Explicit2MB
+};
+
+const char* HugePagesName(HugePages huge_pages);
+
+struct NumaNode
+{
+    int id = 0;
+    std::vector<int> cpus; // cpus of the node this process may run on
+};
+
+// nodes with cpus the process may run on, in node order. a single node with all allowed cpus if the topology is not
+// available (non-linux, no /sys in the container).
+std::vector<NumaNode> DiscoverNumaNodes();
+
+// restrict the calling thread to the given cpus. returns false if not supported or not allowed.
+bool PinCurrentThread(const std::vector<int>& cpus);
+
+// Page aligned buffer, optionally hugepage backed and bound to a NUMA node. Pages are not touched by Allocate(), so
+// without a successful binding they are placed on the node of the thread that first writes them.
+class PlacedBuffer
+{
+public:
+    PlacedBuffer() = default;
+    ~PlacedBuffer();
+
+    PlacedBuffer(const PlacedBuffer&) = delete;
+    PlacedBuffer& operator=(const PlacedBuffer&) = delete;
+    PlacedBuffer(PlacedBuffer&& other) noexcept;
+    PlacedBuffer& operator=(PlacedBuffer&& other) noexcept;
+
+    // node < 0 - no binding. returns false only if no memory could be allocated at all.
+    bool Allocate(std::size_t bytes, HugePages huge_pages, int node);
+
+    void Free();
+
+    void* Data() const
+    {
+        return _data;
+    }
+
+    std::size_t Bytes() const
+    {
+        return _bytes;
+    }
+
+    // backing actually obtained (Transparent means the advice was accepted, not that the kernel had hugepages).
+    HugePages Backing() const
+    {
+        return _backing;
+    }
+
+    // the pages are bound (preferred) to the requested node.
+    bool IsBound() const
+    {
+        return _bound;
+    }
+
+private:
+    void* _data = nullptr;
+    std::size_t _bytes = 0;
+    void* _mapping = nullptr; // start of the mapping / allocation to release
+    std::size_t _mapping_bytes = 0;
+    HugePages _backing = HugePages::None;
+    bool _bound = false;
+};
+} // namespace RealSenseID
@@ -0,0 +1,162 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "ParallelMatcher.h"
+#include "Gallery.h"
+#include "MatcherSimd.h"
+#include "TopKCandidates.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "ParallelMatcher";
+
+constexpr std::size_t ParallelMatcher::DefaultShardSize;
+constexpr std::size_t ParallelMatcher::MinShardSize;
+
+ParallelMatcher::ParallelMatcher(std::size_t num_threads, std::size_t shard_size) :
+    _pool(num_threads), _shard_size(std::max(shard_size, MinShardSize))
+{
+}
+
+bool ParallelMatcher::ScanShards(const Faceprints& new_faceprints, const Gallery& gallery,
+                                 const Thresholds& thresholds, MatchSearchMode mode, const std::atomic<bool>* cancel,
+                                 std::vector<TagResult>& best, std::size_t k, std::vector<TopKCandidates>* topk)
+{
+    const std::size_t number_of_users = gallery.Size();
+
+    // smaller shards for small galleries, so all threads get work.
+    std::size_t per_thread = (number_of_users + _pool.NumThreads() - 1) / _pool.NumThreads();
+    std::size_t shard_size = std::max(MinShardSize, std::min(_shard_size, per_thread));
+    std::size_t number_of_shards = (number_of_users + shard_size - 1) / shard_size;
+
+    best.assign(number_of_shards, TagResult());
+    if (topk != nullptr)
+    {
+        topk->assign(number_of_shards, TopKCandidates(std::min(k, shard_size)));
+    }
+
+    const feature_t* queryFea = &new_faceprints.adaptiveDescriptorWithoutMask[0];
+    const uint32_t vec_length = Gallery::VectorLength;
+    const uint32_t queryNorm = MatcherSimd::ComputeSums(queryFea, queryFea, vec_length).norm1;
+    const match_calc_t threshold = thresholds.strongThreshold_pNMgNM;
+    const bool early_exit = (mode == MatchSearchMode::FirstAboveThreshold);
+
+    std::atomic<bool> stop {false};
+
+    _pool.ParallelFor(number_of_shards, [&](std::size_t shard) {
+        const std::size_t begin = shard * shard_size;
+        const std::size_t end = std::min(begin + shard_size, number_of_users);
+
+        TagResult& shard_best = best[shard];
+        shard_best.score = 0;
+        shard_best.id = -1;
+        TopKCandidates* shard_topk = (topk != nullptr) ? &(*topk)[shard] : nullptr;
+
+        for (std::size_t i = begin; i < end; i++)
+        {
+            if (stop.load(std::memory_order_relaxed) ||
+                (cancel != nullptr && cancel->load(std::memory_order_relaxed)))
+            {
+                return;
+            }
+
+            if (!gallery.IsValid(i))
+            {
+                continue;
+            }
+
+            int32_t corr = MatcherSimd::DotProduct(queryFea, gallery.Descriptor(i), vec_length);
+            match_calc_t score = Matcher::NormalizeScore(corr, queryNorm, gallery.Norm(i));
+
+            if (score > shard_best.score)
+            {
+                shard_best.score = score;
+                shard_best.id = static_cast<int>(i);
+            }
+
+            if (shard_topk != nullptr)
+            {
+                shard_topk->Push(static_cast<int>(i), score);
+            }
+
+            if (early_exit && score > threshold)
+            {
+                stop.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+    });
+
+    return !(cancel != nullptr && cancel->load());
+}
+
+ExtendedMatchResult ParallelMatcher::Match(const Faceprints& new_faceprints, const Gallery& gallery,
+                                           Faceprints& updated_faceprints, const Thresholds& thresholds,
+                                           MatchSearchMode mode, const std::atomic<bool>* cancel)
+{
+    if (!Matcher::ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return ExtendedMatchResult();
+    }
+
+    std::vector<TagResult> shard_best;
+    if (!ScanShards(new_faceprints, gallery, thresholds, mode, cancel, shard_best, 0, nullptr))
+    {
+        LOG_DEBUG(LOG_TAG, "Search cancelled");
+        return ExtendedMatchResult();
+    }
+
+    // shards are in index order, so strict '>' keeps the lowest index on equal scores (same as sequential scan).
+    TagResult scores;
+    scores.score = 0;
+    scores.id = -1;
+    for (const auto& shard : shard_best)
+    {
+        if (shard.score > scores.score)
+        {
+            scores = shard;
+        }
+    }
+
+    return Matcher::FinalizeGalleryMatch(new_faceprints, gallery, scores, updated_faceprints, thresholds);
+}
+
+std::vector<MatchCandidate> ParallelMatcher::MatchTopK(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                       std::size_t k, const Thresholds& thresholds,
+                                                       MatchSearchMode mode, const std::atomic<bool>* cancel)
+{
+    std::vector<MatchCandidate> candidates;
+
+    if (k == 0 || !Matcher::ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return candidates;
+    }
+
+    std::vector<TagResult> shard_best;
+    std::vector<TopKCandidates> shard_topk;
+    if (!ScanShards(new_faceprints, gallery, thresholds, mode, cancel, shard_best, k, &shard_topk))
+    {
+        LOG_DEBUG(LOG_TAG, "Search cancelled");
+        return candidates;
+    }
+
+    TopKCandidates merged(std::min(k, gallery.Size()));
+    for (const auto& shard : shard_topk)
+    {
+        merged.Merge(shard);
+    }
+
+    candidates = merged.Sorted();
+
+    ExtendedMatchResult unused;
+    for (auto& candidate : candidates)
+    {
+        candidate.confidence =
+            Matcher::CalculateConfidence(candidate.score, thresholds.strongThreshold_pNMgNM, unused);
+    }
+
+    return candidates;
+}
+} // namespace RealSenseID
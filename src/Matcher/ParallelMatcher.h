@@ -0,0 +1,71 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include "WorkerPool.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace RealSenseID
+{
+class Gallery;
+class TopKCandidates;
+
+// Multi-threaded 1:N gallery search.
+// The gallery is split into cache-sized shards that are scored on a persistent worker pool, and per-shard
+// best/top-k results are merged. Scores are identical to the single-threaded Matcher gallery functions.
+//
+// In MatchSearchMode::FirstAboveThreshold the first shard to cross strongThreshold_pNMgNM stops the others. The
+// decision (isSame) is the same as the sequential scan, but which of several above-threshold users is returned
+// depends on timing.
+//
+// Searches can be cancelled by setting the optional cancel flag from another thread - a cancelled search returns an
+// empty result.
+class ParallelMatcher
+{
+public:
+    // 2048 users x 512 bytes = 1MB of descriptors per shard (fits L2 on most server cores).
+    static constexpr std::size_t DefaultShardSize = 2048;
+    static constexpr std::size_t MinShardSize = 256;
+
+    // num_threads = 0 uses all hardware threads.
+    explicit ParallelMatcher(std::size_t num_threads = 0, std::size_t shard_size = DefaultShardSize);
+
+    ParallelMatcher(const ParallelMatcher&) = delete;
+    ParallelMatcher& operator=(const ParallelMatcher&) = delete;
+
+    // same semantics as Matcher::MatchFaceprintsToGallery().
+    ExtendedMatchResult Match(const Faceprints& new_faceprints, const Gallery& gallery, Faceprints& updated_faceprints,
+                              const Thresholds& thresholds,
+                              MatchSearchMode mode = MatchSearchMode::FirstAboveThreshold,
+                              const std::atomic<bool>* cancel = nullptr);
+
+    // same semantics as Matcher::MatchFaceprintsTopK().
+    std::vector<MatchCandidate> MatchTopK(const Faceprints& new_faceprints, const Gallery& gallery, std::size_t k,
+                                          const Thresholds& thresholds,
+                                          MatchSearchMode mode = MatchSearchMode::Exhaustive,
+                                          const std::atomic<bool>* cancel = nullptr);
+
+    std::size_t NumThreads() const
+    {
+        return _pool.NumThreads();
+    }
+
+    std::size_t ShardSize() const
+    {
+        return _shard_size;
+    }
+
+private:
+    // scores all shards into per-shard best (and top-k if topk is not null). returns false if cancelled.
+    bool ScanShards(const Faceprints& new_faceprints, const Gallery& gallery, const Thresholds& thresholds,
+                    MatchSearchMode mode, const std::atomic<bool>* cancel, std::vector<TagResult>& best,
+                    std::size_t k, std::vector<TopKCandidates>* topk);
+
+    WorkerPool _pool;
+    std::size_t _shard_size;
+};
+} // namespace RealSenseID
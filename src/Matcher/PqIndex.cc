@@ -0,0 +1,456 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "PqIndex.h"
+#include "Gallery.h"
+#include "MatcherSimd.h"
+#include "TopKCandidates.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <utility>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "PqIndex";
+
+constexpr uint32_t PqIndex::VectorLength;
+constexpr uint32_t PqIndex::NumberOfSubvectors;
+constexpr uint32_t PqIndex::SubvectorLength;
+constexpr uint32_t PqIndex::NumberOfCentroids;
+
+static_assert(PqIndex::VectorLength % PqIndex::NumberOfSubvectors == 0,
+              "Vector length must be a multiple of the number of sub-vectors");
+static_assert(PqIndex::NumberOfSubvectors % 4 == 0, "ADC scan is unrolled by 4");
+
+static const std::size_t s_subspaceSize = PqIndex::NumberOfCentroids * PqIndex::SubvectorLength;
+
+// serialized codebooks header
+static const uint32_t s_codebooksMagic = 0x43515052; // "RPQC"
+static const uint32_t s_codebooksFormatVersion = 1;
+
+struct CodebooksHeader
+{
+    uint32_t magic;
+    uint32_t format_version;
+    uint32_t vector_length;
+    uint32_t number_of_subvectors;
+    uint32_t number_of_centroids;
+};
+
+static void ToUnitVector(const feature_t* descriptor, float* out)
+{
+    double norm = 0;
+    for (uint32_t i = 0; i < PqIndex::VectorLength; i++)
+    {
+        out[i] = static_cast<float>(descriptor[i]);
+        norm += static_cast<double>(out[i]) * out[i];
+    }
+
+    float scale = norm > 0 ? static_cast<float>(1.0 / std::sqrt(norm)) : 0.0f;
+    for (uint32_t i = 0; i < PqIndex::VectorLength; i++)
+    {
+        out[i] *= scale;
+    }
+}
+
+static float SquaredDistance(const float* a, const float* b)
+{
+    float sum = 0;
+    for (uint32_t i = 0; i < PqIndex::SubvectorLength; i++)
+    {
+        float diff = a[i] - b[i];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+static uint8_t ClosestCentroid(const float* subvector, const float* subspace)
+{
+    uint32_t best = 0;
+    float best_distance = std::numeric_limits<float>::max();
+    for (uint32_t c = 0; c < PqIndex::NumberOfCentroids; c++)
+    {
+        float distance = SquaredDistance(subvector, &subspace[c * PqIndex::SubvectorLength]);
+        if (distance < best_distance)
+        {
+            best_distance = distance;
+            best = c;
+        }
+    }
+    return static_cast<uint8_t>(best);
+}
+
+bool PqIndex::Train(const std::vector<const feature_t*>& samples, std::size_t iterations, uint32_t seed)
+{
+    Clear();
+    _codebooks.clear();
+
+    if (samples.size() < NumberOfCentroids)
+    {
+        LOG_ERROR(LOG_TAG, "Need at least %u samples to train, got %zu", NumberOfCentroids, samples.size());
+        return false;
+    }
+
+    const std::size_t dsub = SubvectorLength;
+    std::mt19937 rng(seed);
+
+    std::vector<float> units(samples.size() * VectorLength);
+    for (std::size_t s = 0; s < samples.size(); s++)
+    {
+        ToUnitVector(samples[s], &units[s * VectorLength]);
+    }
+
+    // centroids of all sub-spaces start from the same distinct random samples.
+    std::vector<std::size_t> order(samples.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<float> codebooks(NumberOfSubvectors * s_subspaceSize);
+    std::vector<float> sums(s_subspaceSize);
+    std::vector<std::size_t> counts(NumberOfCentroids);
+    std::uniform_int_distribution<std::size_t> pick(0, samples.size() - 1);
+
+    for (uint32_t m = 0; m < NumberOfSubvectors; m++)
+    {
+        float* subspace = &codebooks[m * s_subspaceSize];
+        for (uint32_t c = 0; c < NumberOfCentroids; c++)
+        {
+            std::copy_n(&units[order[c] * VectorLength + m * dsub], dsub, &subspace[c * dsub]);
+        }
+
+        for (std::size_t iter = 0; iter < iterations; iter++)
+        {
+            std::fill(sums.begin(), sums.end(), 0.0f);
+            std::fill(counts.begin(), counts.end(), 0);
+
+            for (std::size_t s = 0; s < samples.size(); s++)
+            {
+                const float* subvector = &units[s * VectorLength + m * dsub];
+                uint8_t best = ClosestCentroid(subvector, subspace);
+                for (std::size_t i = 0; i < dsub; i++)
+                {
+                    sums[best * dsub + i] += subvector[i];
+                }
+                counts[best]++;
+            }
+
+            for (uint32_t c = 0; c < NumberOfCentroids; c++)
+            {
+                if (counts[c] == 0)
+                {
+                    // re-seed empty centroid with a random sample.
+                    std::copy_n(&units[pick(rng) * VectorLength + m * dsub], dsub, &subspace[c * dsub]);
+                    continue;
+                }
+                for (std::size_t i = 0; i < dsub; i++)
+                {
+                    subspace[c * dsub + i] = sums[c * dsub + i] / counts[c];
+                }
+            }
+        }
+    }
+
+    _codebooks = std::move(codebooks);
+
+    LOG_DEBUG(LOG_TAG, "Trained %u codebooks on %zu samples", NumberOfSubvectors, samples.size());
+    return true;
+}
+
+bool PqIndex::Train(const Gallery& gallery, std::size_t max_samples, std::size_t iterations, uint32_t seed)
+{
+    std::vector<const feature_t*> samples;
+    samples.reserve(gallery.Size());
+    for (std::size_t i = 0; i < gallery.Size(); i++)
+    {
+        if (gallery.IsValid(i))
+        {
+            samples.push_back(gallery.Descriptor(i));
+        }
+    }
+
+    if (samples.size() > max_samples)
+    {
+        std::mt19937 rng(seed);
+        std::shuffle(samples.begin(), samples.end(), rng);
+        samples.resize(max_samples);
+    }
+
+    return Train(samples, iterations, seed);
+}
+
+bool PqIndex::SaveCodebooks(std::ostream& stream) const
+{
+    if (!IsTrained())
+    {
+        LOG_ERROR(LOG_TAG, "Index is not trained");
+        return false;
+    }
+
+    CodebooksHeader header;
+    header.magic = s_codebooksMagic;
+    header.format_version = s_codebooksFormatVersion;
+    header.vector_length = VectorLength;
+    header.number_of_subvectors = NumberOfSubvectors;
+    header.number_of_centroids = NumberOfCentroids;
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(_codebooks.data()), _codebooks.size() * sizeof(float));
+    if (!stream)
+    {
+        LOG_ERROR(LOG_TAG, "Failed writing codebooks");
+        return false;
+    }
+    return true;
+}
+
+bool PqIndex::LoadCodebooks(std::istream& stream)
+{
+    Clear();
+    _codebooks.clear();
+
+    CodebooksHeader header;
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        LOG_ERROR(LOG_TAG, "Failed reading codebooks header");
+        return false;
+    }
+
+    if (header.magic != s_codebooksMagic || header.format_version != s_codebooksFormatVersion)
+    {
+        LOG_ERROR(LOG_TAG, "Bad codebooks header, magic:%x, version:%u", header.magic, header.format_version);
+        return false;
+    }
+
+    if (header.vector_length != VectorLength || header.number_of_subvectors != NumberOfSubvectors ||
+        header.number_of_centroids != NumberOfCentroids)
+    {
+        LOG_ERROR(LOG_TAG, "Codebooks layout %u/%u/%u doesn't match %u/%u/%u", header.vector_length,
+                  header.number_of_subvectors, header.number_of_centroids, VectorLength, NumberOfSubvectors,
+                  NumberOfCentroids);
+        return false;
+    }
+
+    std::vector<float> codebooks(NumberOfSubvectors * s_subspaceSize);
+    if (!stream.read(reinterpret_cast<char*>(codebooks.data()), codebooks.size() * sizeof(float)))
+    {
+        LOG_ERROR(LOG_TAG, "Failed reading codebooks");
+        return false;
+    }
+
+    _codebooks = std::move(codebooks);
+    return true;
+}
+
+void PqIndex::Encode(const float* unit, uint8_t* code) const
+{
+    for (uint32_t m = 0; m < NumberOfSubvectors; m++)
+    {
+        code[m] = ClosestCentroid(&unit[m * SubvectorLength], &_codebooks[m * s_subspaceSize]);
+    }
+}
+
+void PqIndex::BuildLookupTable(const float* unit, float* table) const
+{
+    for (uint32_t m = 0; m < NumberOfSubvectors; m++)
+    {
+        const float* subvector = &unit[m * SubvectorLength];
+        const float* subspace = &_codebooks[m * s_subspaceSize];
+        for (uint32_t c = 0; c < NumberOfCentroids; c++)
+        {
+            float dot = 0;
+            for (uint32_t i = 0; i < SubvectorLength; i++)
+            {
+                dot += subvector[i] * subspace[c * SubvectorLength + i];
+            }
+            table[m * NumberOfCentroids + c] = dot;
+        }
+    }
+}
+
+bool PqIndex::Add(int id, const feature_t* descriptor, int version)
+{
+    if (!IsTrained())
+    {
+        LOG_ERROR(LOG_TAG, "Index is not trained");
+        return false;
+    }
+
+    if (descriptor == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Null pointer detected : Skipping function.");
+        return false;
+    }
+
+    if (Size() == 0)
+    {
+        _version = version;
+    }
+    else if (version != _version)
+    {
+        LOG_ERROR(LOG_TAG, "Faceprints version %d doesn't match index version %d", version, _version);
+        return false;
+    }
+
+    Remove(id);
+
+    std::vector<float> unit(VectorLength);
+    ToUnitVector(descriptor, unit.data());
+
+    const std::size_t position = _ids.size();
+    _codes.resize((position + 1) * NumberOfSubvectors);
+    Encode(unit.data(), &_codes[position * NumberOfSubvectors]);
+
+    _vectors.resize((position + 1) * VectorLength);
+    ::memcpy(&_vectors[position * VectorLength], descriptor, VectorLength * sizeof(feature_t));
+    _norms.push_back(MatcherSimd::ComputeSums(descriptor, descriptor, VectorLength).norm1);
+    _ids.push_back(id);
+
+    _positions[id] = position;
+    return true;
+}
+
+bool PqIndex::AddGallery(const Gallery& gallery)
+{
+    _codes.reserve(_codes.size() + gallery.Size() * NumberOfSubvectors);
+    _vectors.reserve(_vectors.size() + gallery.Size() * VectorLength);
+    for (std::size_t i = 0; i < gallery.Size(); i++)
+    {
+        if (gallery.IsValid(i) && !Add(static_cast<int>(i), gallery.Descriptor(i), gallery.Version()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PqIndex::Remove(int id)
+{
+    auto it = _positions.find(id);
+    if (it == _positions.end())
+    {
+        return false;
+    }
+
+    const std::size_t position = it->second;
+    const std::size_t last = _ids.size() - 1;
+
+    // move last user into the removed slot.
+    if (position != last)
+    {
+        std::copy_n(&_codes[last * NumberOfSubvectors], NumberOfSubvectors, &_codes[position * NumberOfSubvectors]);
+        std::copy_n(&_vectors[last * VectorLength], VectorLength, &_vectors[position * VectorLength]);
+        _norms[position] = _norms[last];
+        _ids[position] = _ids[last];
+        _positions[_ids[position]] = position;
+    }
+
+    _codes.resize(last * NumberOfSubvectors);
+    _vectors.resize(last * VectorLength);
+    _norms.pop_back();
+    _ids.pop_back();
+    _positions.erase(id);
+    return true;
+}
+
+void PqIndex::Clear()
+{
+    _codes.clear();
+    _vectors.clear();
+    _norms.clear();
+    _ids.clear();
+    _positions.clear();
+    _version = 0;
+}
+
+std::vector<MatchCandidate> PqIndex::Search(const Faceprints& new_faceprints, std::size_t k,
+                                            std::size_t number_of_rescores, const Thresholds& thresholds) const
+{
+    std::vector<MatchCandidate> candidates;
+
+    if (!IsTrained() || k == 0 || Size() == 0)
+    {
+        return candidates;
+    }
+
+    if (!Matcher::ValidateFaceprints(new_faceprints))
+    {
+        LOG_ERROR(LOG_TAG, "Faceprints vector failed range validation.");
+        return candidates;
+    }
+
+    if (new_faceprints.version != _version)
+    {
+        LOG_ERROR(LOG_TAG, "Faceprints version %d doesn't match index version %d", new_faceprints.version, _version);
+        return candidates;
+    }
+
+    const feature_t* queryFea = &new_faceprints.adaptiveDescriptorWithoutMask[0];
+
+    std::vector<float> unit(VectorLength);
+    ToUnitVector(queryFea, unit.data());
+
+    std::vector<float> table(NumberOfSubvectors * NumberOfCentroids);
+    BuildLookupTable(unit.data(), table.data());
+
+    // (1) ADC scan over the codes, keeping the best number_of_candidates approximate scores in a min-heap.
+    using ApproxCandidate = std::pair<float, uint32_t>;
+    auto worse = [](const ApproxCandidate& a, const ApproxCandidate& b) { return a.first > b.first; };
+
+    const std::size_t number_of_users = Size();
+    const std::size_t number_of_candidates = std::min(std::max(number_of_rescores, k), number_of_users);
+    std::vector<ApproxCandidate> heap;
+    heap.reserve(number_of_candidates);
+
+    for (std::size_t i = 0; i < number_of_users; i++)
+    {
+        const uint8_t* code = &_codes[i * NumberOfSubvectors];
+        // independent partial sums, so table lookups are not serialized on one add chain.
+        float sums[4] = {0, 0, 0, 0};
+        for (uint32_t m = 0; m < NumberOfSubvectors; m += 4)
+        {
+            sums[0] += table[(m + 0) * NumberOfCentroids + code[m + 0]];
+            sums[1] += table[(m + 1) * NumberOfCentroids + code[m + 1]];
+            sums[2] += table[(m + 2) * NumberOfCentroids + code[m + 2]];
+            sums[3] += table[(m + 3) * NumberOfCentroids + code[m + 3]];
+        }
+        const float score = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+
+        if (heap.size() < number_of_candidates)
+        {
+            heap.emplace_back(score, static_cast<uint32_t>(i));
+            std::push_heap(heap.begin(), heap.end(), worse);
+        }
+        else if (score > heap.front().first)
+        {
+            std::pop_heap(heap.begin(), heap.end(), worse);
+            heap.back() = ApproxCandidate(score, static_cast<uint32_t>(i));
+            std::push_heap(heap.begin(), heap.end(), worse);
+        }
+    }
+
+    // (2) exact rescoring of the best ADC candidates from the cold tier.
+    const uint32_t queryNorm = MatcherSimd::ComputeSums(queryFea, queryFea, VectorLength).norm1;
+    TopKCandidates topk(std::min(k, heap.size()));
+    for (const auto& approx : heap)
+    {
+        const uint32_t position = approx.second;
+        int32_t corr = MatcherSimd::DotProduct(queryFea, &_vectors[position * VectorLength], VectorLength);
+        topk.Push(_ids[position], Matcher::NormalizeScore(corr, queryNorm, _norms[position]));
+    }
+
+    candidates = topk.Sorted();
+
+    ExtendedMatchResult unused;
+    for (auto& candidate : candidates)
+    {
+        candidate.confidence = Matcher::CalculateConfidence(candidate.score, thresholds.strongThreshold_pNMgNM, unused);
+    }
+
+    return candidates;
+}
+} // namespace RealSenseID
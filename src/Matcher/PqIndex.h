@@ -0,0 +1,113 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include "AlignedAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace RealSenseID
+{
+class Gallery;
+
+// Product-quantized (PQ) compressed gallery for large 1:N searches.
+//
+// Every search descriptor is unit normalized (ncc is a cosine similarity) and split into NumberOfSubvectors
+// sub-vectors, each one encoded as the 8-bit index of its closest centroid in a per sub-space codebook.
+// Hot tier - 32 bytes of codes per user, scanned with asymmetric distance (ADC): the query is not quantized, a
+// lookup table of its dot product with every centroid is built once per query and each user is scored with
+// NumberOfSubvectors table lookups.
+// Cold tier - the full descriptor and norm of each user, touched only to rescore the best ADC candidates with the
+// exact integer ncc (identical to Matcher::MatchTwoVectors), so thresholds and confidence keep their meaning.
+//
+// Codebooks are trained once (e.g. on the enrolled gallery) and can be saved/loaded, so a device or host can encode
+// new users without re-training. Users can be added and removed at any time after training. Ids are chosen by the
+// caller (e.g. gallery index).
+class PqIndex
+{
+public:
+    static constexpr uint32_t VectorLength = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER;
+    static constexpr uint32_t NumberOfSubvectors = 32;
+    static constexpr uint32_t SubvectorLength = VectorLength / NumberOfSubvectors;
+    static constexpr uint32_t NumberOfCentroids = 256; // 8 bit codes
+
+    PqIndex() = default;
+
+    // train the codebooks with k-means in every sub-space. clears the index (users must be added after training).
+    bool Train(const std::vector<const feature_t*>& samples, std::size_t iterations = 10, uint32_t seed = 0);
+
+    // train on (a sample of at most max_samples) valid gallery users.
+    bool Train(const Gallery& gallery, std::size_t max_samples = 16384, std::size_t iterations = 10,
+               uint32_t seed = 0);
+
+    bool IsTrained() const
+    {
+        return !_codebooks.empty();
+    }
+
+    // write/read the trained codebooks (not the users). loading clears the index.
+    bool SaveCodebooks(std::ostream& stream) const;
+    bool LoadCodebooks(std::istream& stream);
+
+    // add descriptor under the given id (replaces existing descriptor with the same id).
+    // version is the faceprints version of the descriptor: the first added user sets the index version, users of
+    // other versions are rejected (as are queries of other versions).
+    bool Add(int id, const feature_t* descriptor, int version);
+
+    // add all valid gallery users, with gallery index as id.
+    bool AddGallery(const Gallery& gallery);
+
+    bool Remove(int id);
+
+    void Clear();
+
+    std::size_t Size() const
+    {
+        return _ids.size();
+    }
+
+    // faceprints version of the indexed users.
+    int Version() const
+    {
+        return _version;
+    }
+
+    // bytes per user scanned by a query (codes only, without the cold tier).
+    static constexpr std::size_t CodeBytesPerUser()
+    {
+        return NumberOfSubvectors * sizeof(uint8_t);
+    }
+
+    // K best candidates (sorted by descending exact score) among the number_of_rescores best ADC candidates.
+    // candidate userId is the id given to Add().
+    std::vector<MatchCandidate> Search(const Faceprints& new_faceprints, std::size_t k, std::size_t number_of_rescores,
+                                       const Thresholds& thresholds) const;
+
+private:
+    // index of the closest centroid of every sub-vector of the unit vector.
+    void Encode(const float* unit, uint8_t* code) const;
+
+    // query/centroid dot products, NumberOfSubvectors x NumberOfCentroids.
+    void BuildLookupTable(const float* unit, float* table) const;
+
+    // NumberOfSubvectors x NumberOfCentroids x SubvectorLength.
+    std::vector<float> _codebooks;
+
+    // hot tier
+    std::vector<uint8_t, AlignedAllocator<uint8_t, 64>> _codes;
+
+    // cold tier
+    std::vector<feature_t, AlignedAllocator<feature_t, 64>> _vectors;
+    std::vector<uint32_t> _norms;
+    std::vector<int> _ids;
+
+    std::unordered_map<int, std::size_t> _positions;
+    int _version = 0;
+};
+} // namespace RealSenseID
@@ -0,0 +1,350 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "RcuGallery.h"
+#include "MatcherSimd.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+
+namespace RealSenseID
+{
+static const char* LOG_TAG = "RcuGallery";
+
+constexpr std::size_t RcuGallery::DefaultSegmentSize;
+
+RcuGallery::RcuGallery(std::size_t segment_size) :
+    _segment_size(std::max<std::size_t>(segment_size, 1)), _snapshot(std::make_shared<const Snapshot>())
+{
+}
+
+std::shared_ptr<const RcuGallery::Snapshot> RcuGallery::GetSnapshot() const
+{
+    return std::atomic_load(&_snapshot);
+}
+
+std::shared_ptr<RcuGallery::Snapshot> RcuGallery::CloneSnapshot() const
+{
+    auto snapshot = std::make_shared<Snapshot>(*_snapshot);
+    snapshot->_generation++;
+    return snapshot;
+}
+
+Gallery& RcuGallery::CopySegment(Snapshot& snapshot, std::size_t segment)
+{
+    auto copy = std::make_shared<Gallery>(*snapshot._segments[segment]);
+    snapshot._segments[segment] = copy;
+    return *copy;
+}
+
+void RcuGallery::Publish(std::shared_ptr<Snapshot> snapshot)
+{
+    std::atomic_store(&_snapshot, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+}
+
+bool RcuGallery::Assign(const Gallery& gallery)
+{
+    std::lock_guard<std::mutex> lock(_write_mutex);
+
+    auto snapshot = CloneSnapshot();
+    snapshot->_segments.clear();
+    snapshot->_size = 0;
+
+    std::unordered_map<std::string, Location> locations;
+    std::shared_ptr<Gallery> segment;
+    for (std::size_t i = 0; i < gallery.Size(); i++)
+    {
+        if (!segment || segment->Size() == _segment_size)
+        {
+            segment = std::make_shared<Gallery>();
+            segment->Reserve(_segment_size);
+            snapshot->_segments.push_back(segment);
+        }
+
+        const char* user_id = gallery.UserId(i);
+        Location location;
+        location.segment = snapshot->_segments.size() - 1;
+        location.slot = segment->Size();
+        if (!locations.emplace(user_id, location).second)
+        {
+            LOG_ERROR(LOG_TAG, "Duplicate user id %s", user_id);
+            return false;
+        }
+
+        if (!segment->Add(user_id, gallery.GetFaceprints(i)))
+        {
+            return false;
+        }
+        snapshot->_size++;
+    }
+
+    _version = gallery.Version();
+    _locations = std::move(locations);
+    Publish(std::move(snapshot));
+    return true;
+}
+
+bool RcuGallery::Add(const char* user_id, const Faceprints& faceprints)
+{
+    if (user_id == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Null user id");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_write_mutex);
+
+    if (_locations.count(user_id) != 0)
+    {
+        LOG_ERROR(LOG_TAG, "User id %s already exists", user_id);
+        return false;
+    }
+
+    if (!_locations.empty() && faceprints.version != _version)
+    {
+        LOG_ERROR(LOG_TAG, "Faceprints version %d doesn't match gallery version %d", faceprints.version, _version);
+        return false;
+    }
+
+    auto snapshot = CloneSnapshot();
+
+    // first segment with room (removals leave room in the middle), or a new one.
+    std::size_t segment = 0;
+    while (segment < snapshot->_segments.size() && snapshot->_segments[segment]->Size() >= _segment_size)
+    {
+        segment++;
+    }
+
+    if (segment == snapshot->_segments.size())
+    {
+        auto new_segment = std::make_shared<Gallery>();
+        new_segment->Reserve(_segment_size);
+        snapshot->_segments.push_back(new_segment);
+    }
+
+    Gallery& gallery = CopySegment(*snapshot, segment);
+    if (!gallery.Add(user_id, faceprints))
+    {
+        return false;
+    }
+    snapshot->_size++;
+
+    Location location;
+    location.segment = segment;
+    location.slot = gallery.Size() - 1;
+    _locations[user_id] = location;
+    _version = faceprints.version;
+
+    Publish(std::move(snapshot));
+    return true;
+}
+
+bool RcuGallery::UpdateLocked(const std::string& user_id, const Faceprints& faceprints, const Faceprints* expected)
+{
+    auto it = _locations.find(user_id);
+    if (it == _locations.end())
+    {
+        LOG_ERROR(LOG_TAG, "User id %s not found", user_id.c_str());
+        return false;
+    }
+
+    const Location location = it->second;
+    if (expected != nullptr &&
+        ::memcmp(expected, &_snapshot->Segment(location.segment).GetFaceprints(location.slot), sizeof(Faceprints)))
+    {
+        LOG_DEBUG(LOG_TAG, "User %s changed since the search, update dropped", user_id.c_str());
+        return false;
+    }
+
+    auto snapshot = CloneSnapshot();
+    if (!CopySegment(*snapshot, location.segment).Update(location.slot, faceprints))
+    {
+        return false;
+    }
+
+    Publish(std::move(snapshot));
+    return true;
+}
+
+bool RcuGallery::Update(const char* user_id, const Faceprints& faceprints)
+{
+    if (user_id == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Null user id");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    return UpdateLocked(user_id, faceprints, nullptr);
+}
+
+bool RcuGallery::Remove(const char* user_id)
+{
+    if (user_id == nullptr)
+    {
+        LOG_ERROR(LOG_TAG, "Null user id");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_write_mutex);
+
+    auto it = _locations.find(user_id);
+    if (it == _locations.end())
+    {
+        return false;
+    }
+
+    const Location location = it->second;
+    auto snapshot = CloneSnapshot();
+    Gallery& gallery = CopySegment(*snapshot, location.segment);
+    if (!gallery.Remove(location.slot))
+    {
+        return false;
+    }
+    snapshot->_size--;
+
+    // the last user of the segment was moved into the removed slot.
+    _locations.erase(it);
+    if (location.slot < gallery.Size())
+    {
+        _locations[gallery.UserId(location.slot)].slot = location.slot;
+    }
+
+    Publish(std::move(snapshot));
+    return true;
+}
+
+void RcuGallery::Clear()
+{
+    std::lock_guard<std::mutex> lock(_write_mutex);
+
+    auto snapshot = CloneSnapshot();
+    snapshot->_segments.clear();
+    snapshot->_size = 0;
+    _locations.clear();
+    _version = 0;
+    Publish(std::move(snapshot));
+}
+
+bool RcuGallery::Search(const Faceprints& new_faceprints, const Snapshot& snapshot, match_calc_t threshold,
+                        TagResult& best, std::size_t& best_segment)
+{
+    const uint32_t vec_length = Gallery::VectorLength;
+
+    const feature_t* queryFea = &new_faceprints.adaptiveDescriptorWithoutMask[0];
+    const uint32_t queryNorm = MatcherSimd::ComputeSums(queryFea, queryFea, vec_length).norm1;
+
+    best.score = 0;
+    best.id = -1;
+    best_segment = 0;
+
+    for (std::size_t s = 0; s < snapshot.NumberOfSegments(); s++)
+    {
+        const Gallery& segment = snapshot.Segment(s);
+        for (std::size_t i = 0; i < segment.Size(); i++)
+        {
+            if (!segment.IsValid(i))
+            {
+                continue;
+            }
+
+            int32_t corr = MatcherSimd::DotProduct(queryFea, segment.Descriptor(i), vec_length);
+            match_calc_t score = Matcher::NormalizeScore(corr, queryNorm, segment.Norm(i));
+            if (score > best.score)
+            {
+                best.score = score;
+                best.id = static_cast<int>(i);
+                best_segment = s;
+            }
+
+            if (score > threshold)
+            {
+                return true;
+            }
+        }
+    }
+
+    return best.id >= 0;
+}
+
+ExtendedMatchResult RcuGallery::Match(const Faceprints& new_faceprints, Faceprints& updated_faceprints,
+                                      const Thresholds& thresholds, std::string& matched_user_id,
+                                      std::shared_ptr<const Snapshot>& snapshot, std::size_t& segment,
+                                      std::size_t& slot) const
+{
+    matched_user_id.clear();
+    snapshot = GetSnapshot();
+
+    // all segments share the version, validate the query once.
+    auto first = std::find_if(snapshot->_segments.begin(), snapshot->_segments.end(),
+                              [](const std::shared_ptr<const Gallery>& s) { return !s->Empty(); });
+    if (first == snapshot->_segments.end())
+    {
+        LOG_ERROR(LOG_TAG, "Gallery is empty.");
+        return ExtendedMatchResult();
+    }
+
+    if (!Matcher::ValidateGalleryQuery(new_faceprints, **first))
+    {
+        return ExtendedMatchResult();
+    }
+
+    TagResult best;
+    Search(new_faceprints, *snapshot, thresholds.strongThreshold_pNMgNM, best, segment);
+
+    const Gallery& gallery = snapshot->Segment(segment);
+    ExtendedMatchResult result =
+        Matcher::FinalizeGalleryMatch(new_faceprints, gallery, best, updated_faceprints, thresholds);
+
+    if (best.id >= 0)
+    {
+        slot = static_cast<std::size_t>(best.id);
+
+        // slot in segment -> position in snapshot
+        std::size_t position = slot;
+        for (std::size_t s = 0; s < segment; s++)
+        {
+            position += snapshot->Segment(s).Size();
+        }
+        result.userId = static_cast<int>(position);
+
+        if (result.isSame)
+        {
+            matched_user_id = gallery.UserId(slot);
+        }
+    }
+
+    return result;
+}
+
+ExtendedMatchResult RcuGallery::Match(const Faceprints& new_faceprints, Faceprints& updated_faceprints,
+                                      const Thresholds& thresholds, std::string& matched_user_id) const
+{
+    std::shared_ptr<const Snapshot> snapshot;
+    std::size_t segment = 0;
+    std::size_t slot = 0;
+    return Match(new_faceprints, updated_faceprints, thresholds, matched_user_id, snapshot, segment, slot);
+}
+
+ExtendedMatchResult RcuGallery::MatchAndUpdate(const Faceprints& new_faceprints, const Thresholds& thresholds,
+                                               std::string& matched_user_id)
+{
+    Faceprints updated_faceprints;
+    std::shared_ptr<const Snapshot> snapshot;
+    std::size_t segment = 0;
+    std::size_t slot = 0;
+    ExtendedMatchResult result =
+        Match(new_faceprints, updated_faceprints, thresholds, matched_user_id, snapshot, segment, slot);
+
+    if (result.should_update && !matched_user_id.empty())
+    {
+        // the faceprints the update was computed from are kept alive by the search snapshot.
+        const Faceprints& existing_faceprints = snapshot->Segment(segment).GetFaceprints(slot);
+
+        std::lock_guard<std::mutex> lock(_write_mutex);
+        result.should_update = UpdateLocked(matched_user_id, updated_faceprints, &existing_faceprints);
+    }
+
+    return result;
+}
+} // namespace RealSenseID
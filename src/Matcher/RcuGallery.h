@@ -0,0 +1,140 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include "Gallery.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RealSenseID
+{
+// Gallery for concurrent authentication and enrollment/adaptive-update traffic (read-copy-update).
+//
+// Searches take the current snapshot (an immutable list of segments - small Gallery objects) and scan it without
+// holding any lock, so they never wait for writers and writers never wait for them.
+// A writer (enroll, adaptive update, delete) copies only the segment it modifies, and publishes a new snapshot that
+// shares all other segments with the previous one. Old snapshots and segments are reclaimed when the last search
+// holding them drops its reference.
+//
+// Writers are serialized between themselves. Users are identified by user id (segment positions are internal).
+class RcuGallery
+{
+public:
+    // 64 users x ~2.2KB (search data + faceprints) = ~140KB copied per write.
+    static constexpr std::size_t DefaultSegmentSize = 64;
+
+    // immutable view of the gallery. valid (and unchanged) for as long as it is held.
+    class Snapshot
+    {
+    public:
+        std::size_t Size() const
+        {
+            return _size;
+        }
+
+        std::size_t NumberOfSegments() const
+        {
+            return _segments.size();
+        }
+
+        const Gallery& Segment(std::size_t index) const
+        {
+            return *_segments[index];
+        }
+
+        // incremented by every published write.
+        uint64_t Generation() const
+        {
+            return _generation;
+        }
+
+    private:
+        friend class RcuGallery;
+
+        std::vector<std::shared_ptr<const Gallery>> _segments;
+        std::size_t _size = 0;
+        uint64_t _generation = 0;
+    };
+
+    explicit RcuGallery(std::size_t segment_size = DefaultSegmentSize);
+
+    RcuGallery(const RcuGallery&) = delete;
+    RcuGallery& operator=(const RcuGallery&) = delete;
+
+    // current snapshot. never blocks on writers.
+    std::shared_ptr<const Snapshot> GetSnapshot() const;
+
+    std::size_t Size() const
+    {
+        return GetSnapshot()->Size();
+    }
+
+    // replace the gallery content with the users of the given gallery. user ids must be unique.
+    bool Assign(const Gallery& gallery);
+
+    // add new user. returns false if the user id exists or the faceprints version doesn't match.
+    bool Add(const char* user_id, const Faceprints& faceprints);
+
+    // replace faceprints of existing user.
+    bool Update(const char* user_id, const Faceprints& faceprints);
+
+    bool Remove(const char* user_id);
+
+    void Clear();
+
+    // search the current snapshot, same semantics as Matcher::MatchFaceprintsToGallery(). result userId is the
+    // position in the snapshot, matched_user_id is set when result isSame.
+    ExtendedMatchResult Match(const Faceprints& new_faceprints, Faceprints& updated_faceprints,
+                              const Thresholds& thresholds, std::string& matched_user_id) const;
+
+    // search and, if should_update, publish the adaptive update of the matched user. result should_update tells if
+    // the update was published: it is dropped if the user was modified or removed after the search took its snapshot
+    // (it was computed from faceprints that are no longer current).
+    ExtendedMatchResult MatchAndUpdate(const Faceprints& new_faceprints, const Thresholds& thresholds,
+                                       std::string& matched_user_id);
+
+private:
+    struct Location
+    {
+        std::size_t segment;
+        std::size_t slot;
+    };
+
+    // scan a snapshot (stops at the first score above threshold, like Matcher::GetScores()). best.id is the slot in
+    // segment best_segment.
+    static bool Search(const Faceprints& new_faceprints, const Snapshot& snapshot, match_calc_t threshold,
+                       TagResult& best, std::size_t& best_segment);
+
+    ExtendedMatchResult Match(const Faceprints& new_faceprints, Faceprints& updated_faceprints,
+                              const Thresholds& thresholds, std::string& matched_user_id,
+                              std::shared_ptr<const Snapshot>& snapshot, std::size_t& segment,
+                              std::size_t& slot) const;
+
+    // the functions below are called with _write_mutex held.
+
+    // copy of the current snapshot (sharing all segments), to be modified and published.
+    std::shared_ptr<Snapshot> CloneSnapshot() const;
+
+    // private copy of a segment of the cloned snapshot, safe to modify.
+    Gallery& CopySegment(Snapshot& snapshot, std::size_t segment);
+
+    void Publish(std::shared_ptr<Snapshot> snapshot);
+
+    bool UpdateLocked(const std::string& user_id, const Faceprints& faceprints, const Faceprints* expected);
+
+    const std::size_t _segment_size;
+
+    std::shared_ptr<const Snapshot> _snapshot;
+
+    std::mutex _write_mutex;
+    int _version = 0;
+    std::unordered_map<std::string, Location> _locations;
+};
+} // namespace RealSenseID
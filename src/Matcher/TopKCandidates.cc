@@ -0,0 +1,67 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "TopKCandidates.h"
+#include <algorithm>
+
+namespace RealSenseID
+{
+// true if lhs is a better candidate than rhs.
+static bool IsBetter(const MatchCandidate& lhs, const MatchCandidate& rhs)
+{
+    if (lhs.score != rhs.score)
+    {
+        return lhs.score > rhs.score;
+    }
+    return lhs.userId < rhs.userId;
+}
+
+TopKCandidates::TopKCandidates(std::size_t k) : _k(k)
+{
+    _heap.reserve(k);
+}
+
+void TopKCandidates::Push(int user_id, match_calc_t score)
+{
+    if (_k == 0)
+    {
+        return;
+    }
+
+    MatchCandidate candidate;
+    candidate.userId = user_id;
+    candidate.score = score;
+
+    // heap front is the worst of the kept candidates.
+    if (_heap.size() < _k)
+    {
+        _heap.push_back(candidate);
+        std::push_heap(_heap.begin(), _heap.end(), IsBetter);
+        return;
+    }
+
+    if (!IsBetter(candidate, _heap.front()))
+    {
+        return;
+    }
+
+    std::pop_heap(_heap.begin(), _heap.end(), IsBetter);
+    _heap.back() = candidate;
+    std::push_heap(_heap.begin(), _heap.end(), IsBetter);
+}
+
+void TopKCandidates::Merge(const TopKCandidates& other)
+{
+    for (const auto& candidate : other._heap)
+    {
+        Push(candidate.userId, candidate.score);
+    }
+}
+
+std::vector<MatchCandidate> TopKCandidates::Sorted() const
+{
+    std::vector<MatchCandidate> sorted = _heap;
+    std::sort(sorted.begin(), sorted.end(), IsBetter);
+    return sorted;
+}
+} // namespace RealSenseID
@@ -0,0 +1,53 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include <cstddef>
+#include <vector>
+
+namespace RealSenseID
+{
+// Bounded min-heap that keeps the K best candidates seen during a single pass over the gallery.
+// Ordering: higher score is better, on equal scores the lower index wins (same as the first-best rule of GetScores).
+class TopKCandidates
+{
+public:
+    explicit TopKCandidates(std::size_t k);
+
+    // O(log k). candidates worse than the current K-th best are dropped.
+    void Push(int user_id, match_calc_t score);
+
+    // merge candidates collected by another heap (e.g. of another gallery shard).
+    void Merge(const TopKCandidates& other);
+
+    bool Full() const
+    {
+        return _heap.size() >= _k;
+    }
+
+    std::size_t Size() const
+    {
+        return _heap.size();
+    }
+
+    // score of the K-th best candidate (only meaningful when Full()).
+    match_calc_t WorstScore() const
+    {
+        return _heap.empty() ? 0 : _heap.front().score;
+    }
+
+    // candidates sorted from best to worst. confidence field is not set.
+    std::vector<MatchCandidate> Sorted() const;
+
+    void Clear()
+    {
+        _heap.clear();
+    }
+
+private:
+    std::size_t _k;
+    std::vector<MatchCandidate> _heap;
+};
+} // namespace RealSenseID
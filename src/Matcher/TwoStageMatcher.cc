@@ -0,0 +1,160 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "TwoStageMatcher.h"
+#include "Gallery.h"
+#include "MatcherSimd.h"
+#include "TopKCandidates.h"
+#include <algorithm>
+#include <cmath>
+
+namespace RealSenseID
+{
+static_assert(Gallery::CodeWords == 4, "HammingDistances256 expects 256 bit codes");
+
+static const std::size_t s_maxHammingDistance = Gallery::CodeWords * 64;
+
+static std::size_t RescoreBudget(const Gallery& gallery, const TwoStageMatcher::Options& options)
+{
+    double fraction = std::max(0.0, std::min(1.0, options.rescore_fraction));
+    std::size_t budget = static_cast<std::size_t>(std::ceil(fraction * gallery.Size()));
+    return std::min(std::max(budget, options.min_rescore), gallery.Size());
+}
+
+std::vector<int> TwoStageMatcher::Prefilter(const feature_t* query, const Gallery& gallery, std::size_t budget)
+{
+    const std::size_t number_of_users = gallery.Size();
+
+    uint64_t query_code[Gallery::CodeWords];
+    Gallery::MakeCode(query, query_code);
+
+    std::vector<uint16_t> distances(number_of_users);
+    MatcherSimd::HammingDistances256(query_code, gallery.Codes(), number_of_users, distances.data());
+
+    // counting select: find the distance cutoff that keeps budget users, in O(N) and without sorting.
+    std::vector<std::size_t> histogram(s_maxHammingDistance + 1, 0);
+    for (std::size_t i = 0; i < number_of_users; i++)
+    {
+        if (gallery.IsValid(i))
+        {
+            histogram[distances[i]]++;
+        }
+    }
+
+    std::size_t cutoff = 0;
+    std::size_t below_cutoff = 0;
+    while (cutoff <= s_maxHammingDistance && below_cutoff + histogram[cutoff] < budget)
+    {
+        below_cutoff += histogram[cutoff];
+        cutoff++;
+    }
+    // users at exactly the cutoff distance fill what's left of the budget (lower index first).
+    std::size_t at_cutoff = budget - below_cutoff;
+
+    std::vector<int> candidates;
+    candidates.reserve(budget);
+    for (std::size_t i = 0; i < number_of_users; i++)
+    {
+        if (!gallery.IsValid(i))
+        {
+            continue;
+        }
+
+        if (distances[i] < cutoff)
+        {
+            candidates.push_back(static_cast<int>(i));
+        }
+        else if (distances[i] == cutoff && at_cutoff > 0)
+        {
+            candidates.push_back(static_cast<int>(i));
+            at_cutoff--;
+        }
+    }
+
+    return candidates;
+}
+
+void TwoStageMatcher::Rescore(const feature_t* query, const Gallery& gallery, const std::vector<int>& candidates,
+                              std::size_t k, std::vector<MatchCandidate>& result, TagResult& best)
+{
+    const uint32_t vec_length = Gallery::VectorLength;
+    const uint32_t query_norm = MatcherSimd::ComputeSums(query, query, vec_length).norm1;
+
+    best.score = 0;
+    best.id = -1;
+    TopKCandidates topk(std::min(k, candidates.size()));
+
+    // candidates are in index order, so strict '>' keeps the lowest index on equal scores.
+    for (int index : candidates)
+    {
+        int32_t corr = MatcherSimd::DotProduct(query, gallery.Descriptor(index), vec_length);
+        match_calc_t score = Matcher::NormalizeScore(corr, query_norm, gallery.Norm(index));
+        topk.Push(index, score);
+
+        if (score > best.score)
+        {
+            best.score = score;
+            best.id = index;
+        }
+    }
+
+    result = topk.Sorted();
+}
+
+std::vector<MatchCandidate> TwoStageMatcher::MatchTopK(const Faceprints& new_faceprints, const Gallery& gallery,
+                                                       std::size_t k, const Thresholds& thresholds,
+                                                       const Options& options, Stats* stats)
+{
+    std::vector<MatchCandidate> result;
+
+    if (k == 0 || !Matcher::ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return result;
+    }
+
+    const feature_t* query = &new_faceprints.adaptiveDescriptorWithoutMask[0];
+    std::vector<int> candidates = Prefilter(query, gallery, RescoreBudget(gallery, options));
+
+    TagResult best;
+    Rescore(query, gallery, candidates, k, result, best);
+
+    ExtendedMatchResult unused;
+    for (auto& candidate : result)
+    {
+        candidate.confidence = Matcher::CalculateConfidence(candidate.score, thresholds.strongThreshold_pNMgNM, unused);
+    }
+
+    if (stats != nullptr)
+    {
+        stats->prefiltered = gallery.Size();
+        stats->rescored = candidates.size();
+    }
+
+    return result;
+}
+
+ExtendedMatchResult TwoStageMatcher::Match(const Faceprints& new_faceprints, const Gallery& gallery,
+                                           Faceprints& updated_faceprints, const Thresholds& thresholds,
+                                           const Options& options, Stats* stats)
+{
+    if (!Matcher::ValidateGalleryQuery(new_faceprints, gallery))
+    {
+        return ExtendedMatchResult();
+    }
+
+    const feature_t* query = &new_faceprints.adaptiveDescriptorWithoutMask[0];
+    std::vector<int> candidates = Prefilter(query, gallery, RescoreBudget(gallery, options));
+
+    std::vector<MatchCandidate> unused_topk;
+    TagResult best;
+    Rescore(query, gallery, candidates, 0, unused_topk, best);
+
+    if (stats != nullptr)
+    {
+        stats->prefiltered = gallery.Size();
+        stats->rescored = candidates.size();
+    }
+
+    return Matcher::FinalizeGalleryMatch(new_faceprints, gallery, best, updated_faceprints, thresholds);
+}
+} // namespace RealSenseID
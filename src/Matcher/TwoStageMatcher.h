@@ -0,0 +1,54 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+#include <cstddef>
+#include <vector>
+
+namespace RealSenseID
+{
+class Gallery;
+
+// Two-stage gallery search:
+// (1) prefilter - rank all users by hamming distance between the 256-bit sign codes of the probe and the gallery
+//     (popcount, 32 bytes per user - 1M users fit in 32MB and scan at memory bandwidth).
+// (2) rescore - exact integer ncc (identical to Matcher::MatchTwoVectors) on the closest codes only.
+//
+// Rescored scores are exact, so thresholds and confidence keep their meaning; only users dropped by the prefilter
+// can be missed (see the "prefilter" benchmark in rsid-matcher-bench for recall).
+class TwoStageMatcher
+{
+public:
+    struct Options
+    {
+        // rescore budget: fraction of the gallery rescored with the exact ncc, but at least min_rescore users.
+        double rescore_fraction = 0.01;
+        std::size_t min_rescore = 64;
+    };
+
+    struct Stats
+    {
+        std::size_t prefiltered = 0; // users ranked by hamming distance
+        std::size_t rescored = 0;    // users scored with exact ncc
+    };
+
+    // K best candidates (sorted by descending exact score) among the rescored users.
+    static std::vector<MatchCandidate> MatchTopK(const Faceprints& new_faceprints, const Gallery& gallery, std::size_t k,
+                                                 const Thresholds& thresholds, const Options& options,
+                                                 Stats* stats = nullptr);
+
+    // same semantics as Matcher::MatchFaceprintsToGallery() (exhaustive over the rescored users).
+    static ExtendedMatchResult Match(const Faceprints& new_faceprints, const Gallery& gallery,
+                                     Faceprints& updated_faceprints, const Thresholds& thresholds,
+                                     const Options& options, Stats* stats = nullptr);
+
+private:
+    // indices of the (at most) budget valid users with the smallest hamming distance, in increasing index order.
+    static std::vector<int> Prefilter(const feature_t* query, const Gallery& gallery, std::size_t budget);
+
+    static void Rescore(const feature_t* query, const Gallery& gallery, const std::vector<int>& candidates,
+                        std::size_t k, std::vector<MatchCandidate>& result, TagResult& best);
+};
+} // namespace RealSenseID
@@ -0,0 +1,115 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "WorkerPool.h"
+
+namespace RealSenseID
+{
+WorkerPool::WorkerPool(std::size_t num_threads)
+{
+    if (num_threads == 0)
+    {
+        num_threads = std::thread::hardware_concurrency();
+    }
+    if (num_threads == 0)
+    {
+        num_threads = 1;
+    }
+
+    _workers.reserve(num_threads - 1);
+    for (std::size_t i = 1; i < num_threads; i++)
+    {
+        _workers.emplace_back(&WorkerPool::WorkerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _work_cv.notify_all();
+
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void WorkerPool::ParallelFor(std::size_t num_tasks, const std::function<void(std::size_t)>& task)
+{
+    if (num_tasks == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> job_lock(_job_mutex);
+
+    // no point waking up the workers for a single task
+    if (num_tasks == 1 || _workers.empty())
+    {
+        for (std::size_t i = 0; i < num_tasks; i++)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _task = &task;
+        _num_tasks = num_tasks;
+        _next_task = 0;
+        _busy_workers = _workers.size();
+        _generation++;
+    }
+    _work_cv.notify_all();
+
+    RunTasks();
+
+    // every worker checks in for every job, so the task reference is not used after this returns.
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done_cv.wait(lock, [this] { return _busy_workers == 0; });
+    _task = nullptr;
+}
+
+void WorkerPool::RunTasks()
+{
+    for (;;)
+    {
+        std::size_t i = _next_task.fetch_add(1);
+        if (i >= _num_tasks)
+        {
+            return;
+        }
+        (*_task)(i);
+    }
+}
+
+void WorkerPool::WorkerLoop()
+{
+    uint64_t seen_generation = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _work_cv.wait(lock, [&] { return _stop || _generation != seen_generation; });
+            if (_stop)
+            {
+                return;
+            }
+            seen_generation = _generation;
+        }
+
+        RunTasks();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_busy_workers == 0)
+        {
+            _done_cv.notify_one();
+        }
+    }
+}
+} // namespace RealSenseID
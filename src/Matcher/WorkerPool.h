@@ -0,0 +1,58 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RealSenseID
+{
+// Persistent pool of worker threads running parallel-for jobs.
+// The calling thread takes part in each job, so a pool of N threads starts N-1 workers.
+// Jobs are serialized: concurrent ParallelFor() calls run one after the other.
+class WorkerPool
+{
+public:
+    // num_threads = 0 uses std::thread::hardware_concurrency().
+    explicit WorkerPool(std::size_t num_threads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // number of threads taking part in each job (including the calling thread).
+    std::size_t NumThreads() const
+    {
+        return _workers.size() + 1;
+    }
+
+    // run task(0) .. task(num_tasks - 1) on the pool and block until all of them completed.
+    // tasks are handed out dynamically, in increasing index order.
+    void ParallelFor(std::size_t num_tasks, const std::function<void(std::size_t)>& task);
+
+private:
+    void WorkerLoop();
+    void RunTasks();
+
+    std::vector<std::thread> _workers;
+
+    std::mutex _job_mutex; // serializes jobs
+    std::mutex _mutex;
+    std::condition_variable _work_cv;
+    std::condition_variable _done_cv;
+
+    const std::function<void(std::size_t)>* _task = nullptr;
+    std::size_t _num_tasks = 0;
+    std::atomic<std::size_t> _next_task {0};
+    std::size_t _busy_workers = 0;
+    uint64_t _generation = 0;
+    bool _stop = false;
+};
+} // namespace RealSenseID
@@ -111,7 +111,7 @@ AndroidSerial::AndroidSerial(int file_descriptor, int read_endpoint_address, int
     StartReadFromDeviceWorkingThread();
 }
 
-SerialStatus AndroidSerial::RecvBytes(char* buffer, size_t n_bytes)
+SerialStatus AndroidSerial::ReadBytes(char* buffer, size_t n_bytes)
 {
     if (n_bytes == 0)
     {
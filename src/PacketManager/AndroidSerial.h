@@ -28,8 +28,9 @@ public:
     // send all bytes and return status
     SerialStatus SendBytes(const char* buffer, size_t n_bytes) final;
 
+protected:
     // receive all bytes and copy to the buffer
-    SerialStatus RecvBytes(char* buffer, size_t n_bytes) final;
+    SerialStatus ReadBytes(char* buffer, size_t n_bytes) final;
 
 private:
     int _file_descriptor;
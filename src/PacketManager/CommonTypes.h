@@ -24,6 +24,8 @@ struct SerialConfig
     unsigned char bytesize = 8;
     unsigned char stopbits = 0; // 0=1 stopbits, 1=1.5 stopbits, 2=2 stopbits
     unsigned char parity = 0;
+    bool drain_after_send = false; // wait until every sent byte was transmitted before returning from a send
+    bool event_driven = false;     // linux: non-blocking port waited with ppoll (false - VTIME timed reads)
 };
 
 enum class RSID_NO_DISCARD SerialStatus
@@ -33,6 +35,7 @@ enum class RSID_NO_DISCARD SerialStatus
     SendFailed,
     RecvTimeout,
     RecvFailed,
+    RecvInterrupted,
     RecvUnexpectedPacket,
     SecurityError,
     VersionMismatch,
@@ -40,5 +43,13 @@ enum class RSID_NO_DISCARD SerialStatus
 };
 
 using timeout_t = std::chrono::milliseconds;
+
+// lifetime of a session across operations (see the sessions' Resume())
+struct SessionPolicy
+{
+    bool resume = false;              // keep the session across operations
+    unsigned int max_operations = 0;  // start a new session after this many operations (0 - no limit)
+    timeout_t max_age {0};            // start a new session after this time (0 - no limit)
+};
 } // namespace PacketManager
 } // namespace RealSenseID
\ No newline at end of file
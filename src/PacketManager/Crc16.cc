@@ -27,17 +27,85 @@ static const uint16_t CRC16_LOOKUP[256] = {
     0x2e93, 0x3eb2, 0x0ed1, 0x1ef0};
 
 static const unsigned int CRC16_INITIAL_VAL = 0x1d0f;
+static const unsigned int CRC16_POLYNOM = 0x1021;
 
+// slicing-by-8 tables: CRC16_SLICES[k][b] is the crc register after byte b followed by k zero bytes (from 0).
+// CRC16_SLICES[0] is CRC16_LOOKUP.
+struct Crc16Slices
+{
+    uint16_t table[8][256];
+
+    Crc16Slices()
+    {
+        for (unsigned int b = 0; b < 256; b++)
+        {
+            table[0][b] = CRC16_LOOKUP[b];
+            for (int k = 1; k < 8; k++)
+            {
+                unsigned int prev = table[k - 1][b];
+                table[k][b] = static_cast<uint16_t>(CRC16_LOOKUP[prev >> 8] ^ (prev << 8));
+            }
+        }
+    }
+};
+
+static const Crc16Slices CRC16_SLICES;
+
+// (a * b) mod polynom, polynomials over gf(2) of degree < 16.
+static uint16_t MultiplyModPolynom(uint16_t a, uint16_t b)
+{
+    unsigned int product = 0;
+    unsigned int shifted = a;
+    for (int bit = 0; bit < 16; bit++)
+    {
+        if (b & (1u << bit))
+        {
+            product ^= shifted;
+        }
+        shifted = (shifted << 1) ^ ((shifted & 0x8000) ? CRC16_POLYNOM : 0);
+        shifted &= 0xffff;
+    }
+    return static_cast<uint16_t>(product);
+}
+
+// x^(8 * 2^k) mod polynom - the effect of 2^k zero bytes on the crc register.
+struct Crc16ZeroPowers
+{
+    uint16_t power[64];
+
+    Crc16ZeroPowers()
+    {
+        // one zero byte multiplies the register by x^8
+        power[0] = 0x0100;
+        for (int k = 1; k < 64; k++)
+        {
+            power[k] = MultiplyModPolynom(power[k - 1], power[k - 1]);
+        }
+    }
+};
+
+static const Crc16ZeroPowers CRC16_ZERO_POWERS;
 
 uint16_t RealSenseID::PacketManager::Crc16(uint16_t initial_crc, const char* buffer, std::size_t bufferSize)
 {
+    const auto& t = CRC16_SLICES.table;
     unsigned int crc = initial_crc;
-    auto* bytePtr = buffer;
+    auto* bytePtr = reinterpret_cast<const unsigned char*>(buffer);
+
+    // 8 bytes per step: the register is xor-ed into the first two bytes, then each byte is advanced through the
+    // bytes after it with one table lookup.
+    while (bufferSize >= 8)
+    {
+        crc = t[7][bytePtr[0] ^ (crc >> 8)] ^ t[6][bytePtr[1] ^ (crc & 0xff)] ^ t[5][bytePtr[2]] ^ t[4][bytePtr[3]] ^
+              t[3][bytePtr[4]] ^ t[2][bytePtr[5]] ^ t[1][bytePtr[6]] ^ t[0][bytePtr[7]];
+        bytePtr += 8;
+        bufferSize -= 8;
+    }
 
     while (bufferSize-- > 0)
     {
         auto idx = ((crc >> 8) ^ *bytePtr) & 0xff;
-        crc = CRC16_LOOKUP[idx] ^ (crc << 8);
+        crc = (CRC16_LOOKUP[idx] ^ (crc << 8)) & 0xffff;
         ++bytePtr;
     }
     return static_cast<uint16_t>(crc);
@@ -47,3 +115,16 @@ uint16_t RealSenseID::PacketManager::Crc16(const char* buffer, std::size_t buffe
 {
     return Crc16(CRC16_INITIAL_VAL, buffer, bufferSize);
 }
+
+uint16_t RealSenseID::PacketManager::Crc16Zeros(uint16_t crc, std::size_t n_zeros)
+{
+    // zero bytes don't feed anything into the register, they only shift it: crc * x^(8 * n_zeros) mod polynom
+    for (int k = 0; n_zeros != 0; k++, n_zeros >>= 1)
+    {
+        if (n_zeros & 1)
+        {
+            crc = MultiplyModPolynom(crc, CRC16_ZERO_POWERS.power[k]);
+        }
+    }
+    return crc;
+}
@@ -10,7 +10,11 @@ namespace RealSenseID
 {
 namespace PacketManager
 {
+// crc-16/aug-ccitt. Crc16(initial_crc, ...) continues a crc over more bytes.
 uint16_t Crc16(uint16_t initial_crc, const char* buffer, std::size_t bufferSize);
 uint16_t Crc16(const char* buffer, std::size_t bufferSize);
+
+// continue a crc over n_zeros zero bytes (same as Crc16(crc, zeros, n_zeros), in log(n_zeros) steps).
+uint16_t Crc16Zeros(uint16_t crc, std::size_t n_zeros);
 } // namespace PacketManager
 } // namespace RealSenseID
@@ -0,0 +1,145 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "FrameReader.h"
+#include "Logger.h"
+#include <string.h>
+#include <cassert>
+
+static const char* LOG_TAG = "FrameReader";
+
+namespace RealSenseID
+{
+namespace PacketManager
+{
+constexpr size_t FrameReader::HeaderSize;
+constexpr size_t FrameReader::TrailerSize;
+constexpr size_t FrameReader::MaxPayloadSize;
+constexpr size_t FrameReader::MaxFrameSize;
+constexpr size_t FrameReader::BufferSize;
+
+uint16_t SerialFrame::Crc() const
+{
+    uint16_t crc;
+    ::memcpy(&crc, data + size - sizeof(crc), sizeof(crc));
+    return crc;
+}
+
+void SerialFrame::CopyTo(SerialPacket& packet) const
+{
+    auto* payload = reinterpret_cast<char*>(&packet.payload);
+    ::memcpy(&packet.header, data, sizeof(packet.header));
+    ::memcpy(payload, Payload(), PayloadSize());
+    ::memset(payload + PayloadSize(), 0, sizeof(packet.payload) - PayloadSize());
+    ::memcpy(packet.hmac, Hmac(), sizeof(packet.hmac));
+    packet.crc = Crc();
+}
+
+FrameReader::ParseResult FrameReader::Parse(SerialFrame& frame)
+{
+    for (;;)
+    {
+        const char* start = _buffer + _begin;
+        const auto* sync = static_cast<const char*>(::memchr(start, static_cast<char>(SyncByte::Sync1), Buffered()));
+        if (sync == nullptr)
+        {
+            // no frame starts in these bytes
+            _begin = _end;
+            return ParseResult::NeedMore;
+        }
+
+        _begin += static_cast<size_t>(sync - start);
+        const size_t available = Buffered();
+        if (available < 2)
+        {
+            return ParseResult::NeedMore;
+        }
+        if (sync[1] != static_cast<char>(SyncByte::Sync2))
+        {
+            _begin++;
+            continue;
+        }
+
+        if (available < 3)
+        {
+            return ParseResult::NeedMore;
+        }
+        const auto protocol_ver = static_cast<unsigned char>(sync[2]);
+        if (protocol_ver != ProtocolVer)
+        {
+            LOG_ERROR(LOG_TAG, "Protocol version doesn't match. Expected: %u, Received: %u", ProtocolVer, protocol_ver);
+            _begin += 3;
+            return ParseResult::VersionMismatch;
+        }
+
+        if (available < HeaderSize)
+        {
+            return ParseResult::NeedMore;
+        }
+        const auto& header = *reinterpret_cast<const SerialPacketHeader*>(sync);
+        if (header.payload_size > MaxPayloadSize)
+        {
+            LOG_ERROR(LOG_TAG, "Packet size is bigger than payload max size");
+            _begin += HeaderSize;
+            return ParseResult::InvalidSize;
+        }
+
+        const size_t frame_size = HeaderSize + header.payload_size + TrailerSize;
+        if (available < frame_size)
+        {
+            return ParseResult::NeedMore;
+        }
+
+        frame.data = sync;
+        frame.size = frame_size;
+        _begin += frame_size;
+        return ParseResult::Frame;
+    }
+}
+
+char* FrameReader::GetWriteSpace(size_t& n_bytes)
+{
+    if (_begin == _end)
+    {
+        _begin = _end = 0;
+    }
+    else if (BufferSize - _end < MaxFrameSize)
+    {
+        // at most one incomplete frame is left - move it to the front.
+        ::memmove(_buffer, _buffer + _begin, Buffered());
+        _end -= _begin;
+        _begin = 0;
+    }
+
+    n_bytes = BufferSize - _end;
+    return _buffer + _end;
+}
+
+void FrameReader::Commit(size_t n_bytes)
+{
+    assert(_end + n_bytes <= BufferSize);
+    _end += n_bytes;
+}
+
+size_t FrameReader::Take(char* buffer, size_t n_bytes)
+{
+    const size_t n_taken = (n_bytes < Buffered()) ? n_bytes : Buffered();
+    ::memcpy(buffer, _buffer + _begin, n_taken);
+    _begin += n_taken;
+    return n_taken;
+}
+
+void FrameReader::DropIncompleteFrame()
+{
+    if (Buffered() > 0 && _buffer[_begin] == static_cast<char>(SyncByte::Sync1))
+    {
+        _begin++;
+    }
+}
+
+void FrameReader::Clear()
+{
+    _begin = _end = 0;
+}
+} // namespace PacketManager
+} // namespace RealSenseID
@@ -0,0 +1,100 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "SerialPacket.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace RealSenseID
+{
+namespace PacketManager
+{
+using SerialPacketHeader = decltype(SerialPacket::header);
+
+// Received frame, viewed in place in the receive buffer: the header, payload_size bytes of payload, the hmac and the
+// crc as they were sent (the unused payload bytes are not sent).
+// Valid until the next receive on the connection.
+struct SerialFrame
+{
+    const char* data = nullptr; // frame bytes, header first
+    size_t size = 0;
+
+    const SerialPacketHeader& Header() const
+    {
+        return *reinterpret_cast<const SerialPacketHeader*>(data);
+    }
+
+    uint16_t PayloadSize() const
+    {
+        return Header().payload_size;
+    }
+
+    const char* Payload() const
+    {
+        return data + sizeof(SerialPacketHeader);
+    }
+
+    const char* Hmac() const
+    {
+        return Payload() + PayloadSize();
+    }
+
+    uint16_t Crc() const;
+
+    // copy to a packet (the unused payload bytes are zeroed)
+    void CopyTo(SerialPacket& packet) const;
+};
+
+// Receive buffer of a serial connection, and the frame parser working in place on it.
+// The connection reads everything available into the free space at the end of the buffer. Parse() scans for the
+// sync bytes with memchr and returns complete frames as views into the buffer. Consumed bytes are reclaimed by moving
+// the unparsed tail to the front when more space is needed, so a frame is always contiguous.
+class FrameReader
+{
+public:
+    static constexpr size_t HeaderSize = sizeof(SerialPacketHeader);
+    static constexpr size_t TrailerSize = sizeof(SerialPacket::hmac) + sizeof(SerialPacket::crc);
+    static constexpr size_t MaxPayloadSize = sizeof(SerialPacket::payload);
+    static constexpr size_t MaxFrameSize = HeaderSize + MaxPayloadSize + TrailerSize;
+    static constexpr size_t BufferSize = 8 * MaxFrameSize;
+
+    enum class ParseResult
+    {
+        Frame,           // complete frame (crc not checked yet)
+        NeedMore,        // no complete frame in the buffered bytes
+        VersionMismatch, // sync bytes followed by another protocol version
+        InvalidSize      // header with payload size bigger than the payload max size
+    };
+
+    // next frame from the buffered bytes. bytes before the sync bytes are dropped. the frame (or the invalid
+    // header) is consumed, but stays in the buffer until the next GetWriteSpace().
+    ParseResult Parse(SerialFrame& frame);
+
+    // free space for the next read (the whole remaining space, at least MaxFrameSize).
+    char* GetWriteSpace(size_t& n_bytes);
+
+    // n_bytes were written to the write space.
+    void Commit(size_t n_bytes);
+
+    size_t Buffered() const
+    {
+        return _end - _begin;
+    }
+
+    // consume buffered bytes as they are. returns the number of bytes copied.
+    size_t Take(char* buffer, size_t n_bytes);
+
+    // give up an incomplete frame (on timeout) - the next parse resyncs after its sync bytes.
+    void DropIncompleteFrame();
+
+    void Clear();
+
+private:
+    char _buffer[BufferSize];
+    size_t _begin = 0; // first unparsed byte
+    size_t _end = 0;   // end of buffered bytes
+};
+} // namespace PacketManager
+} // namespace RealSenseID
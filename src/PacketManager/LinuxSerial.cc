@@ -9,9 +9,14 @@
 #include <stdexcept>
 #include <thread>
 #include <unistd.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <string.h>
 #include <termios.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
 #include <errno.h>
 #include <cassert>
 #include <cmath>
@@ -58,6 +63,10 @@ LinuxSerial::~LinuxSerial()
     try
     {
         ::close(_handle);
+        if (_wakeup_handle >= 0)
+        {
+            ::close(_wakeup_handle);
+        }
     }
     catch (...)
     {
@@ -76,6 +85,24 @@ static void throw_on_error(int result, const char* err_msg, int handle_to_close)
         throw std::runtime_error(std::string(buf));
     }
 }
+// ask the driver to push received bytes to the tty right away (instead of its flip buffer timer)
+static bool SetLowLatency(int handle)
+{
+    struct serial_struct serial_info;
+    if (::ioctl(handle, TIOCGSERIAL, &serial_info) != 0)
+    {
+        LOG_DEBUG(LOG_TAG, "ASYNC_LOW_LATENCY not supported by the driver (errno %d)", errno);
+        return false;
+    }
+    serial_info.flags |= ASYNC_LOW_LATENCY;
+    if (::ioctl(handle, TIOCSSERIAL, &serial_info) != 0)
+    {
+        LOG_DEBUG(LOG_TAG, "Failed setting ASYNC_LOW_LATENCY (errno %d)", errno);
+        return false;
+    }
+    return true;
+}
+
 LinuxSerial::LinuxSerial(const SerialConfig& config) : _config {config}
 {
     LOG_DEBUG(LOG_TAG, "Opening serial port %s baudrate %u", config.port, config.baudrate);
@@ -97,9 +124,18 @@ LinuxSerial::LinuxSerial(const SerialConfig& config) : _config {config}
     throw_on_error(::cfsetispeed(&options, baudRate), "cfsetispeed", _handle);
     throw_on_error(::cfsetospeed(&options, baudRate), "cfsetospeed", _handle);
 
-    // return whatever bytes available after 200ms max
-    options.c_cc[VTIME] = 2;
-    options.c_cc[VMIN] = 0;
+    if (config.event_driven)
+    {
+        // non-blocking reads, waiting is done in ppoll
+        options.c_cc[VTIME] = 0;
+        options.c_cc[VMIN] = 1;
+    }
+    else
+    {
+        // return whatever bytes available after 200ms max
+        options.c_cc[VTIME] = 2;
+        options.c_cc[VMIN] = 0;
+    }
     options.c_cflag |= (CLOCAL | CREAD | CS8);
     options.c_iflag |= (IGNPAR | IGNBRK);
 
@@ -107,17 +143,58 @@ LinuxSerial::LinuxSerial(const SerialConfig& config) : _config {config}
 
     // discard any existing data in input/output buffers
     ::tcflush(_handle, TCIOFLUSH);
+
+    if (config.event_driven)
+    {
+        throw_on_error(::fcntl(_handle, F_SETFL, ::fcntl(_handle, F_GETFL) | O_NONBLOCK), "fcntl O_NONBLOCK", _handle);
+        _wakeup_handle = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        throw_on_error(_wakeup_handle, "eventfd", _handle);
+        _low_latency = SetLowLatency(_handle);
+    }
 }
 
 SerialStatus LinuxSerial::SendBytes(const char* buffer, size_t n_bytes)
 {
+    SendBuffer send_buffer {buffer, n_bytes};
+    return SendBuffers(&send_buffer, 1);
+}
+
+SerialStatus LinuxSerial::SendBuffers(const SendBuffer* buffers, size_t n_buffers)
+{
+    static const size_t max_buffers = 8;
+    if (n_buffers > max_buffers)
+    {
+        // not expected from the packet sender - send in groups
+        auto status = SendBuffers(buffers, max_buffers);
+        return status == SerialStatus::Ok ? SendBuffers(buffers + max_buffers, n_buffers - max_buffers) : status;
+    }
+
+    struct iovec iov[max_buffers];
+    size_t n_bytes = 0;
+    for (size_t i = 0; i < n_buffers; i++)
+    {
+        DEBUG_SERIAL(LOG_TAG, "[snd]", buffers[i].data, buffers[i].size);
+        iov[i].iov_base = const_cast<char*>(buffers[i].data);
+        iov[i].iov_len = buffers[i].size;
+        n_bytes += buffers[i].size;
+    }
+
+    // one writev for all buffers, continued after partial writes
     size_t bytes_sent = 0;
+    size_t first = 0;
     while (n_bytes > bytes_sent)
     {
-        auto* send_ptr = &buffer[bytes_sent];
-        size_t n_bytes_left = n_bytes - bytes_sent;
-        DEBUG_SERIAL(LOG_TAG, "[snd]", send_ptr, n_bytes_left);
-        auto write_rv = ::write(_handle, send_ptr, n_bytes_left);
+        auto write_rv = ::writev(_handle, &iov[first], static_cast<int>(n_buffers - first));
+        if (write_rv < 0 && errno == EAGAIN)
+        {
+            // non-blocking port with a full output buffer
+            if (WaitForPort(POLLOUT, Timer::clock::time_point::max(), false) != SerialStatus::Ok)
+            {
+                LOG_ERROR(LOG_TAG, "Error while waiting to send %zu bytes", n_bytes - bytes_sent);
+                return SerialStatus::SendFailed;
+            }
+            continue;
+        }
         if (write_rv <= 0)
         {
             LOG_ERROR(LOG_TAG, "Error while sending %zu bytes. errno=%d, sent so far: %zu, write rv=%zu", n_bytes,
@@ -125,18 +202,39 @@ SerialStatus LinuxSerial::SendBytes(const char* buffer, size_t n_bytes)
             return SerialStatus::SendFailed;
         }
         bytes_sent += static_cast<size_t>(write_rv);
-        ::tcdrain(_handle);
 #ifdef RSID_DEBUG_SERIAL
         LOG_DEBUG(LOG_TAG, "[snd] Sent %zu/%zu", bytes_sent, n_bytes);
 #endif
+
+        auto written = static_cast<size_t>(write_rv);
+        while (first < n_buffers && written >= iov[first].iov_len)
+        {
+            written -= iov[first].iov_len;
+            first++;
+        }
+        if (first < n_buffers)
+        {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + written;
+            iov[first].iov_len -= written;
+        }
     }
     assert(n_bytes == bytes_sent);
 
+    return _config.drain_after_send ? Drain() : SerialStatus::Ok;
+}
+
+SerialStatus LinuxSerial::Drain()
+{
+    if (::tcdrain(_handle) != 0)
+    {
+        LOG_ERROR(LOG_TAG, "tcdrain failed. errno=%d", errno);
+        return SerialStatus::SendFailed;
+    }
     return SerialStatus::Ok;
 }
 
 // receive all bytes and copy to the buffer or return error status
-SerialStatus LinuxSerial::RecvBytes(char* buffer, size_t n_bytes)
+SerialStatus LinuxSerial::ReadBytes(char* buffer, size_t n_bytes)
 {
     if (n_bytes == 0)
     {
@@ -162,6 +260,15 @@ SerialStatus LinuxSerial::RecvBytes(char* buffer, size_t n_bytes)
                 return SerialStatus::Ok;
             }
         }
+        else if (last_read_result < 0 && errno == EAGAIN)
+        {
+            // event-driven: wait for more bytes up to the deadline
+            auto status = WaitForPort(POLLIN, timer.Deadline(), false);
+            if (status == SerialStatus::RecvFailed)
+            {
+                return status;
+            }
+        }
         else if (last_read_result < 0)
         {
             LOG_ERROR(LOG_TAG, "[rcv] rv=%d errorno %d", last_read_result, errno);
@@ -177,5 +284,114 @@ SerialStatus LinuxSerial::RecvBytes(char* buffer, size_t n_bytes)
     
     return SerialStatus::RecvTimeout;
 }
+
+// single read of whatever the driver has. without data it returns within 200ms (see VTIME), or in event-driven mode
+// waits in ppoll for the data, the timer's deadline or a wakeup.
+SerialStatus LinuxSerial::ReadAvailable(char* buffer, size_t max_bytes, size_t& n_read, const Timer& timer)
+{
+    n_read = 0;
+    auto read_result = ::read(_handle, buffer, max_bytes);
+    if (read_result < 0 && errno == EAGAIN)
+    {
+        auto status = WaitForPort(POLLIN, timer.Deadline(), true);
+        if (status != SerialStatus::Ok)
+        {
+            return status;
+        }
+        auto wakeup = Timer::clock::now();
+        read_result = ::read(_handle, buffer, max_bytes);
+        if (read_result > 0)
+        {
+            AddWakeup(wakeup);
+        }
+        else if (read_result < 0 && errno == EAGAIN)
+        {
+            return SerialStatus::RecvTimeout;
+        }
+    }
+
+    if (read_result < 0)
+    {
+        LOG_ERROR(LOG_TAG, "[rcv] rv=%d errorno %d", read_result, errno);
+        return SerialStatus::RecvFailed;
+    }
+    if (read_result == 0)
+    {
+        return SerialStatus::RecvTimeout;
+    }
+
+    DEBUG_SERIAL(LOG_TAG, "[rcv]", buffer, read_result);
+    n_read = static_cast<size_t>(read_result);
+    return SerialStatus::Ok;
+}
+
+void LinuxSerial::WakeUp()
+{
+    if (_wakeup_handle >= 0)
+    {
+        uint64_t count = 1;
+        auto ignored = ::write(_wakeup_handle, &count, sizeof(count));
+        (void)ignored;
+    }
+}
+
+SerialStatus LinuxSerial::WaitForPort(short events, Timer::clock::time_point deadline, bool interruptible)
+{
+    struct pollfd fds[2] = {{_handle, events, 0}, {_wakeup_handle, POLLIN, 0}};
+    const nfds_t n_fds = (interruptible && _wakeup_handle >= 0) ? 2 : 1;
+    for (;;)
+    {
+        struct timespec timeout = {0, 0};
+        struct timespec* timeout_ptr = nullptr;
+        if (deadline != Timer::clock::time_point::max())
+        {
+            auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Timer::clock::now()).count();
+            if (left <= 0)
+            {
+                return SerialStatus::RecvTimeout;
+            }
+            timeout.tv_sec = static_cast<time_t>(left / 1000000000);
+            timeout.tv_nsec = static_cast<long>(left % 1000000000);
+            timeout_ptr = &timeout;
+        }
+
+        auto poll_rv = ::ppoll(fds, n_fds, timeout_ptr, nullptr);
+        if (poll_rv < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (poll_rv < 0)
+        {
+            LOG_ERROR(LOG_TAG, "ppoll failed. errno=%d", errno);
+            return SerialStatus::RecvFailed;
+        }
+        if (poll_rv == 0)
+        {
+            return SerialStatus::RecvTimeout;
+        }
+
+        // pending data is returned before the wakeup is handled
+        if (fds[0].revents != 0)
+        {
+            return SerialStatus::Ok;
+        }
+        uint64_t count;
+        auto ignored = ::read(_wakeup_handle, &count, sizeof(count));
+        (void)ignored;
+        return SerialStatus::RecvInterrupted;
+    }
+}
+
+void LinuxSerial::AddWakeup(Timer::clock::time_point wakeup)
+{
+    auto ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Timer::clock::now() - wakeup).count());
+    _wakeup_stats.wakeups++;
+    _wakeup_stats.total_ns += ns;
+    if (ns > _wakeup_stats.max_ns)
+    {
+        _wakeup_stats.max_ns = ns;
+    }
+}
 } // namespace PacketManager
 } // namespace RealSenseID
@@ -2,14 +2,27 @@
 // Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
 #pragma once
 #include "SerialConnection.h"
+#include "Timer.h"
+#include <cstdint>
 
 namespace RealSenseID
 {
 namespace PacketManager
 {
+// With SerialConfig::event_driven the port is non-blocking and receives wait in ppoll() until the data arrives, the
+// exact deadline passes or InterruptRecv() signals the wakeup eventfd. ASYNC_LOW_LATENCY is requested from the driver
+// (not supported by usb acm and pseudo-terminals). Otherwise reads wait on the termios timer (VTIME, 200ms).
 class LinuxSerial : public SerialConnection
 {
 public:
+    // event-driven receives that waited for data: time from the ppoll() wakeup until the bytes were read.
+    struct WakeupStats
+    {
+        size_t wakeups = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+    };
+
     explicit LinuxSerial(const SerialConfig& config);
     ~LinuxSerial() override;
 
@@ -21,12 +34,46 @@ public:
     // send all bytes and return status
     SerialStatus SendBytes(const char* buffer, size_t n_bytes) final;
 
+    // send all buffers with writev
+    SerialStatus SendBuffers(const SendBuffer* buffers, size_t n_buffers) final;
+
+    // tcdrain
+    SerialStatus Drain() final;
+
+    // ASYNC_LOW_LATENCY was set on the port
+    bool IsLowLatency() const
+    {
+        return _low_latency;
+    }
+
+    // read while no receive is in progress
+    WakeupStats GetWakeupStats() const
+    {
+        return _wakeup_stats;
+    }
+
+protected:
     // receive all bytes and copy to the buffer
-    SerialStatus RecvBytes(char* buffer, size_t n_bytes) final;
+    SerialStatus ReadBytes(char* buffer, size_t n_bytes) final;
+
+    // receive the bytes available (single read)
+    SerialStatus ReadAvailable(char* buffer, size_t max_bytes, size_t& n_read, const Timer& timer) final;
+
+    // signal the wakeup eventfd
+    void WakeUp() final;
 
 private:
     SerialConfig _config;
     int _handle = -1;
+    int _wakeup_handle = -1; // eventfd of event-driven mode
+    bool _low_latency = false;
+    WakeupStats _wakeup_stats;
+
+    // wait in ppoll() for the events on the port. returns Status::RecvTimeout after the deadline, and
+    // Status::RecvInterrupted if interruptible and WakeUp() was called.
+    SerialStatus WaitForPort(short events, Timer::clock::time_point deadline, bool interruptible);
+
+    void AddWakeup(Timer::clock::time_point wakeup);
 };
 } // namespace PacketManager
 } // namespace RealSenseID
@@ -40,6 +40,7 @@ SerialStatus NonSecureSession::Start(SerialConnection* serial_conn)
         throw std::runtime_error("NonSecureSession: serial connection is null");
     }
     _serial = serial_conn;
+    serial_conn->ClearInterrupt(); // left by a cancel after the previous session's last recv
     _last_sent_seq_number = 0;
     _last_recv_seq_number = 0;
 
@@ -53,9 +54,19 @@ SerialStatus NonSecureSession::Start(SerialConnection* serial_conn)
     }
 
     status = sender.Recv(packet);
+    while (status == SerialStatus::RecvInterrupted)
+    {
+        // woken up by Cancel() - the cancel is sent with the operation's first recv, finish the handshake first
+        status = sender.Recv(packet);
+    }
     if (status != SerialStatus::Ok || packet.header.id != MsgId::StartSession)
+    {
         LOG_ERROR(LOG_TAG, "Failed to recv device start session response");
+        return status;
+    }
 
+    _is_open = true;
+    _resumption.OnStart();
     return status;
 }
 
@@ -64,6 +75,26 @@ bool NonSecureSession::IsOpen()
     return _is_open;
 }
 
+SerialStatus NonSecureSession::Resume(SerialConnection* serial_conn, const SessionPolicy& policy)
+{
+    if (!_is_open || serial_conn != _serial || !_resumption.CanResume(policy))
+    {
+        return Start(serial_conn);
+    }
+
+    LOG_DEBUG(LOG_TAG, "Resume session (operation %u)", _resumption.Operations() + 1);
+    _resumption.OnResume();
+    _cancel_required = false;
+    serial_conn->ClearInterrupt();
+    return SerialStatus::Ok;
+}
+
+void NonSecureSession::Close()
+{
+    _is_open = false;
+    _serial = nullptr;
+}
+
 SerialStatus NonSecureSession::SendPacket(SerialPacket& packet)
 {
     return SendPacketImpl(packet);
@@ -96,6 +127,8 @@ SerialStatus NonSecureSession::RecvDataPacket(DataPacket& packet)
 
 SerialStatus NonSecureSession::SendPacketImpl(SerialPacket& packet)
 {
+    _resumption.OnSend(packet);
+
     // increment and set sequence number in the packet
     packet.payload.sequence_number = ++_last_sent_seq_number;
     assert(_serial != nullptr);
@@ -110,6 +143,37 @@ static bool ValidateSeqNumber(uint32_t last_recv_number, uint32_t seq_number)
 }
 
 SerialStatus NonSecureSession::RecvPacketImpl(SerialPacket& packet)
+{
+    auto status = RecvValidPacket(packet);
+    if (_resumption.OnRecv(status))
+    {
+        LOG_WARNING(LOG_TAG, "Resumed session rejected by the device. Starting a new session");
+        return Renegotiate(packet);
+    }
+    if (status != SerialStatus::Ok)
+    {
+        _is_open = false; // next operation starts a new session
+    }
+    return status;
+}
+
+SerialStatus NonSecureSession::Renegotiate(SerialPacket& packet)
+{
+    auto status = Start(_serial.load());
+    if (status != SerialStatus::Ok)
+    {
+        return status;
+    }
+    packet = _resumption.Request();
+    status = SendPacketImpl(packet);
+    if (status != SerialStatus::Ok)
+    {
+        return status;
+    }
+    return RecvPacketImpl(packet);
+}
+
+SerialStatus NonSecureSession::RecvValidPacket(SerialPacket& packet)
 {
     assert(_serial != nullptr);
     PacketSender sender {_serial};
@@ -122,6 +186,15 @@ SerialStatus NonSecureSession::RecvPacketImpl(SerialPacket& packet)
     }
 
     status = sender.Recv(packet);
+    while (status == SerialStatus::RecvInterrupted)
+    {
+        // woken up by Cancel() - send the cancel now and keep waiting for the device's reply
+        status = HandleCancelFlag();
+        if (status == SerialStatus::Ok)
+        {
+            status = sender.Recv(packet);
+        }
+    }
     if (status != SerialStatus::Ok)
     {
         return status;
@@ -142,6 +215,12 @@ void NonSecureSession::Cancel()
 {
     LOG_DEBUG(LOG_TAG, "Cancel requested.");
     _cancel_required = true;
+    // wake up a blocked recv to send the cancel right away
+    auto* serial = _serial.load();
+    if (serial != nullptr)
+    {
+        serial->InterruptRecv();
+    }
 }
 
 SerialStatus NonSecureSession::HandleCancelFlag()
@@ -151,14 +230,15 @@ SerialStatus NonSecureSession::HandleCancelFlag()
         return SerialStatus::Ok;
     }
     _cancel_required = false;
-    if (!_serial)
+    auto* serial = _serial.load();
+    if (!serial)
     {
         LOG_WARNING(LOG_TAG, "Cannot send cancel, no serial connection");
         return SerialStatus::SendFailed;
     }
 
     LOG_DEBUG(LOG_TAG, "Sending cancel..");
-    return _serial->SendBytes(Commands::face_cancel, ::strlen(Commands::face_cancel));
+    return serial->SendBytes(Commands::face_cancel, ::strlen(Commands::face_cancel));
 }
 } // namespace PacketManager
 } // namespace RealSenseID
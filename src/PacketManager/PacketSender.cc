@@ -3,6 +3,7 @@
 
 #include "PacketSender.h"
 #include "SerialConnection.h"
+#include "FrameReader.h"
 #include "Timer.h"
 #include "Logger.h"
 #include "Crc16.h"
@@ -10,6 +11,7 @@
 #include <cstdint>
 #include <stdexcept>
 #include <cassert>
+#include <algorithm>
 
 const char* LOG_TAG = "PacketSender";
 
@@ -33,42 +35,39 @@ PacketSender::PacketSender(SerialConnection* serial_iface) : _serial {serial_ifa
 
 SerialStatus PacketSender::Send(SerialPacket& packet)
 {
-    LOG_DEBUG(LOG_TAG, "Sending packet '%c'", packet.header.id);
-
-    // send the headers + payload
-    auto* packet_ptr = reinterpret_cast<const char*>(&packet);
-    auto packet_size = sizeof(packet.header) + packet.header.payload_size;
-    auto status = _serial->SendBytes(packet_ptr, packet_size);
-    if (status != SerialStatus::Ok)
-    {
-        return status;
-    }
+    return Send(packet, nullptr);
+}
 
-    // send the hmac
-    status = _serial->SendBytes(packet.hmac, sizeof(packet.hmac));
+SerialStatus PacketSender::SendBinary(SerialPacket& packet)
+{
+    // __FACE_API__ command in the same write as the packet
+    auto status = Send(packet, Commands::face_api);
     if (status != SerialStatus::Ok)
     {
-        return status;
+        LOG_ERROR(LOG_TAG, "Failed sending face entry command and packet");
     }
-
-    // send crc
-    auto crc = CalcCrc(packet);
-    status = _serial->SendBytes(reinterpret_cast<const char*>(&crc), sizeof(crc));
     return status;
 }
 
-SerialStatus PacketSender::SendBinary(SerialPacket& packet)
+SerialStatus PacketSender::Send(SerialPacket& packet, const char* preamble)
 {
-    // send __FACE_API__ command
-    auto face_api_len = ::strlen(Commands::face_api);
-    auto status = _serial->SendBytes(Commands::face_api, face_api_len);
-    if (status != SerialStatus::Ok)
+    LOG_DEBUG(LOG_TAG, "Sending packet '%c'", packet.header.id);
+
+    // preamble, headers + payload, hmac and crc in one gather send
+    auto crc = CalcCrc(packet);
+    auto* packet_ptr = reinterpret_cast<const char*>(&packet);
+    auto packet_size = sizeof(packet.header) + packet.header.payload_size;
+
+    SendBuffer buffers[4];
+    size_t n_buffers = 0;
+    if (preamble != nullptr)
     {
-        LOG_ERROR(LOG_TAG, "Failed sending face entry command");
-        return status;
+        buffers[n_buffers++] = {preamble, ::strlen(preamble)};
     }
-
-    return Send(packet);
+    buffers[n_buffers++] = {packet_ptr, packet_size};
+    buffers[n_buffers++] = {packet.hmac, sizeof(packet.hmac)};
+    buffers[n_buffers++] = {reinterpret_cast<const char*>(&crc), sizeof(crc)};
+    return _serial->SendBuffers(buffers, n_buffers);
 }
 
 // keep trying getting the packet until timeout
@@ -77,108 +76,74 @@ SerialStatus PacketSender::Recv(SerialPacket& target)
     LOG_DEBUG(LOG_TAG, "Waiting packet..");
 
     Timer timer {recv_packet_timeout};
-    // reset the target packet with zeros
-    ::memset(reinterpret_cast<char*>(&target), 0, sizeof(target));
 
-    // wait for sync bytes up to timeout
-    auto status = WaitSyncBytes(target, &timer);
+    // wait for a complete frame up to timeout (parsed in the connection's receive buffer)
+    SerialFrame frame;
+    auto status = _serial->RecvFrame(frame, timer);
     if (status != SerialStatus::Ok)
     {
         return status;
     }
 
-    // validate protocol version
-    status = _serial->RecvBytes((char*)&target.header.protocol_ver, 1);
-    if (status != SerialStatus::Ok)
+    // validate crc before copying
+    auto expected_crc = CalcCrc(frame);
+    if (expected_crc != frame.Crc())
     {
-        LOG_ERROR(LOG_TAG, "Failed to recv protocol version byte");
-        return status;
-    }
-    if (target.header.protocol_ver != ProtocolVer)
-    {
-        LOG_ERROR(LOG_TAG, "Protocol version doesn't match. Expected: %u, Received: %u", ProtocolVer,
-                  target.header.protocol_ver);
-        return SerialStatus::VersionMismatch;
-    }
-
-    // recv rest of packet header (without the sync bytes and protocol version which we already read)
-    auto bytes_to_read = sizeof(target.header) - 3;
-    auto* target_ptr = reinterpret_cast<char*>(&target) + 3;
-    status = _serial->RecvBytes(target_ptr, bytes_to_read);
-    if (status != SerialStatus::Ok)
-    {
-        LOG_ERROR(LOG_TAG, "Failed to recv rest of packet header (%zu bytes)", bytes_to_read);
-        return status;
+        LOG_ERROR(LOG_TAG, "Got invalid crc. Expected: %u. Actual: %u", expected_crc, frame.Crc());
+        return SerialStatus::CrcError;
     }
 
-    if (target.header.payload_size > sizeof(SerialPacket::payload))
-    {
-        LOG_ERROR(LOG_TAG, "Packet size is bigger than payload max size");
-        return SerialStatus::RecvFailed;
-    }
+    frame.CopyTo(target);
 
-    // recv packet payload
-    target_ptr = reinterpret_cast<char*>(&target.payload);
-    status = _serial->RecvBytes(target_ptr, target.header.payload_size);
-    if (status != SerialStatus::Ok)
-    {
-        LOG_ERROR(LOG_TAG, "Failed to recv packet payload (%zu bytes)", target.header.payload_size);
-        return status;
-    }
+    LOG_DEBUG(LOG_TAG, "Received packet '%c' after %zu millis", target.header.id, timer.Elapsed());
+    return SerialStatus::Ok;
+}
 
-    // recv packet hmac
-    status = _serial->RecvBytes(target.hmac, sizeof(target.hmac));
-    if (status != SerialStatus::Ok)
-    {
-        LOG_ERROR(LOG_TAG, "Failed to recv packet hmac (%zu bytes)", sizeof(target.hmac));
-        return status;
-    }
+uint16_t PacketSender::CalcCrc(const SerialPacket& packet)
+{
+    static_assert(sizeof(packet.crc) == sizeof(uint16_t), "packet.crc and crc size mismatch");
 
-    // recv packet crc
-    status = _serial->RecvBytes(reinterpret_cast<char*>(&target.crc), sizeof(target.crc));
-    if (status != SerialStatus::Ok)
-    {
-        LOG_ERROR(LOG_TAG, "Failed to recv packet crc (%zu bytes)", sizeof(target.crc));
-        return status;
-    }
+    // crc of the whole packet (without the crc field), but only the transmitted bytes are iterated - an all-zero
+    // unused payload tail is folded in at once.
+    auto* packet_ptr = reinterpret_cast<const char*>(&packet);
+    const size_t payload_size = std::min<size_t>(packet.header.payload_size, sizeof(packet.payload));
+    const size_t tail_size = sizeof(packet.payload) - payload_size;
+    const char* tail = reinterpret_cast<const char*>(&packet.payload) + payload_size;
 
-    // validate crc
-    auto expected_crc = CalcCrc(target);
-    if (expected_crc != target.crc)
-    {
-        LOG_ERROR(LOG_TAG, "Got invalid crc. Expected: %u. Actual: %u", expected_crc, target.crc);
-        return SerialStatus::CrcError;
-    }
+    auto crc = Crc16(packet_ptr, sizeof(packet.header) + payload_size);
+    crc = IsZero(tail, tail_size) ? Crc16Zeros(crc, tail_size) : Crc16(crc, tail, tail_size);
+    return Crc16(crc, packet.hmac, sizeof(packet.hmac));
+}
 
-    LOG_DEBUG(LOG_TAG, "Received packet '%c' after %zu millis", target.header.id, timer.Elapsed());
-    return SerialStatus::Ok;
+uint16_t PacketSender::CalcCrc(const SerialFrame& frame)
+{
+    // the packet crc covers the unused payload bytes too (zeros on the receiving side)
+    auto crc = Crc16(frame.data, FrameReader::HeaderSize + frame.PayloadSize());
+    crc = Crc16Zeros(crc, FrameReader::MaxPayloadSize - frame.PayloadSize());
+    return Crc16(crc, frame.Hmac(), sizeof(SerialPacket::hmac));
 }
 
-// wait for sync bytes and place them into target
-SerialStatus PacketSender::WaitSyncBytes(SerialPacket& target, Timer* timer)
+bool PacketSender::IsZero(const char* buffer, size_t n_bytes)
 {
-    while (!timer->ReachedTimeout())
+    // packets are zeroed on construction, so this normally scans the whole tail
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= n_bytes; i += sizeof(uint64_t))
     {
-        auto status = _serial->RecvBytes(reinterpret_cast<char*>(&target.header.sync1), 1);
-        if (status == SerialStatus::Ok && target.header.sync1 == SyncByte::Sync1)
+        uint64_t word;
+        ::memcpy(&word, buffer + i, sizeof(word));
+        if (word != 0)
         {
-            // wait for sync2
-            status = _serial->RecvBytes(reinterpret_cast<char*>(&target.header.sync2), 1);
-            if (status == SerialStatus::Ok && target.header.sync2 == SyncByte::Sync2)
-            {
-                return SerialStatus::Ok;
-            }
+            return false;
         }
     }
-    return SerialStatus::RecvTimeout;
-}
-
-uint16_t PacketSender::CalcCrc(const SerialPacket& packet)
-{
-    auto* packet_ptr = reinterpret_cast<const char*>(&packet);
-    auto crc = Crc16(packet_ptr, sizeof(packet) - sizeof(packet.crc));
-    static_assert(sizeof(packet.crc) == sizeof(crc), "packet.crc and crc size mismatch");
-    return crc;
+    for (; i < n_bytes; i++)
+    {
+        if (buffer[i] != 0)
+        {
+            return false;
+        }
+    }
+    return true;
 }
 } // namespace PacketManager
 } // namespace RealSenseID
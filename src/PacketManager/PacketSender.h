@@ -12,7 +12,7 @@ namespace RealSenseID
 namespace PacketManager
 {
 class SerialConnection;
-class Timer;
+struct SerialFrame;
 class PacketSender
 {
 public:
@@ -33,16 +33,17 @@ public:
     // Status::RecvFailed on other failures
     SerialStatus Recv(SerialPacket& target);
 
-    // Wait for sync bytes
-    // return:
-    // Status::Ok on success,
-    // Status::RecvTimeout on timeout
-    // Status::RecvFailed on other failures
-    SerialStatus WaitSyncBytes(SerialPacket& target, Timer* timeout);
-
 private:
+    // send preamble (if not null) and packet with one gather send
+    SerialStatus Send(SerialPacket& packet, const char* preamble);
+
     static uint16_t CalcCrc(const SerialPacket& packet);
 
+    // same as CalcCrc() of the packet the frame is copied to
+    static uint16_t CalcCrc(const SerialFrame& frame);
+
+    static bool IsZero(const char* buffer, size_t n_bytes);
+
     SerialConnection* _serial;
 };
 } // namespace PacketManager
@@ -6,7 +6,7 @@
 #include "SerialConnection.h"
 #include "SerialPacket.h"
 #include "CommonTypes.h"
-#include "Timer.h"
+#include "SessionResumption.h"
 #include "MbedtlsWrapper.h"
 #include <atomic>
 
@@ -39,6 +39,17 @@ public:
     // return Status::Ok on success, or error Status otherwise.
     SerialStatus Start(SerialConnection* serial_conn);
 
+    // Start the session of the next operation: keep the open session (sequence numbers continue) while the policy
+    // allows it, otherwise start a new one.
+    // If the device rejects the resumed session (security error on the first reply), a new session is started and the
+    // operation's first request is resent. Other failures are returned as is and end the session.
+    // return Status::Ok on success, or error Status otherwise.
+    SerialStatus Resume(SerialConnection* serial_conn, const SessionPolicy& policy);
+
+    // end the session and forget its serial connection. the next Resume() starts a new one.
+    // call before the serial connection is destroyed.
+    void Close();
+
     // return true if session is open
     bool IsOpen();
 
@@ -68,11 +79,13 @@ public:
     // return Status::Ok on success, or error status otherwise.
     SerialStatus RecvDataPacket(DataPacket& packet);
 
-    // async cancel. set the _cancel_required flag and send cancel before next recv
+    // async cancel. set the _cancel_required flag and interrupt a blocked recv, which sends the cancel before receiving
+    // again (or send cancel before next recv)
     void Cancel();
 
 private:
-    SerialConnection* _serial = nullptr;
+    // cleared by Close(), read by Cancel() from other threads
+    std::atomic<SerialConnection*> _serial {nullptr};
     uint32_t _last_sent_seq_number = 0;
     uint32_t _last_recv_seq_number = 0;
     SignCallback _sign_callback;
@@ -84,7 +97,11 @@ private:
                           char* ecdsaDevicePubKey);
     SerialStatus SendPacketImpl(SerialPacket& packet);
     SerialStatus RecvPacketImpl(SerialPacket& packet);
+    SerialStatus RecvValidPacket(SerialPacket& packet);
+    SerialStatus Renegotiate(SerialPacket& packet);
     SerialStatus HandleCancelFlag(); // if _cancel_required, send cancel. otherwise do nothing
+
+    SessionResumption _resumption;
 };
 } // namespace PacketManager
 } // namespace RealSenseID
@@ -0,0 +1,147 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "SerialConnection.h"
+#include "FrameReader.h"
+#include "Timer.h"
+#include "Logger.h"
+#include <string.h>
+
+static const char* LOG_TAG = "SerialConnection";
+
+namespace RealSenseID
+{
+namespace PacketManager
+{
+SerialConnection::SerialConnection() : _reader {new FrameReader()}
+{
+}
+
+SerialConnection::~SerialConnection() = default;
+
+SerialStatus SerialConnection::SendBuffers(const SendBuffer* buffers, size_t n_buffers)
+{
+    // a whole packet with its preamble fits
+    char joined[4096];
+    size_t total = 0;
+    for (size_t i = 0; i < n_buffers; i++)
+    {
+        total += buffers[i].size;
+    }
+
+    if (total <= sizeof(joined))
+    {
+        size_t offset = 0;
+        for (size_t i = 0; i < n_buffers; i++)
+        {
+            ::memcpy(joined + offset, buffers[i].data, buffers[i].size);
+            offset += buffers[i].size;
+        }
+        return SendBytes(joined, total);
+    }
+
+    for (size_t i = 0; i < n_buffers; i++)
+    {
+        auto status = SendBytes(buffers[i].data, buffers[i].size);
+        if (status != SerialStatus::Ok)
+        {
+            return status;
+        }
+    }
+    return SerialStatus::Ok;
+}
+
+SerialStatus SerialConnection::Drain()
+{
+    return SerialStatus::Ok;
+}
+
+SerialStatus SerialConnection::RecvBytes(char* buffer, size_t n_bytes)
+{
+    if (n_bytes == 0)
+    {
+        LOG_ERROR(LOG_TAG, "Attempt to recv 0 bytes");
+        return SerialStatus::RecvFailed;
+    }
+
+    // bytes read ahead by RecvFrame() come first
+    size_t n_taken = _reader->Take(buffer, n_bytes);
+    if (n_taken == n_bytes)
+    {
+        return SerialStatus::Ok;
+    }
+    return ReadBytes(buffer + n_taken, n_bytes - n_taken);
+}
+
+SerialStatus SerialConnection::RecvFrame(SerialFrame& frame, Timer& timer)
+{
+    for (;;)
+    {
+        switch (_reader->Parse(frame))
+        {
+        case FrameReader::ParseResult::Frame:
+            return SerialStatus::Ok;
+        case FrameReader::ParseResult::VersionMismatch:
+            return SerialStatus::VersionMismatch;
+        case FrameReader::ParseResult::InvalidSize:
+            return SerialStatus::RecvFailed;
+        default:
+            break;
+        }
+
+        if (_interrupted.exchange(false))
+        {
+            // an incomplete frame stays buffered for the next receive
+            return SerialStatus::RecvInterrupted;
+        }
+
+        if (timer.ReachedTimeout())
+        {
+            _reader->DropIncompleteFrame();
+            return SerialStatus::RecvTimeout;
+        }
+
+        size_t space = 0;
+        char* buffer = _reader->GetWriteSpace(space);
+        size_t n_read = 0;
+        auto status = ReadAvailable(buffer, space, n_read, timer);
+        if (status == SerialStatus::RecvFailed)
+        {
+            return status;
+        }
+        _reader->Commit(n_read);
+    }
+}
+
+void SerialConnection::InterruptRecv()
+{
+    _interrupted = true;
+    WakeUp();
+}
+
+void SerialConnection::ClearInterrupt()
+{
+    _interrupted = false;
+}
+
+SerialStatus SerialConnection::ReadAvailable(char* buffer, size_t max_bytes, size_t& n_read, const Timer&)
+{
+    n_read = 0;
+    if (max_bytes == 0)
+    {
+        return SerialStatus::RecvFailed;
+    }
+
+    auto status = ReadBytes(buffer, 1);
+    if (status == SerialStatus::Ok)
+    {
+        n_read = 1;
+    }
+    return status;
+}
+
+void SerialConnection::WakeUp()
+{
+}
+} // namespace PacketManager
+} // namespace RealSenseID
@@ -4,24 +4,82 @@
 #pragma once
 
 #include "CommonTypes.h"
+#include <atomic>
+#include <memory>
 
 namespace RealSenseID
 {
 namespace PacketManager
 {
+class FrameReader;
+class Timer;
+struct SerialFrame;
+
+// bytes to send, part of a gather send
+struct SendBuffer
+{
+    const char* data;
+    size_t size;
+};
+
 // Represents an open serial connection (raii over the os serial connection).
 // Should open new connection on construction and close it on destruction.
 // Should throw if connection could not be established on construction.
+//
+// Received bytes go through the connection's receive buffer: RecvFrame() reads everything available and parses frames
+// in place, RecvBytes() returns buffered bytes first.
 class SerialConnection
 {
 public:
-    virtual ~SerialConnection() = default;
+    SerialConnection();
+    virtual ~SerialConnection();
 
     // send all bytes and return status
     virtual SerialStatus SendBytes(const char* buffer, size_t n_bytes) = 0;
 
+    // send all bytes of all buffers, in order, as one write where possible.
+    // the default copies small sends to one buffer for a single SendBytes().
+    virtual SerialStatus SendBuffers(const SendBuffer* buffers, size_t n_buffers);
+
+    // wait until all sent bytes were transmitted.
+    virtual SerialStatus Drain();
+
     // receive all bytes and copy to the buffer
-    virtual SerialStatus RecvBytes(char* buffer, size_t n_bytes) = 0;
+    SerialStatus RecvBytes(char* buffer, size_t n_bytes);
+
+    // receive the next complete frame (crc not checked), up to timeout.
+    // the frame is a view into the receive buffer, valid until the next receive.
+    // return:
+    // Status::Ok on success,
+    // Status::RecvTimeout on timeout
+    // Status::VersionMismatch if the frame is of another protocol version
+    // Status::RecvInterrupted if InterruptRecv() was called
+    // Status::RecvFailed on other failures
+    SerialStatus RecvFrame(SerialFrame& frame, Timer& timer);
+
+    // make the pending (or else the next) RecvFrame() return Status::RecvInterrupted. may be called from any thread.
+    // frames already received are returned first.
+    void InterruptRecv();
+
+    // forget an InterruptRecv() that did not interrupt a receive yet.
+    void ClearInterrupt();
+
+protected:
+    // receive all bytes from the os connection
+    virtual SerialStatus ReadBytes(char* buffer, size_t n_bytes) = 0;
+
+    // receive the bytes available on the os connection (at least 1, up to max_bytes), waiting up to the timer's
+    // timeout or the connection's read timeout. returns Status::RecvTimeout if nothing arrived.
+    // the default reads a single byte with ReadBytes().
+    virtual SerialStatus ReadAvailable(char* buffer, size_t max_bytes, size_t& n_read, const Timer& timer);
+
+    // make a blocked ReadAvailable() return now (called by InterruptRecv()).
+    // the default does nothing - the interrupt is seen when the read timeout expires.
+    virtual void WakeUp();
+
+private:
+    std::unique_ptr<FrameReader> _reader;
+    std::atomic<bool> _interrupted {false};
 };
 } // namespace PacketManager
 } // namespace RealSenseID
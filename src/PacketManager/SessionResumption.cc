@@ -0,0 +1,57 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "SessionResumption.h"
+
+namespace RealSenseID
+{
+namespace PacketManager
+{
+bool SessionResumption::CanResume(const SessionPolicy& policy) const
+{
+    if (!policy.resume)
+    {
+        return false;
+    }
+    if (policy.max_operations > 0 && _operations >= policy.max_operations)
+    {
+        return false;
+    }
+    return policy.max_age <= timeout_t {0} || _session_timer.Elapsed() < policy.max_age;
+}
+
+void SessionResumption::OnStart()
+{
+    _operations = 1;
+    _session_timer.Reset();
+    _resumed = false;
+    _has_request = false;
+}
+
+void SessionResumption::OnResume()
+{
+    _operations++;
+    _resumed = true;
+    _has_request = false;
+}
+
+void SessionResumption::OnSend(const SerialPacket& packet)
+{
+    if (_resumed && !_has_request)
+    {
+        _request = packet;
+        _has_request = true;
+    }
+}
+
+bool SessionResumption::OnRecv(SerialStatus status)
+{
+    if (!_resumed)
+    {
+        return false;
+    }
+    _resumed = false;
+    return status == SerialStatus::SecurityError && _has_request;
+}
+} // namespace PacketManager
+} // namespace RealSenseID
@@ -0,0 +1,55 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "CommonTypes.h"
+#include "SerialPacket.h"
+#include "Timer.h"
+
+// Session resumption state shared by the secure and non secure sessions.
+// Decides if the open session may serve the next operation, and keeps the operation's first request so it can be
+// resent in a new session if the device rejects the resumed one.
+namespace RealSenseID
+{
+namespace PacketManager
+{
+class SessionResumption
+{
+public:
+    // return true if the open session may serve the next operation under the given policy.
+    bool CanResume(const SessionPolicy& policy) const;
+
+    // a new session was started.
+    void OnStart();
+
+    // the open session serves the next operation.
+    void OnResume();
+
+    // a packet is about to be sent. the first packet after resuming is kept.
+    void OnSend(const SerialPacket& packet);
+
+    // the first reply after resuming was received with the given status.
+    // return true if the device rejected the resumed session (security error) and the kept request should be resent
+    // in a new session. timeouts are not retried: the request may have been executed.
+    bool OnRecv(SerialStatus status);
+
+    unsigned int Operations() const
+    {
+        return _operations;
+    }
+
+    const SerialPacket& Request() const
+    {
+        return _request;
+    }
+
+private:
+    unsigned int _operations = 0; // operations in the open session
+    Timer _session_timer;         // since the session started
+    bool _resumed = false;        // resumed, no reply from the device yet
+    bool _has_request = false;
+    SerialPacket _request; // first request after resuming
+};
+} // namespace PacketManager
+} // namespace RealSenseID
@@ -31,6 +31,16 @@ bool Timer::ReachedTimeout() const
     return TimeLeft() <= timeout_t {0};
 }
 
+Timer::clock::time_point Timer::Deadline() const
+{
+    const auto until_max = std::chrono::duration_cast<timeout_t>(clock::time_point::max() - _start_tp);
+    if (_timeout >= until_max)
+    {
+        return clock::time_point::max();
+    }
+    return _start_tp + std::chrono::duration_cast<clock::duration>(_timeout);
+}
+
 void Timer::Reset()
 {
     _start_tp = clock ::now();
@@ -24,6 +24,8 @@ public:
     timeout_t Elapsed() const;
     timeout_t TimeLeft() const;
     bool ReachedTimeout() const;
+    // time point of the timeout (time_point::max() if it is never reached)
+    clock::time_point Deadline() const;
     void Reset();
 
 private:
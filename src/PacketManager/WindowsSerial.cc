@@ -98,7 +98,7 @@ SerialStatus WindowsSerial::SendBytes(const char* buffer, size_t n_bytes)
     }
 }
 
-SerialStatus WindowsSerial::RecvBytes(char* buffer, size_t n_bytes)
+SerialStatus WindowsSerial::ReadBytes(char* buffer, size_t n_bytes)
 {
     DWORD bytes_to_read = static_cast<DWORD>(n_bytes);
     DWORD bytes_actual_read = 0;
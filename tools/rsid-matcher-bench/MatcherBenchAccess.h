@@ -0,0 +1,33 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "Matcher.h"
+
+namespace RealSenseID
+{
+// The benchmark's access to the matcher's private vector-level primitives (Matcher declares this class a friend).
+class MatcherBenchAccess
+{
+public:
+    static void MatchTwoVectors(const feature_t* T1, const feature_t* T2, match_calc_t* retprob,
+                                const uint32_t vec_length = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER)
+    {
+        Matcher::MatchTwoVectors(T1, T2, retprob, vec_length);
+    }
+
+    static void BlendAverageVector(feature_t* user_average_faceprints, const feature_t* user_new_faceprints,
+                                   const uint32_t vec_length = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER)
+    {
+        Matcher::BlendAverageVector(user_average_faceprints, user_new_faceprints, vec_length);
+    }
+
+    static bool UpdateAverageVector(feature_t* updated_faceprints_vec, const feature_t* orig_faceprints_vec,
+                                    const Thresholds& thresholds,
+                                    const uint32_t vec_length = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER)
+    {
+        return Matcher::UpdateAverageVector(updated_faceprints_vec, orig_faceprints_vec, thresholds, vec_length);
+    }
+};
+} // namespace RealSenseID
@@ -0,0 +1,624 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "MatcherSuite.h"
+#include "Matcher.h"
+#include "MatcherBenchAccess.h"
+#include "MatcherSimd.h"
+#include "Gallery.h"
+#include "ExtendedFaceprints.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace RealSenseID
+{
+namespace Bench
+{
+using suite_clock = std::chrono::steady_clock;
+
+// keeps benchmarked results alive, so the compiler can't drop the calls.
+static volatile int64_t s_sink = 0;
+
+// vector pairs used by the primitives benchmarks and the accuracy cross-check.
+static const std::size_t s_numberOfPairs = 4096;
+
+// minimal streaming json writer (objects, arrays, numbers, strings without escapes, bools).
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::ostream& out) : _out(out)
+    {
+    }
+
+    void BeginObject(const char* key = nullptr)
+    {
+        Key(key);
+        _out << "{";
+        _first.push_back(true);
+    }
+
+    void EndObject()
+    {
+        _first.pop_back();
+        NewLine();
+        _out << "}";
+    }
+
+    void BeginArray(const char* key)
+    {
+        Key(key);
+        _out << "[";
+        _first.push_back(true);
+    }
+
+    void EndArray()
+    {
+        _first.pop_back();
+        NewLine();
+        _out << "]";
+    }
+
+    void Value(const char* key, double value)
+    {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+        Key(key);
+        _out << buffer;
+    }
+
+    void Value(const char* key, uint64_t value)
+    {
+        Key(key);
+        _out << value;
+    }
+
+    void Value(const char* key, const char* value)
+    {
+        Key(key);
+        _out << "\"" << value << "\"";
+    }
+
+    void Value(const char* key, bool value)
+    {
+        Key(key);
+        _out << (value ? "true" : "false");
+    }
+
+    void End()
+    {
+        _out << "\n";
+    }
+
+private:
+    void NewLine()
+    {
+        _out << "\n" << std::string(2 * _first.size(), ' ');
+    }
+
+    void Key(const char* key)
+    {
+        if (!_first.empty())
+        {
+            if (!_first.back())
+            {
+                _out << ",";
+            }
+            _first.back() = false;
+            NewLine();
+        }
+        if (key != nullptr)
+        {
+            _out << "\"" << key << "\": ";
+        }
+    }
+
+    std::ostream& _out;
+    std::vector<bool> _first;
+};
+
+static double ElapsedNs(suite_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(suite_clock::now() - start).count();
+}
+
+static bool IsaSupported(MatcherSimd::Isa isa)
+{
+    const MatcherSimd::Isa best = MatcherSimd::DetectIsa();
+    switch (isa)
+    {
+    case MatcherSimd::Isa::Scalar:
+        return true;
+    case MatcherSimd::Isa::Sse41:
+        return best == MatcherSimd::Isa::Sse41 || best == MatcherSimd::Isa::Avx2;
+    case MatcherSimd::Isa::Avx2:
+    case MatcherSimd::Isa::Neon:
+        return best == isa;
+    }
+    return false;
+}
+
+// Independent reference of the accuracy cross-check: plain loops with the integer arithmetic of the original
+// MatchTwoVectors / BlendAverageVector / UpdateAverageVector, sharing no code with the matcher kernels.
+static MatcherSimd::VectorSums ReferenceSums(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    MatcherSimd::VectorSums sums;
+    for (uint32_t i = 0; i < vec_length; i++)
+    {
+        const int32_t t1 = T1[i];
+        const int32_t t2 = T2[i];
+        sums.corr += t1 * t2;
+        sums.norm1 += t1 * t1;
+        sums.norm2 += t2 * t2;
+    }
+    return sums;
+}
+
+// index of the most significant bit, starting from 1 (0 for 0).
+static int32_t ReferenceMsb(uint32_t x)
+{
+    int32_t msb = 0;
+    for (; x != 0; x >>= 1)
+    {
+        msb++;
+    }
+    return msb;
+}
+
+static match_calc_t ReferenceScore(const feature_t* T1, const feature_t* T2, uint32_t vec_length)
+{
+    const MatcherSimd::VectorSums sums = ReferenceSums(T1, T2, vec_length);
+    const uint32_t norm1 = sums.norm1 == 0 ? 1 : sums.norm1;
+    const uint32_t norm2 = sums.norm2 == 0 ? 1 : sums.norm2;
+    const uint32_t ucorr = sums.corr > 0 ? static_cast<uint32_t>(sums.corr) : 0;
+
+    const int32_t corr_msb = ReferenceMsb(ucorr);
+    const int32_t max_corr_shift = 32 - corr_msb;
+    const int32_t shift1 = std::min(16 - std::max(corr_msb - ReferenceMsb(norm1), 0), max_corr_shift);
+    const int32_t shift2 = std::min(16 - std::max(corr_msb - ReferenceMsb(norm2), 0), max_corr_shift);
+    const int32_t shift_back = shift1 + shift2 - 12;
+
+    const uint32_t similarity = ((ucorr << shift1) / norm1) * ((ucorr << shift2) / norm2);
+    const uint32_t grade = shift_back >= 0 ? (similarity >> shift_back) : (similarity << -shift_back);
+    return static_cast<match_calc_t>(grade);
+}
+
+static uint16_t ReferenceHammingDistance(const uint64_t* code1, const uint64_t* code2)
+{
+    uint16_t distance = 0;
+    for (uint32_t w = 0; w < Gallery::CodeWords; w++)
+    {
+        for (uint64_t bits = code1[w] ^ code2[w]; bits != 0; bits >>= 1)
+        {
+            distance += static_cast<uint16_t>(bits & 1);
+        }
+    }
+    return distance;
+}
+
+// avg = round((w * avg + new) / (w + 1)), w = RSID_UPDATE_GALLERY_HISTORY_WEIGHT.
+static void ReferenceBlend(feature_t* average, const feature_t* new_vec, uint32_t vec_length)
+{
+    const int32_t weight = RSID_UPDATE_GALLERY_HISTORY_WEIGHT;
+    for (uint32_t i = 0; i < vec_length; i++)
+    {
+        int32_t v = 2 * weight * average[i] + 2 * new_vec[i];
+        v = v >= 0 ? v + (weight + 1) : v - (weight + 1);
+        average[i] = static_cast<feature_t>(v / (2 * (weight + 1)));
+    }
+}
+
+// adaptive update of existing with new: blend, then pull the result back towards the enrollment vector (up to 11
+// more blends) until it scores identicalThreshold_NM against it.
+static void ReferenceAdaptiveUpdate(const Faceprints& new_faceprints, const Faceprints& existing,
+                                    const Thresholds& thresholds, feature_t* updated, uint32_t vec_length)
+{
+    std::memcpy(updated, existing.adaptiveDescriptorWithoutMask, vec_length * sizeof(feature_t));
+    ReferenceBlend(updated, new_faceprints.adaptiveDescriptorWithoutMask, vec_length);
+    for (int round = 0; round <= 10; round++)
+    {
+        if (ReferenceScore(updated, existing.enrollmentDescriptor, vec_length) >= thresholds.identicalThreshold_NM)
+        {
+            return;
+        }
+        ReferenceBlend(updated, existing.enrollmentDescriptor, vec_length);
+    }
+}
+
+struct VectorPairs
+{
+    std::vector<Faceprints> identities;
+    std::vector<Faceprints> genuine;  // genuine[i] is a probe of identities[i]
+    std::vector<Faceprints> impostor; // impostor[i] is unrelated to identities[i]
+};
+
+static VectorPairs MakePairs(SyntheticFaceprints& generator)
+{
+    VectorPairs pairs;
+    for (std::size_t i = 0; i < s_numberOfPairs; i++)
+    {
+        pairs.identities.push_back(generator.MakeIdentity());
+        pairs.genuine.push_back(generator.MakeGenuineProbe(pairs.identities.back()));
+        pairs.impostor.push_back(generator.MakeImpostorProbe());
+    }
+    return pairs;
+}
+
+// ns per call of fn(i), i = 0..count-1 (repeated until at least min_calls calls were made).
+template <typename Fn>
+static double NsPerCall(std::size_t count, std::size_t min_calls, Fn fn)
+{
+    std::size_t calls = 0;
+    double ns = 0;
+    while (calls < min_calls)
+    {
+        auto start = suite_clock::now();
+        for (std::size_t i = 0; i < count; i++)
+        {
+            fn(i);
+        }
+        ns += ElapsedNs(start);
+        calls += count;
+    }
+    return ns / calls;
+}
+
+static void RunPrimitives(const VectorPairs& pairs, const Thresholds& thresholds, JsonWriter& json)
+{
+    const std::size_t count = pairs.identities.size();
+    const uint32_t vec_length = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER;
+    const std::size_t min_calls = 200000;
+
+    json.BeginArray("primitives");
+
+    double ns = NsPerCall(count, min_calls, [&](std::size_t i) {
+        match_calc_t score = 0;
+        MatcherBenchAccess::MatchTwoVectors(pairs.identities[i].adaptiveDescriptorWithoutMask,
+                                            pairs.genuine[i].adaptiveDescriptorWithoutMask, &score, vec_length);
+        s_sink += score;
+    });
+    json.BeginObject();
+    json.Value("name", "MatchTwoVectors");
+    json.Value("ns_per_call", ns);
+    json.EndObject();
+
+    // blend/update modify their input - each timed pass works on a fresh copy of the adaptive vectors.
+    std::vector<Faceprints> work;
+    auto blend_or_update = [&](bool update) {
+        double total_ns = 0;
+        std::size_t calls = 0;
+        while (calls < min_calls / 4)
+        {
+            work = pairs.genuine;
+            auto start = suite_clock::now();
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (update)
+                {
+                    s_sink += MatcherBenchAccess::UpdateAverageVector(work[i].adaptiveDescriptorWithoutMask,
+                                                                      pairs.identities[i].enrollmentDescriptor, thresholds,
+                                                                      vec_length);
+                }
+                else
+                {
+                    MatcherBenchAccess::BlendAverageVector(work[i].adaptiveDescriptorWithoutMask,
+                                                           pairs.identities[i].adaptiveDescriptorWithoutMask, vec_length);
+                }
+            }
+            total_ns += ElapsedNs(start);
+            calls += count;
+            s_sink += work[0].adaptiveDescriptorWithoutMask[0];
+        }
+        return total_ns / calls;
+    };
+
+    json.BeginObject();
+    json.Value("name", "BlendAverageVector");
+    json.Value("ns_per_call", blend_or_update(false));
+    json.EndObject();
+
+    // genuine probe adaptive vector vs. its enrollment vector (loops while the score is below identical).
+    json.BeginObject();
+    json.Value("name", "UpdateAverageVector");
+    json.Value("ns_per_call", blend_or_update(true));
+    json.EndObject();
+
+    ns = NsPerCall(RSID_MAX_POSSIBLE_SCORE + 1, min_calls, [&](std::size_t i) {
+        ExtendedMatchResult unused;
+        s_sink += Matcher::CalculateConfidence(static_cast<match_calc_t>(i), thresholds.strongThreshold_pNMgNM,
+                                               unused);
+    });
+    json.BeginObject();
+    json.Value("name", "CalculateConfidence");
+    json.Value("ns_per_call", ns);
+    json.EndObject();
+
+    json.EndArray();
+}
+
+// score distribution of pairs, and the rate of scores above threshold.
+static void WriteScoreStats(const char* key, std::vector<match_calc_t> scores, match_calc_t threshold,
+                            JsonWriter& json)
+{
+    std::sort(scores.begin(), scores.end());
+    auto percentile = [&scores](double p) {
+        return static_cast<double>(scores[std::min(scores.size() - 1, static_cast<std::size_t>(p * scores.size()))]);
+    };
+
+    double sum = 0;
+    std::size_t accepted = 0;
+    for (match_calc_t score : scores)
+    {
+        sum += score;
+        accepted += score > threshold ? 1 : 0;
+    }
+
+    json.BeginObject(key);
+    json.Value("mean", sum / scores.size());
+    json.Value("min", static_cast<double>(scores.front()));
+    json.Value("p1", percentile(0.01));
+    json.Value("p50", percentile(0.5));
+    json.Value("p99", percentile(0.99));
+    json.Value("max", static_cast<double>(scores.back()));
+    json.Value("accept_rate", static_cast<double>(accepted) / scores.size());
+    json.EndObject();
+}
+
+static bool RunAccuracy(const VectorPairs& pairs, const Thresholds& thresholds, SyntheticFaceprints& generator,
+                        std::size_t max_users, JsonWriter& json)
+{
+    const uint32_t vec_length = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER;
+    const std::size_t count = pairs.identities.size();
+    bool passed = true;
+
+    json.BeginObject("accuracy");
+    json.Value("pairs", static_cast<uint64_t>(2 * count));
+
+    // every kernel of every supported isa vs. the reference, on genuine and impostor pairs.
+    json.BeginArray("isa");
+    const MatcherSimd::Isa isas[] = {MatcherSimd::Isa::Scalar, MatcherSimd::Isa::Sse41, MatcherSimd::Isa::Avx2,
+                                     MatcherSimd::Isa::Neon};
+    for (MatcherSimd::Isa isa : isas)
+    {
+        if (!IsaSupported(isa))
+        {
+            continue;
+        }
+
+        uint64_t mismatches = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const feature_t* gallery_vec = pairs.identities[i].adaptiveDescriptorWithoutMask;
+            const feature_t* probes[2] = {pairs.genuine[i].adaptiveDescriptorWithoutMask,
+                                          pairs.impostor[i].adaptiveDescriptorWithoutMask};
+            for (const feature_t* probe : probes)
+            {
+                auto expected = ReferenceSums(gallery_vec, probe, vec_length);
+                auto sums = MatcherSimd::ComputeSums(gallery_vec, probe, vec_length, isa);
+                if (sums.corr != expected.corr || sums.norm1 != expected.norm1 || sums.norm2 != expected.norm2)
+                {
+                    mismatches++;
+                }
+            }
+        }
+
+        json.BeginObject();
+        json.Value("name", MatcherSimd::IsaName(isa));
+        json.Value("mismatches", mismatches);
+        json.EndObject();
+        passed = passed && mismatches == 0;
+    }
+    json.EndArray();
+
+    // dispatched kernels, the score and the adaptive update vs. the reference.
+    uint64_t dispatched_mismatches = 0;
+    std::vector<match_calc_t> genuine_scores;
+    std::vector<match_calc_t> impostor_scores;
+    for (std::size_t i = 0; i + 4 <= count; i += 4)
+    {
+        const feature_t* probes[4];
+        for (std::size_t p = 0; p < 4; p++)
+        {
+            probes[p] = (p % 2 == 0 ? pairs.genuine[i + p] : pairs.impostor[i + p]).adaptiveDescriptorWithoutMask;
+        }
+
+        const feature_t* gallery_vec = pairs.identities[i].adaptiveDescriptorWithoutMask;
+        int32_t dots[4];
+        MatcherSimd::DotProduct4(gallery_vec, probes, vec_length, dots);
+        for (std::size_t p = 0; p < 4; p++)
+        {
+            const int32_t expected_dot = ReferenceSums(gallery_vec, probes[p], vec_length).corr;
+            if (dots[p] != expected_dot || MatcherSimd::DotProduct(gallery_vec, probes[p], vec_length) != expected_dot)
+            {
+                dispatched_mismatches++;
+            }
+        }
+
+        uint64_t codes[4 * Gallery::CodeWords];
+        uint16_t distances[4];
+        for (std::size_t p = 0; p < 4; p++)
+        {
+            Gallery::MakeCode(probes[p], &codes[p * Gallery::CodeWords]);
+        }
+        MatcherSimd::HammingDistances256(codes, codes, 4, distances);
+        for (std::size_t p = 0; p < 4; p++)
+        {
+            if (distances[p] != ReferenceHammingDistance(codes, &codes[p * Gallery::CodeWords]))
+            {
+                dispatched_mismatches++;
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const feature_t* gallery_vec = pairs.identities[i].adaptiveDescriptorWithoutMask;
+        const Faceprints* probes[2] = {&pairs.genuine[i], &pairs.impostor[i]};
+        for (const Faceprints* probe : probes)
+        {
+            match_calc_t score = 0;
+            MatcherBenchAccess::MatchTwoVectors(gallery_vec, probe->adaptiveDescriptorWithoutMask, &score, vec_length);
+            if (score != ReferenceScore(gallery_vec, probe->adaptiveDescriptorWithoutMask, vec_length))
+            {
+                dispatched_mismatches++;
+            }
+            (probe == &pairs.genuine[i] ? genuine_scores : impostor_scores).push_back(score);
+        }
+
+        Faceprints updated;
+        feature_t expected_updated[RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER];
+        Matcher::UpdateAdaptiveFaceprints(pairs.genuine[i], pairs.identities[i], updated, thresholds);
+        ReferenceAdaptiveUpdate(pairs.genuine[i], pairs.identities[i], thresholds, expected_updated, vec_length);
+        if (std::memcmp(updated.adaptiveDescriptorWithoutMask, expected_updated, sizeof(expected_updated)) != 0)
+        {
+            dispatched_mismatches++;
+        }
+    }
+
+    json.Value("dispatched_mismatches", dispatched_mismatches);
+    passed = passed && dispatched_mismatches == 0;
+
+    // gallery path vs. MatchFaceprintsToArray (result and adaptive update).
+    const std::size_t number_of_users = std::min<std::size_t>(max_users, 10000);
+    std::vector<ExtendedFaceprints> array(number_of_users);
+    Gallery gallery;
+    for (std::size_t u = 0; u < number_of_users; u++)
+    {
+        std::snprintf(array[u].user_id, sizeof(array[u].user_id), "user_%zu", u);
+        array[u].faceprints = generator.MakeIdentity();
+        gallery.Add(array[u].user_id, array[u].faceprints);
+    }
+
+    uint64_t search_mismatches = 0;
+    const std::size_t number_of_probes = 200;
+    for (std::size_t q = 0; q < number_of_probes; q++)
+    {
+        Faceprints probe = q % 2 == 0 ? generator.MakeGenuineProbe(array[(q * 7919) % number_of_users].faceprints)
+                                      : generator.MakeImpostorProbe();
+
+        Faceprints array_updated;
+        Faceprints gallery_updated;
+        auto expected = Matcher::MatchFaceprintsToArray(probe, array, array_updated, thresholds);
+        auto result = Matcher::MatchFaceprintsToGallery(probe, gallery, gallery_updated, thresholds);
+        if (result.isSame != expected.isSame || result.isIdentical != expected.isIdentical ||
+            result.userId != expected.userId || result.maxScore != expected.maxScore ||
+            result.confidence != expected.confidence || result.should_update != expected.should_update ||
+            (expected.should_update && std::memcmp(array_updated.adaptiveDescriptorWithoutMask,
+                                                   gallery_updated.adaptiveDescriptorWithoutMask,
+                                                   sizeof(array_updated.adaptiveDescriptorWithoutMask)) != 0))
+        {
+            search_mismatches++;
+        }
+    }
+
+    json.Value("gallery_vs_array_probes", static_cast<uint64_t>(number_of_probes));
+    json.Value("gallery_vs_array_mismatches", search_mismatches);
+    passed = passed && search_mismatches == 0;
+
+    WriteScoreStats("genuine_scores", genuine_scores, thresholds.strongThreshold_pNMgNM, json);
+    WriteScoreStats("impostor_scores", impostor_scores, thresholds.strongThreshold_pNMgNM, json);
+
+    json.Value("passed", passed);
+    json.EndObject();
+    return passed;
+}
+
+static void WriteSearchResult(const char* function, std::size_t users, std::size_t queries, double total_ns,
+                              std::size_t bytes_per_user, JsonWriter& json)
+{
+    json.BeginObject();
+    json.Value("function", function);
+    json.Value("users", static_cast<uint64_t>(users));
+    json.Value("queries", static_cast<uint64_t>(queries));
+    json.Value("ns_per_compare", total_ns / (static_cast<double>(queries) * users));
+    json.Value("queries_per_s", queries / (total_ns * 1e-9));
+    json.Value("bytes_per_query", static_cast<uint64_t>(users * bytes_per_user));
+    json.EndObject();
+}
+
+static void RunSearch(const SuiteConfig& config, const Thresholds& thresholds, SyntheticFaceprints& generator,
+                      JsonWriter& json)
+{
+    // compares per gallery size are capped, so large galleries don't dominate the run time.
+    const std::size_t max_compares = 20000000;
+    // the array path reads the adaptive vector and the version of each user.
+    const std::size_t array_bytes_per_user = RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER * sizeof(feature_t) +
+                                             sizeof(int);
+
+    std::vector<Faceprints> probes;
+    for (std::size_t q = 0; q < std::max<std::size_t>(config.queries, 3); q++)
+    {
+        probes.push_back(generator.MakeImpostorProbe());
+    }
+
+    std::vector<ExtendedFaceprints> array;
+    Gallery gallery;
+    array.reserve(config.max_users);
+    gallery.Reserve(config.max_users);
+
+    json.BeginArray("search");
+    for (std::size_t users = 100; users <= config.max_users; users *= 10)
+    {
+        while (array.size() < users)
+        {
+            ExtendedFaceprints user;
+            std::snprintf(user.user_id, sizeof(user.user_id), "user_%zu", array.size());
+            user.faceprints = generator.MakeIdentity();
+            gallery.Add(user.user_id, user.faceprints);
+            array.push_back(user);
+        }
+
+        const std::size_t queries = std::max<std::size_t>(3, std::min(probes.size(), max_compares / users));
+
+        Faceprints updated;
+        auto start = suite_clock::now();
+        for (std::size_t q = 0; q < queries; q++)
+        {
+            s_sink += Matcher::MatchFaceprintsToArray(probes[q], array, updated, thresholds).maxScore;
+        }
+        WriteSearchResult("MatchFaceprintsToArray", users, queries, ElapsedNs(start), array_bytes_per_user, json);
+
+        start = suite_clock::now();
+        for (std::size_t q = 0; q < queries; q++)
+        {
+            s_sink += Matcher::MatchFaceprintsToGallery(probes[q], gallery, updated, thresholds).maxScore;
+        }
+        WriteSearchResult("MatchFaceprintsToGallery", users, queries, ElapsedNs(start), Gallery::SearchBytesPerUser(),
+                          json);
+    }
+    json.EndArray();
+}
+
+bool RunMatcherSuite(const SuiteConfig& config, std::ostream& out)
+{
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+    SyntheticFaceprints generator(config.faceprints);
+    VectorPairs pairs = MakePairs(generator);
+
+    JsonWriter json(out);
+    json.BeginObject();
+
+    json.BeginObject("config");
+    json.Value("isa", MatcherSimd::IsaName(MatcherSimd::ActiveIsa()));
+    json.Value("max_users", static_cast<uint64_t>(config.max_users));
+    json.Value("queries", static_cast<uint64_t>(config.queries));
+    json.Value("seed", static_cast<uint64_t>(config.faceprints.seed));
+    json.Value("genuine_noise", config.faceprints.genuine_noise);
+    json.Value("population_weight", config.faceprints.population_weight);
+    json.Value("strong_threshold", static_cast<uint64_t>(thresholds.strongThreshold_pNMgNM));
+    json.EndObject();
+
+    RunPrimitives(pairs, thresholds, json);
+    bool passed = RunAccuracy(pairs, thresholds, generator, config.max_users, json);
+    RunSearch(config, thresholds, generator, json);
+
+    json.EndObject();
+    json.End();
+    return passed;
+}
+} // namespace Bench
+} // namespace RealSenseID
@@ -0,0 +1,34 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "SyntheticFaceprints.h"
+#include <cstddef>
+#include <ostream>
+
+namespace RealSenseID
+{
+namespace Bench
+{
+// Matcher benchmark suite - the numbers to look at before any matcher change reaches production.
+//
+// * primitives: ns/call of MatchTwoVectors, BlendAverageVector, UpdateAverageVector and CalculateConfidence.
+// * accuracy: every kernel/isa, the score and the adaptive update vs. a plain-loop reference of the original matcher
+//   arithmetic, the gallery path vs. MatchFaceprintsToArray, and the genuine/impostor score distributions of the
+//   synthetic data (with accept rates at the default threshold).
+// * search: MatchFaceprintsToArray and MatchFaceprintsToGallery on gallery sizes 100, 1K, ... up to max_users, with
+//   ns/compare, queries/s and bytes/query. Impostor probes are used, so every query scans the whole gallery.
+//
+// The report is written as json.
+struct SuiteConfig
+{
+    std::size_t max_users = 100000;
+    std::size_t queries = 1000; // per gallery size (fewer on large galleries)
+    SyntheticFaceprints::Config faceprints;
+};
+
+// returns false if any accuracy cross-check failed.
+bool RunMatcherSuite(const SuiteConfig& config, std::ostream& out);
+} // namespace Bench
+} // namespace RealSenseID
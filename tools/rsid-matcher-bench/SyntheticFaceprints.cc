@@ -0,0 +1,77 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#include "SyntheticFaceprints.h"
+#include <algorithm>
+#include <cmath>
+
+namespace RealSenseID
+{
+namespace Bench
+{
+// features spread, chosen so values rarely hit the [-1023, 1023] clamp.
+static const double s_featureStd = 300.0;
+
+SyntheticFaceprints::SyntheticFaceprints(const Config& config) : _config(config), _rng(config.seed)
+{
+    std::normal_distribution<double> normal(0.0, s_featureStd);
+    _populations.resize(std::max(config.number_of_populations, 1));
+    for (auto& center : _populations)
+    {
+        center.resize(NUM_OF_RECOGNITION_FEATURES);
+        for (auto& value : center)
+        {
+            value = normal(_rng);
+        }
+    }
+}
+
+feature_t SyntheticFaceprints::Clamp(double value)
+{
+    value = std::round(value);
+    value = std::min(value, 1023.0);
+    value = std::max(value, -1023.0);
+    return static_cast<feature_t>(value);
+}
+
+Faceprints SyntheticFaceprints::MakeIdentity()
+{
+    std::normal_distribution<double> normal(0.0, s_featureStd);
+    std::uniform_int_distribution<size_t> pick(0, _populations.size() - 1);
+    const auto& center = _populations[pick(_rng)];
+
+    const double w = _config.population_weight;
+    const double spread = std::sqrt(1.0 - w * w);
+
+    Faceprints faceprints;
+    std::fill(std::begin(faceprints.reserved), std::end(faceprints.reserved), 0);
+    std::fill(std::begin(faceprints.adaptiveDescriptorWithoutMask), std::end(faceprints.adaptiveDescriptorWithoutMask), 0);
+    std::fill(std::begin(faceprints.adaptiveDescriptorWithMask), std::end(faceprints.adaptiveDescriptorWithMask), 0);
+
+    for (size_t i = 0; i < NUM_OF_RECOGNITION_FEATURES; i++)
+    {
+        faceprints.adaptiveDescriptorWithoutMask[i] = Clamp(w * center[i] + spread * normal(_rng));
+    }
+    std::copy(std::begin(faceprints.adaptiveDescriptorWithoutMask), std::end(faceprints.adaptiveDescriptorWithoutMask),
+              std::begin(faceprints.enrollmentDescriptor));
+    return faceprints;
+}
+
+Faceprints SyntheticFaceprints::MakeGenuineProbe(const Faceprints& identity)
+{
+    std::normal_distribution<double> noise(0.0, s_featureStd * _config.genuine_noise);
+
+    Faceprints probe = identity;
+    for (size_t i = 0; i < NUM_OF_RECOGNITION_FEATURES; i++)
+    {
+        probe.adaptiveDescriptorWithoutMask[i] = Clamp(identity.adaptiveDescriptorWithoutMask[i] + noise(_rng));
+    }
+    return probe;
+}
+
+Faceprints SyntheticFaceprints::MakeImpostorProbe()
+{
+    return MakeIdentity();
+}
+} // namespace Bench
+} // namespace RealSenseID
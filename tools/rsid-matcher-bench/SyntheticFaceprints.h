@@ -0,0 +1,49 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+#pragma once
+
+#include "RealSenseID/Faceprints.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace RealSenseID
+{
+namespace Bench
+{
+// Generates synthetic faceprints in the valid feature range [-1023, 1023].
+//
+// Identities are drawn around a small number of "population" centers (faces are not uniformly spread), and
+// genuine probes are noisy copies of an identity. Impostor probes are fresh identities.
+class SyntheticFaceprints
+{
+public:
+    struct Config
+    {
+        uint32_t seed = 1;
+        int number_of_populations = 64; // centers identities are drawn around.
+        double population_weight = 0.5; // 0 - uniform identities, 1 - identities collapse onto their center.
+        double genuine_noise = 0.35;    // std of genuine probe noise, relative to the identity std.
+    };
+
+    explicit SyntheticFaceprints(const Config& config);
+
+    // new identity (enrollment and adaptive vectors are equal).
+    Faceprints MakeIdentity();
+
+    // noisy copy of the identity's adaptive vector.
+    Faceprints MakeGenuineProbe(const Faceprints& identity);
+
+    // probe of a new identity (not in the gallery).
+    Faceprints MakeImpostorProbe();
+
+private:
+    static feature_t Clamp(double value);
+
+    Config _config;
+    std::mt19937 _rng;
+    std::vector<std::vector<double>> _populations;
+};
+} // namespace Bench
+} // namespace RealSenseID
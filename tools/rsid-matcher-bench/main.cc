@@ -0,0 +1,1374 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+// Host matcher benchmarks on synthetic faceprints.
+// Usage: rsid-matcher-bench <benchmark> [--users N] [--queries N] [--lists N] [--seed N] [--genuine-noise X]
+//        [--population-weight X] [--json FILE]
+
+#include "SyntheticFaceprints.h"
+#include "MatcherSuite.h"
+#include "Matcher.h"
+#include "MatcherBenchAccess.h"
+#include "Gallery.h"
+#include "BoundedScanIndex.h"
+#include "DuplicateFinder.h"
+#include "ExtendedFaceprints.h"
+#include "GalleryFilter.h"
+#include "HitOrderIndex.h"
+#include "MultiDescriptorIndex.h"
+#include "NumaGallery.h"
+#include "ParallelMatcher.h"
+#include "IvfIndex.h"
+#include "PqIndex.h"
+#include "RcuGallery.h"
+#include "TwoStageMatcher.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace RealSenseID;
+
+// heap allocations of the process (every operator new below), to check allocation-free paths.
+static std::atomic<size_t> s_allocations {0};
+
+void* operator new(std::size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+struct CommandLineArgs
+{
+    bool is_valid = false;
+    std::string benchmark;
+    size_t users = 100000;
+    size_t queries = 1000;
+    size_t lists = 0; // 0 - sqrt(users)
+    uint32_t seed = 1;
+    Bench::SyntheticFaceprints::Config faceprints;
+    std::string json_path; // empty - stdout
+};
+
+static void PrintUsage(const char* exe)
+{
+    std::cout << "usage: " << exe
+              << " <benchmark> [--users N] [--queries N] [--lists N] [--seed N] [--genuine-noise X]"
+                 " [--population-weight X] [--json FILE]\n"
+              << "benchmarks:\n"
+              << "  ivf         recall and latency of the IVF index vs. exhaustive search\n"
+              << "  prefilter   recall and latency of the popcount prefilter + exact rescoring vs. exhaustive search\n"
+              << "  pq          memory, queries/s and recall of the product-quantized index vs. exhaustive search\n"
+              << "  mmap        startup time of a mapped gallery file vs. building the gallery in memory\n"
+              << "  rcu         authentication latency under adaptive-update traffic, rcu gallery vs. locked gallery\n"
+              << "  bounds      cauchy-schwarz early termination scan vs. exhaustive scan (impostor and genuine probes)\n"
+              << "  dedup       all-pairs duplicate-enrollment job: throughput, found duplicates, resume by tile\n"
+              << "  hitorder    first-above-threshold scan in hit-frequency order with a recent-user probe vs. gallery\n"
+              << "              order (80% of the traffic from 20% of the users, retries of the last user)\n"
+              << "  multidesc   mask-aware search over all descriptors of a user in one sweep vs. the search descriptor\n"
+              << "              only and vs. one pass per descriptor\n"
+              << "  filter      search restricted to a door's users (cached site AND door group AND validity window\n"
+              << "              filter) vs. the unfiltered scan\n"
+              << "  match1to1   1:1 match loop over all users: latency and heap allocations per match, array path vs.\n"
+              << "              single-pair paths\n"
+              << "  numa        exhaustive gallery scan throughput on NUMA placed copies (partitioned / replicated,\n"
+              << "              pinned node threads) with hugepage backing vs. the parallel scan of the heap gallery\n"
+              << "  suite       json report: matcher primitives, accuracy vs. plain reference, search on 100..users\n";
+}
+
+static CommandLineArgs ParseCommandLineArgs(int argc, char* argv[])
+{
+    CommandLineArgs args;
+
+    if (argc < 2)
+    {
+        PrintUsage(argv[0]);
+        return args;
+    }
+
+    args.benchmark = argv[1];
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--users") == 0 && i + 1 < argc)
+        {
+            args.users = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc)
+        {
+            args.queries = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--lists") == 0 && i + 1 < argc)
+        {
+            args.lists = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            args.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--genuine-noise") == 0 && i + 1 < argc)
+        {
+            args.faceprints.genuine_noise = std::strtod(argv[++i], nullptr);
+        }
+        else if (strcmp(argv[i], "--population-weight") == 0 && i + 1 < argc)
+        {
+            args.faceprints.population_weight = std::strtod(argv[++i], nullptr);
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            args.json_path = argv[++i];
+        }
+        else
+        {
+            std::cout << "unknown option " << argv[i] << "\n";
+            PrintUsage(argv[0]);
+            return args;
+        }
+    }
+
+    args.faceprints.seed = args.seed;
+    args.is_valid = args.users > 0 && args.queries > 0;
+    return args;
+}
+
+// synthetic gallery and genuine probes of random gallery users.
+struct Dataset
+{
+    Gallery gallery;
+    std::vector<Faceprints> probes;
+    std::vector<int> probe_owner; // gallery index the probe was made from
+};
+
+static void MakeDataset(const CommandLineArgs& args, Dataset& dataset)
+{
+    Bench::SyntheticFaceprints generator(args.faceprints);
+
+    dataset.gallery.Reserve(args.users);
+    for (size_t i = 0; i < args.users; i++)
+    {
+        std::string user_id = "user_" + std::to_string(i);
+        dataset.gallery.Add(user_id.c_str(), generator.MakeIdentity());
+    }
+
+    std::mt19937 rng(args.seed + 1);
+    std::uniform_int_distribution<size_t> pick(0, args.users - 1);
+    for (size_t q = 0; q < args.queries; q++)
+    {
+        size_t owner = pick(rng);
+        dataset.probes.push_back(generator.MakeGenuineProbe(dataset.gallery.GetFaceprints(owner)));
+        dataset.probe_owner.push_back(static_cast<int>(owner));
+    }
+}
+
+using bench_clock = std::chrono::steady_clock;
+
+static double ElapsedUs(bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+}
+
+// exhaustive top-1 of every probe. returns average latency in us.
+static double ExhaustiveTruth(const Dataset& dataset, const Thresholds& thresholds, std::vector<MatchCandidate>& truth)
+{
+    truth.clear();
+    auto start = bench_clock::now();
+    for (const auto& probe : dataset.probes)
+    {
+        truth.push_back(Matcher::MatchFaceprintsTopK(probe, dataset.gallery, 1, thresholds)[0]);
+    }
+    return ElapsedUs(start) / dataset.probes.size();
+}
+
+static int RunIvfBenchmark(const CommandLineArgs& args)
+{
+    Dataset dataset;
+    MakeDataset(args, dataset);
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+
+    std::vector<MatchCandidate> truth;
+    double exhaustive_us = ExhaustiveTruth(dataset, thresholds, truth);
+
+    size_t lists = args.lists;
+    if (lists == 0)
+    {
+        lists = 1;
+        while (lists * lists < args.users)
+        {
+            lists++;
+        }
+    }
+
+    IvfIndex index;
+    auto start = bench_clock::now();
+    index.Train(dataset.gallery, lists);
+    index.AddGallery(dataset.gallery);
+    double build_ms = ElapsedUs(start) / 1000;
+
+    std::printf("users: %zu, queries: %zu, lists: %zu, build: %.1f ms\n", args.users, args.queries, lists, build_ms);
+    std::printf("exhaustive: %.1f us/query\n\n", exhaustive_us);
+    std::printf("%8s %12s %12s %14s %10s\n", "nprobe", "us/query", "speedup", "compares/query", "recall@1");
+
+    for (size_t nprobe = 1; nprobe <= lists; nprobe *= 2)
+    {
+        size_t hits = 0;
+        size_t compares = 0;
+
+        start = bench_clock::now();
+        for (size_t q = 0; q < dataset.probes.size(); q++)
+        {
+            size_t query_compares = 0;
+            auto result = index.Search(dataset.probes[q], 1, nprobe, thresholds, query_compares);
+            compares += query_compares;
+            if (!result.empty() && result[0].userId == truth[q].userId)
+            {
+                hits++;
+            }
+        }
+        double ivf_us = ElapsedUs(start) / dataset.probes.size();
+
+        std::printf("%8zu %12.1f %12.1f %14zu %10.4f\n", nprobe, ivf_us, exhaustive_us / ivf_us,
+                    compares / dataset.probes.size(), double(hits) / dataset.probes.size());
+    }
+
+    return 0;
+}
+
+static int RunPrefilterBenchmark(const CommandLineArgs& args)
+{
+    Dataset dataset;
+    MakeDataset(args, dataset);
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+
+    std::vector<MatchCandidate> truth;
+    double exhaustive_us = ExhaustiveTruth(dataset, thresholds, truth);
+
+    std::printf("users: %zu, queries: %zu, code bytes/user: %zu\n", args.users, args.queries,
+                static_cast<size_t>(Gallery::CodeWords * sizeof(uint64_t)));
+    std::printf("exhaustive: %.1f us/query\n\n", exhaustive_us);
+    std::printf("%10s %12s %12s %16s %10s\n", "fraction", "us/query", "speedup", "rescored/query", "recall@1");
+
+    const double fractions[] = {0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1};
+    for (double fraction : fractions)
+    {
+        TwoStageMatcher::Options options;
+        options.rescore_fraction = fraction;
+
+        size_t hits = 0;
+        size_t rescored = 0;
+
+        auto start = bench_clock::now();
+        for (size_t q = 0; q < dataset.probes.size(); q++)
+        {
+            TwoStageMatcher::Stats stats;
+            auto result = TwoStageMatcher::MatchTopK(dataset.probes[q], dataset.gallery, 1, thresholds, options, &stats);
+            rescored += stats.rescored;
+            if (!result.empty() && result[0].userId == truth[q].userId)
+            {
+                hits++;
+            }
+        }
+        double prefilter_us = ElapsedUs(start) / dataset.probes.size();
+
+        std::printf("%10.3f %12.1f %12.1f %16zu %10.4f\n", fraction, prefilter_us, exhaustive_us / prefilter_us,
+                    rescored / dataset.probes.size(), double(hits) / dataset.probes.size());
+    }
+
+    return 0;
+}
+
+static int RunPqBenchmark(const CommandLineArgs& args)
+{
+    Dataset dataset;
+    MakeDataset(args, dataset);
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+
+    std::vector<MatchCandidate> truth;
+    double exhaustive_us = ExhaustiveTruth(dataset, thresholds, truth);
+
+    PqIndex index;
+    auto start = bench_clock::now();
+    if (!index.Train(dataset.gallery))
+    {
+        return 1;
+    }
+    double train_ms = ElapsedUs(start) / 1000;
+
+    // codebooks round trip, as a device/host would load them.
+    std::stringstream codebooks;
+    if (!index.SaveCodebooks(codebooks) || !index.LoadCodebooks(codebooks))
+    {
+        return 1;
+    }
+
+    start = bench_clock::now();
+    index.AddGallery(dataset.gallery);
+    double encode_ms = ElapsedUs(start) / 1000;
+
+    std::printf("users: %zu, queries: %zu, train: %.1f ms, encode: %.1f ms, codebooks: %zu bytes\n", args.users,
+                args.queries, train_ms, encode_ms, codebooks.str().size());
+    std::printf("scanned bytes/user: exhaustive %zu, pq %zu\n", Gallery::SearchBytesPerUser(),
+                PqIndex::CodeBytesPerUser());
+    std::printf("exhaustive: %.1f us/query, %.1f queries/s\n\n", exhaustive_us, 1e6 / exhaustive_us);
+    std::printf("%10s %12s %12s %12s %10s\n", "rescores", "us/query", "queries/s", "speedup", "recall@1");
+
+    const size_t rescores[] = {1, 16, 64, 256, 1024};
+    for (size_t number_of_rescores : rescores)
+    {
+        size_t hits = 0;
+
+        start = bench_clock::now();
+        for (size_t q = 0; q < dataset.probes.size(); q++)
+        {
+            auto result = index.Search(dataset.probes[q], 1, number_of_rescores, thresholds);
+            if (!result.empty() && result[0].userId == truth[q].userId)
+            {
+                hits++;
+            }
+        }
+        double pq_us = ElapsedUs(start) / dataset.probes.size();
+
+        std::printf("%10zu %12.1f %12.1f %12.1f %10.4f\n", number_of_rescores, pq_us, 1e6 / pq_us,
+                    exhaustive_us / pq_us, double(hits) / dataset.probes.size());
+    }
+
+    return 0;
+}
+
+static int RunMmapBenchmark(const CommandLineArgs& args)
+{
+    static const char* path = "rsid-matcher-bench.gallery";
+
+    Bench::SyntheticFaceprints generator(args.faceprints);
+
+    std::vector<Faceprints> users;
+    users.reserve(args.users);
+    for (size_t i = 0; i < args.users; i++)
+    {
+        users.push_back(generator.MakeIdentity());
+    }
+
+    // what a service does today: insert every user it got (from the device or its own db) on every start.
+    Gallery gallery;
+    auto start = bench_clock::now();
+    gallery.Reserve(args.users);
+    for (size_t i = 0; i < args.users; i++)
+    {
+        std::string user_id = "user_" + std::to_string(i);
+        gallery.Add(user_id.c_str(), users[i]);
+    }
+    double build_ms = ElapsedUs(start) / 1000;
+
+    start = bench_clock::now();
+    if (!gallery.Save(path))
+    {
+        return 1;
+    }
+    double save_ms = ElapsedUs(start) / 1000;
+
+    Gallery mapped;
+    start = bench_clock::now();
+    if (!mapped.Map(path))
+    {
+        return 1;
+    }
+    double map_ms = ElapsedUs(start) / 1000;
+
+    Gallery verified;
+    start = bench_clock::now();
+    if (!verified.Map(path, true))
+    {
+        return 1;
+    }
+    double verified_map_ms = ElapsedUs(start) / 1000;
+
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+    std::mt19937 rng(args.seed + 1);
+    std::uniform_int_distribution<size_t> pick(0, args.users - 1);
+    std::vector<Faceprints> probes;
+    for (size_t q = 0; q < args.queries; q++)
+    {
+        probes.push_back(generator.MakeGenuineProbe(users[pick(rng)]));
+    }
+
+    // first query on the mapped gallery pays for the page faults (or disk reads on a cold page cache).
+    start = bench_clock::now();
+    auto first = Matcher::MatchFaceprintsTopK(probes[0], mapped, 1, thresholds);
+    double first_query_us = ElapsedUs(start);
+
+    size_t mismatches = 0;
+    double memory_us = 0;
+    double mapped_us = 0;
+    for (const auto& probe : probes)
+    {
+        start = bench_clock::now();
+        auto expected = Matcher::MatchFaceprintsTopK(probe, gallery, 1, thresholds);
+        memory_us += ElapsedUs(start);
+
+        start = bench_clock::now();
+        auto result = Matcher::MatchFaceprintsTopK(probe, mapped, 1, thresholds);
+        mapped_us += ElapsedUs(start);
+
+        if (result.empty() || expected.empty() || result[0].userId != expected[0].userId ||
+            result[0].score != expected[0].score)
+        {
+            mismatches++;
+        }
+    }
+
+    std::remove(path);
+
+    std::printf("users: %zu, queries: %zu\n\n", args.users, args.queries);
+    std::printf("build in memory:        %10.1f ms\n", build_ms);
+    std::printf("save:                   %10.1f ms\n", save_ms);
+    std::printf("map:                    %10.3f ms\n", map_ms);
+    std::printf("map + verify checksum:  %10.1f ms\n", verified_map_ms);
+    std::printf("first mapped query:     %10.1f us\n", first_query_us);
+    std::printf("query (memory/mapped):  %10.1f / %.1f us\n", memory_us / probes.size(), mapped_us / probes.size());
+    std::printf("mismatches:             %10zu\n", mismatches + (first.empty() ? 1 : 0));
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+// authentication latencies (us) of reader threads, while a writer thread publishes an update every update_period.
+// search(probe) and update(user, faceprints) are called concurrently.
+template <typename Search, typename Update>
+static std::vector<double> AuthLatencies(const Dataset& dataset, size_t readers, bool with_updates,
+                                         std::chrono::microseconds update_period, Search search, Update update)
+{
+    std::atomic<bool> done(false);
+    std::atomic<size_t> next_query(0);
+    std::mutex latencies_mutex;
+    std::vector<double> latencies;
+
+    std::thread writer([&]() {
+        if (!with_updates)
+        {
+            return;
+        }
+        Bench::SyntheticFaceprints generator(Bench::SyntheticFaceprints::Config{});
+        for (size_t i = 0; !done; i++)
+        {
+            size_t user = (i * 7919) % dataset.gallery.Size();
+            update(user, generator.MakeGenuineProbe(dataset.gallery.GetFaceprints(user)));
+            std::this_thread::sleep_for(update_period);
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < readers; t++)
+    {
+        threads.emplace_back([&]() {
+            std::vector<double> local;
+            for (size_t q = next_query++; q < dataset.probes.size(); q = next_query++)
+            {
+                auto start = bench_clock::now();
+                search(dataset.probes[q]);
+                local.push_back(ElapsedUs(start));
+            }
+            std::lock_guard<std::mutex> lock(latencies_mutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    done = true;
+    writer.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+static void PrintLatencies(const char* name, const std::vector<double>& latencies)
+{
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+    std::printf("%-26s %10.1f %10.1f %10.1f\n", name, percentile(0.5), percentile(0.99), latencies.back());
+}
+
+static int RunRcuBenchmark(const CommandLineArgs& args)
+{
+    Dataset dataset;
+    MakeDataset(args, dataset);
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+    // leave a core to the writer, so latencies measure the gallery and not the os scheduler.
+    const size_t readers = std::max<size_t>(1, std::thread::hardware_concurrency() / 2);
+    const std::chrono::microseconds update_period(1000);
+
+    RcuGallery rcu_gallery;
+    if (!rcu_gallery.Assign(dataset.gallery))
+    {
+        return 1;
+    }
+
+    auto rcu_search = [&](const Faceprints& probe) {
+        std::string user_id;
+        rcu_gallery.MatchAndUpdate(probe, thresholds, user_id);
+    };
+    auto rcu_update = [&](size_t user, const Faceprints& faceprints) {
+        rcu_gallery.Update(dataset.gallery.UserId(user), faceprints);
+    };
+
+    // what callers do without rcu: one lock around the scan and the write back of the adaptive update.
+    Gallery locked_gallery = dataset.gallery;
+    std::mutex gallery_mutex;
+    auto locked_search = [&](const Faceprints& probe) {
+        std::lock_guard<std::mutex> lock(gallery_mutex);
+        Faceprints updated_faceprints;
+        auto result = Matcher::MatchFaceprintsToGallery(probe, locked_gallery, updated_faceprints, thresholds);
+        if (result.should_update)
+        {
+            locked_gallery.Update(static_cast<size_t>(result.userId), updated_faceprints);
+        }
+    };
+    auto locked_update = [&](size_t user, const Faceprints& faceprints) {
+        std::lock_guard<std::mutex> lock(gallery_mutex);
+        locked_gallery.Update(user, faceprints);
+    };
+
+    std::printf("users: %zu, queries: %zu, readers: %zu, update every %lld us, hardware threads: %u\n\n",
+                args.users, args.queries, readers, static_cast<long long>(update_period.count()),
+                std::thread::hardware_concurrency());
+    std::printf("%-26s %10s %10s %10s\n", "auth latency (us)", "p50", "p99", "max");
+    PrintLatencies("rcu, no updates", AuthLatencies(dataset, readers, false, update_period, rcu_search, rcu_update));
+    PrintLatencies("rcu, with updates", AuthLatencies(dataset, readers, true, update_period, rcu_search, rcu_update));
+    PrintLatencies("locked, no updates",
+                   AuthLatencies(dataset, readers, false, update_period, locked_search, locked_update));
+    PrintLatencies("locked, with updates",
+                   AuthLatencies(dataset, readers, true, update_period, locked_search, locked_update));
+
+    return 0;
+}
+
+static int RunBoundsBenchmark(const CommandLineArgs& args)
+{
+    Dataset dataset;
+    MakeDataset(args, dataset);
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+
+    auto start = bench_clock::now();
+    BoundedScanIndex index;
+    index.Build(dataset.gallery);
+    double build_ms = ElapsedUs(start) / 1000;
+
+    // impostors scan the whole gallery (the case early termination is for), genuine probes stop at their owner.
+    // (a different seed, so impostors are not the gallery identities.)
+    Bench::SyntheticFaceprints::Config impostor_config = args.faceprints;
+    impostor_config.seed = args.seed + 1000;
+    Bench::SyntheticFaceprints generator(impostor_config);
+    std::vector<Faceprints> impostors;
+    for (size_t q = 0; q < args.queries; q++)
+    {
+        impostors.push_back(generator.MakeImpostorProbe());
+    }
+
+    std::printf("users: %zu, queries: %zu, index build: %.1f ms\n\n", args.users, args.queries, build_ms);
+    std::printf("%-10s %12s %12s %12s %12s\n", "probes", "exact us", "bounded us", "blocks", "abandoned");
+
+    size_t mismatches = 0;
+    const std::vector<Faceprints>* probe_sets[2] = {&impostors, &dataset.probes};
+    const char* names[2] = {"impostor", "genuine"};
+    for (int set = 0; set < 2; set++)
+    {
+        double exact_us = 0;
+        double bounded_us = 0;
+        uint64_t blocks = 0;
+        size_t scanned = 0;
+        size_t abandoned = 0;
+        for (const auto& probe : *probe_sets[set])
+        {
+            Faceprints expected_updated;
+            Faceprints updated;
+            start = bench_clock::now();
+            auto expected = Matcher::MatchFaceprintsToGallery(probe, dataset.gallery, expected_updated, thresholds);
+            exact_us += ElapsedUs(start);
+
+            BoundedScanIndex::Stats stats;
+            start = bench_clock::now();
+            auto result = index.Match(probe, dataset.gallery, updated, thresholds,
+                                      MatchSearchMode::FirstAboveThreshold, &stats);
+            bounded_us += ElapsedUs(start);
+
+            blocks += stats.blocks;
+            scanned += stats.scanned;
+            abandoned += stats.abandoned;
+            if (result.userId != expected.userId || result.maxScore != expected.maxScore ||
+                result.isSame != expected.isSame || result.confidence != expected.confidence)
+            {
+                mismatches++;
+            }
+        }
+
+        const size_t count = probe_sets[set]->size();
+        std::printf("%-10s %12.1f %12.1f %11.1f%% %11.1f%%\n", names[set], exact_us / count, bounded_us / count,
+                    100.0 * blocks / (std::max<size_t>(scanned, 1) * BoundedScanIndex::NumberOfBlocks),
+                    100.0 * abandoned / std::max<size_t>(scanned, 1));
+    }
+
+    std::printf("\nmismatches: %zu\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+static int RunDedupBenchmark(const CommandLineArgs& args)
+{
+    Bench::SyntheticFaceprints generator(args.faceprints);
+
+    // 1% of the users were enrolled twice (a second enrollment is a genuine probe of the first).
+    const size_t duplicates = std::max<size_t>(1, args.users / 100);
+    std::vector<Faceprints> users;
+    users.reserve(args.users);
+    for (size_t i = 0; i < args.users - std::min(duplicates, args.users - 1); i++)
+    {
+        users.push_back(generator.MakeIdentity());
+    }
+    std::mt19937 rng(args.seed + 1);
+    std::uniform_int_distribution<size_t> pick(0, users.size() - 1);
+    while (users.size() < args.users)
+    {
+        Faceprints again = generator.MakeGenuineProbe(users[pick(rng)]);
+        std::memcpy(again.enrollmentDescriptor, again.adaptiveDescriptorWithoutMask,
+                    sizeof(again.enrollmentDescriptor));
+        users.push_back(again);
+    }
+    std::shuffle(users.begin(), users.end(), rng);
+
+    Gallery gallery;
+    gallery.Reserve(users.size());
+    for (size_t i = 0; i < users.size(); i++)
+    {
+        std::string user_id = "user_" + std::to_string(i);
+        gallery.Add(user_id.c_str(), users[i]);
+    }
+
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+    const match_calc_t threshold = thresholds.identicalThreshold_NM;
+    DuplicateFinder finder;
+    const size_t number_of_tiles = finder.NumberOfTiles(gallery.Size());
+
+    auto start = bench_clock::now();
+    std::vector<SimilarPair> pairs = finder.FindSimilarPairs(gallery, threshold);
+    double job_s = ElapsedUs(start) / 1e6;
+
+    // stop half way (as if the job was interrupted), then resume from the returned tile.
+    std::vector<SimilarPair> resumed;
+    auto collect = [&resumed](size_t, const std::vector<SimilarPair>& tile_pairs) {
+        resumed.insert(resumed.end(), tile_pairs.begin(), tile_pairs.end());
+        return true;
+    };
+    size_t next_tile = finder.FindSimilarPairs(gallery, threshold, [&](size_t tile, const std::vector<SimilarPair>& p) {
+        collect(tile, p);
+        return tile + 1 < number_of_tiles / 2;
+    });
+    size_t end_tile = finder.FindSimilarPairs(gallery, threshold, collect, next_tile);
+
+    size_t mismatches = (end_tile == number_of_tiles && resumed.size() == pairs.size()) ? 0 : 1;
+
+    // exact scores: every reported pair vs. MatchTwoVectors(). small galleries are also checked pair by pair.
+    for (const auto& pair : pairs)
+    {
+        match_calc_t score = 0;
+        MatcherBenchAccess::MatchTwoVectors(gallery.Descriptor(pair.first), gallery.Descriptor(pair.second), &score);
+        mismatches += (score != pair.score) ? 1 : 0;
+    }
+    if (gallery.Size() <= 5000)
+    {
+        size_t expected_pairs = 0;
+        for (size_t i = 0; i < gallery.Size(); i++)
+        {
+            for (size_t j = i + 1; j < gallery.Size(); j++)
+            {
+                match_calc_t score = 0;
+                MatcherBenchAccess::MatchTwoVectors(gallery.Descriptor(i), gallery.Descriptor(j), &score);
+                expected_pairs += (score > threshold) ? 1 : 0;
+            }
+        }
+        mismatches += (expected_pairs != pairs.size()) ? 1 : 0;
+    }
+
+    const double number_of_pairs = 0.5 * gallery.Size() * (gallery.Size() - 1.0);
+    std::printf("users: %zu, enrolled twice: %zu, threads: %zu, tiles: %zu\n\n", gallery.Size(), duplicates,
+                finder.NumThreads(), number_of_tiles);
+    std::printf("job:                    %10.2f s\n", job_s);
+    std::printf("pairs scored:           %10.3g (%.1f ns/pair)\n", number_of_pairs, job_s * 1e9 / number_of_pairs);
+    std::printf("pairs above %-4d:       %10zu\n", threshold, pairs.size());
+    std::printf("resumed at tile:        %10zu\n", next_tile);
+    std::printf("mismatches:             %10zu\n", mismatches);
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+static int RunHitOrderBenchmark(const CommandLineArgs& args)
+{
+    Dataset dataset;
+    MakeDataset(args, dataset);
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+    const size_t users = dataset.gallery.Size();
+
+    // authentication traffic: 80% of the queries come from a random 20% of the users, and 30% of the queries are a
+    // retry of the previous user.
+    std::mt19937 rng(args.seed + 2);
+    std::vector<size_t> frequent(users);
+    std::iota(frequent.begin(), frequent.end(), 0);
+    std::shuffle(frequent.begin(), frequent.end(), rng);
+    frequent.resize(std::max<size_t>(users / 5, 1));
+
+    Bench::SyntheticFaceprints generator(args.faceprints);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<size_t> pick_frequent(0, frequent.size() - 1);
+    std::uniform_int_distribution<size_t> pick_any(0, users - 1);
+    std::vector<Faceprints> probes;
+    size_t owner = pick_any(rng);
+    for (size_t q = 0; q < args.queries; q++)
+    {
+        double dice = uniform(rng);
+        if (q == 0 || dice >= 0.3)
+        {
+            owner = (uniform(rng) < 0.8) ? frequent[pick_frequent(rng)] : pick_any(rng);
+        }
+        probes.push_back(generator.MakeGenuineProbe(dataset.gallery.GetFaceprints(owner)));
+    }
+
+    HitOrderIndex index;
+    index.Build(dataset.gallery);
+
+    double plain_us = 0;
+    double ordered_us = 0;
+    uint64_t plain_comparisons = 0;
+    size_t other_matches = 0; // another user above threshold was scanned first
+    size_t mismatches = 0;
+    for (const auto& probe : probes)
+    {
+        Faceprints expected_updated;
+        Faceprints updated;
+        auto start = bench_clock::now();
+        auto expected = Matcher::MatchFaceprintsToGallery(probe, dataset.gallery, expected_updated, thresholds);
+        plain_us += ElapsedUs(start);
+        plain_comparisons += expected.isSame ? static_cast<uint64_t>(expected.userId) + 1 : users;
+
+        start = bench_clock::now();
+        auto result = index.Match(probe, dataset.gallery, updated, thresholds);
+        ordered_us += ElapsedUs(start);
+
+        if (result.isSame != expected.isSame ||
+            (result.userId == expected.userId && result.maxScore != expected.maxScore))
+        {
+            mismatches++;
+        }
+        else if (result.userId != expected.userId)
+        {
+            // both scans stopped above threshold, on different users - the score must still be that user's score.
+            match_calc_t score = 0;
+            MatcherBenchAccess::MatchTwoVectors(&probe.adaptiveDescriptorWithoutMask[0],
+                                                dataset.gallery.Descriptor(static_cast<size_t>(result.userId)), &score);
+            other_matches++;
+            mismatches += (score != result.maxScore) ? 1 : 0;
+        }
+    }
+
+    const auto& stats = index.GetStats();
+    const size_t queries = probes.size();
+    std::printf("users: %zu, queries: %zu, matched: %.1f%%\n\n", users, queries, 100.0 * stats.matches / queries);
+    std::printf("%-14s %12s %16s\n", "scan", "us/query", "compares/query");
+    std::printf("%-14s %12.1f %16.1f\n", "gallery order", plain_us / queries,
+                static_cast<double>(plain_comparisons) / queries);
+    std::printf("%-14s %12.1f %16.1f\n", "hit order", ordered_us / queries, stats.AverageComparisons());
+    std::printf("\nrecent probe hits: %.1f%% of matches, reorders: %llu\n",
+                100.0 * stats.recent_hits / std::max<uint64_t>(stats.matches, 1),
+                static_cast<unsigned long long>(stats.reorders));
+    std::printf("queries matched to another user above threshold than in gallery order: %zu\n", other_matches);
+    std::printf("mismatches: %zu\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+static int RunMultiDescriptorBenchmark(const CommandLineArgs& args)
+{
+    Bench::SyntheticFaceprints generator(args.faceprints);
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+
+    // a mask moves the face far from its no-mask descriptors (ncc ~0.4): masked faceprints are a blend of the identity
+    // with an unrelated face. every other user has an adaptive with-mask vector (a masked authentication was seen).
+    auto masked = [&generator](const Faceprints& identity) {
+        Faceprints other = generator.MakeIdentity();
+        Faceprints result = identity;
+        for (size_t i = 0; i < NUM_OF_RECOGNITION_FEATURES; i++)
+        {
+            double value = 0.4 * identity.adaptiveDescriptorWithoutMask[i] + 0.9 * other.adaptiveDescriptorWithoutMask[i];
+            result.adaptiveDescriptorWithoutMask[i] = static_cast<feature_t>(std::max(-1023.0, std::min(1023.0, value)));
+        }
+        return result;
+    };
+
+    Gallery gallery;
+    std::vector<Faceprints> masked_identities;
+    gallery.Reserve(args.users);
+    for (size_t i = 0; i < args.users; i++)
+    {
+        Faceprints identity = generator.MakeIdentity();
+        masked_identities.push_back(masked(identity));
+        if (i % 2 == 0)
+        {
+            std::copy(std::begin(masked_identities.back().adaptiveDescriptorWithoutMask),
+                      std::begin(masked_identities.back().adaptiveDescriptorWithoutMask) + NUM_OF_RECOGNITION_FEATURES,
+                      std::begin(identity.adaptiveDescriptorWithMask));
+        }
+        std::string user_id = "user_" + std::to_string(i);
+        gallery.Add(user_id.c_str(), identity);
+    }
+
+    // half of the probes wear a mask.
+    std::mt19937 rng(args.seed + 1);
+    std::uniform_int_distribution<size_t> pick(0, args.users - 1);
+    std::vector<Faceprints> probes;
+    std::vector<size_t> owners;
+    for (size_t q = 0; q < args.queries; q++)
+    {
+        size_t owner = pick(rng);
+        const bool with_mask = (q % 2 == 1);
+        Faceprints probe = generator.MakeGenuineProbe(with_mask ? masked_identities[owner] : gallery.GetFaceprints(owner));
+        probe.adaptiveDescriptorWithoutMask[RSID_INDEX_IN_FEATURS_VECTOR_HAS_MASK] = with_mask ? 1 : 0;
+        probes.push_back(probe);
+        owners.push_back(owner);
+    }
+
+    MultiDescriptorIndex index;
+    index.Build(gallery);
+
+    // exhaustive scans, so every path scores the whole gallery.
+    double single_us = 0;
+    double separate_us = 0;
+    double fused_us = 0;
+    size_t single_accepted[2] = {0, 0};
+    size_t fused_accepted[2] = {0, 0};
+    size_t mismatches = 0;
+    for (size_t q = 0; q < probes.size(); q++)
+    {
+        const Faceprints& probe = probes[q];
+        const bool with_mask = MultiDescriptorIndex::HasMask(probe);
+        const feature_t* query = &probe.adaptiveDescriptorWithoutMask[0];
+
+        auto start = bench_clock::now();
+        auto single = Matcher::MatchFaceprintsTopK(probe, gallery, 1, thresholds)[0];
+        single_us += ElapsedUs(start);
+
+        // one gallery pass per descriptor, same decision rule as the index.
+        start = bench_clock::now();
+        DescriptorMatch separate;
+        int best_margin = std::numeric_limits<int>::min();
+        const int descriptor_order[3] = {0, 2, 1}; // no-mask probes skip the with-mask descriptor (the last one)
+        for (int d = 0; d < (with_mask ? 3 : 2); d++)
+        {
+            const int descriptor = descriptor_order[d];
+            match_calc_t threshold = (descriptor == 1) ? thresholds.strongThreshold_pMgM
+                                     : with_mask       ? thresholds.strongThreshold_pMgNM
+                                                       : thresholds.strongThreshold_pNMgNM;
+            for (size_t i = 0; i < gallery.Size(); i++)
+            {
+                const Faceprints& faceprints = gallery.GetFaceprints(i);
+                const feature_t* descriptors[3] = {faceprints.adaptiveDescriptorWithoutMask,
+                                                   faceprints.adaptiveDescriptorWithMask,
+                                                   faceprints.enrollmentDescriptor};
+                match_calc_t score = 0;
+                MatcherBenchAccess::MatchTwoVectors(query, descriptors[descriptor], &score);
+                int margin = score - threshold;
+                // ties go to the lower user index, as in the single sweep.
+                if (score > 0 && (margin > best_margin || (margin == best_margin && static_cast<int>(i) < separate.id)))
+                {
+                    best_margin = margin;
+                    separate.id = static_cast<int>(i);
+                    separate.score = score;
+                    separate.threshold = threshold;
+                }
+            }
+        }
+        separate_us += ElapsedUs(start);
+
+        start = bench_clock::now();
+        DescriptorMatch fused = index.Search(gallery, query, with_mask, thresholds, MatchSearchMode::Exhaustive);
+        fused_us += ElapsedUs(start);
+
+        if (fused.id != separate.id || fused.score != separate.score)
+        {
+            mismatches++;
+        }
+
+        const int owner = static_cast<int>(owners[q]);
+        single_accepted[with_mask] += (single.userId == owner && single.score > thresholds.strongThreshold_pNMgNM);
+        fused_accepted[with_mask] += (fused.id == owner && fused.score > fused.threshold);
+    }
+
+    const size_t queries = probes.size();
+    const double compares = static_cast<double>(gallery.Size());
+    std::printf("users: %zu, queries: %zu (half with mask)\n\n", gallery.Size(), queries);
+    std::printf("%-26s %12s %14s %16s %16s\n", "search", "us/query", "ns/user", "no-mask accepted",
+                "mask accepted");
+    auto print = [&](const char* name, double us, const size_t* accepted) {
+        std::printf("%-26s %12.1f %14.1f", name, us / queries, 1000.0 * us / queries / compares);
+        if (accepted != nullptr)
+        {
+            std::printf(" %15.1f%% %15.1f%%", 200.0 * accepted[0] / queries, 200.0 * accepted[1] / queries);
+        }
+        std::printf("\n");
+    };
+    print("search descriptor only", single_us, single_accepted);
+    print("one pass per descriptor", separate_us, nullptr);
+    print("all descriptors, one sweep", fused_us, fused_accepted);
+    std::printf("\nmismatches (one sweep vs. one pass per descriptor): %zu\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+static int RunFilterBenchmark(const CommandLineArgs& args)
+{
+    Dataset dataset;
+    MakeDataset(args, dataset);
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+    const size_t users = dataset.gallery.Size();
+
+    // the door admits its group (~300 users, or 1/4 of small galleries) on one site, within their validity window.
+    std::mt19937 rng(args.seed + 3);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double group_fraction = std::min(0.25, 2 * 300.0 / users);
+    GalleryFilter site(users), group(users), window(users);
+    for (size_t i = 0; i < users; i++)
+    {
+        site.Set(i, i % 2 == 0);
+        group.Set(i, uniform(rng) < group_fraction);
+        window.Set(i, uniform(rng) < 0.95);
+    }
+
+    GalleryFilterCache cache;
+    cache.Set("site:1", site);
+    cache.Set("group:lab", group);
+    cache.Set("window:day", window);
+
+    auto start = bench_clock::now();
+    auto door = cache.And({"site:1", "group:lab", "window:day"});
+    const double compose_us = ElapsedUs(start);
+    start = bench_clock::now();
+    auto cached_door = cache.And({"window:day", "site:1", "group:lab"});
+    const double cached_us = ElapsedUs(start);
+
+    // probes of admitted users, and of users the door doesn't admit (which must not match).
+    std::vector<size_t> admitted;
+    door->ForEach(users, [&admitted](size_t index) {
+        admitted.push_back(index);
+        return true;
+    });
+    if (admitted.empty())
+    {
+        std::cout << "no admitted users - use more users\n";
+        return 1;
+    }
+
+    Bench::SyntheticFaceprints generator(args.faceprints);
+    std::uniform_int_distribution<size_t> pick_admitted(0, admitted.size() - 1);
+    std::uniform_int_distribution<size_t> pick_any(0, users - 1);
+    std::vector<Faceprints> probes;
+    std::vector<size_t> owners;
+    for (size_t q = 0; q < args.queries; q++)
+    {
+        size_t owner = (q % 2 == 0) ? admitted[pick_admitted(rng)] : pick_any(rng);
+        probes.push_back(generator.MakeGenuineProbe(dataset.gallery.GetFaceprints(owner)));
+        owners.push_back(owner);
+    }
+
+    double full_us = 0;
+    double filtered_us = 0;
+    size_t mismatches = 0;
+    for (size_t q = 0; q < probes.size(); q++)
+    {
+        const Faceprints& probe = probes[q];
+        Faceprints updated;
+
+        start = bench_clock::now();
+        auto full = Matcher::MatchFaceprintsToGallery(probe, dataset.gallery, updated, thresholds);
+        full_us += ElapsedUs(start);
+
+        start = bench_clock::now();
+        auto filtered = Matcher::MatchFaceprintsToGallery(probe, dataset.gallery, *cached_door, updated, thresholds);
+        filtered_us += ElapsedUs(start);
+
+        // reference: first admitted user above threshold, else the best admitted user.
+        TagResult expected;
+        expected.score = 0;
+        for (size_t index : admitted)
+        {
+            match_calc_t score = 0;
+            MatcherBenchAccess::MatchTwoVectors(&probe.adaptiveDescriptorWithoutMask[0],
+                                                dataset.gallery.Descriptor(index), &score);
+            if (score > expected.score)
+            {
+                expected.score = score;
+                expected.id = static_cast<int>(index);
+            }
+            if (score > thresholds.strongThreshold_pNMgNM)
+            {
+                break;
+            }
+        }
+
+        const bool owner_admitted = door->Test(owners[q]);
+        if (filtered.userId != expected.id || filtered.maxScore != expected.score ||
+            (filtered.isSame && !door->Test(static_cast<size_t>(filtered.userId))) ||
+            (owner_admitted && (!full.isSame || full.userId != static_cast<int>(owners[q]))))
+        {
+            mismatches++;
+        }
+    }
+
+    const size_t queries = probes.size();
+    std::printf("users: %zu, admitted by the door: %zu, queries: %zu (half by admitted users)\n", users,
+                door->Count(), queries);
+    std::printf("door filter: composed in %.1f us, cached lookup %.1f us\n\n", compose_us, cached_us);
+    std::printf("%-12s %12s\n", "search", "us/query");
+    std::printf("%-12s %12.1f\n", "unfiltered", full_us / queries);
+    std::printf("%-12s %12.1f\n", "door filter", filtered_us / queries);
+    std::printf("\nmismatches: %zu\n", mismatches);
+    return (mismatches == 0 && door == cached_door) ? 0 : 1;
+}
+
+static int RunMatch1to1Benchmark(const CommandLineArgs& args)
+{
+    Dataset dataset;
+    MakeDataset(args, dataset);
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+    const size_t users = dataset.gallery.Size();
+
+    // a host-side database loop: one 1:1 match per user, every user against a probe (genuine for its owner).
+    struct Outcome
+    {
+        MatchResultInternal result;
+        Faceprints updated;
+    };
+    std::vector<Outcome> expected(users);
+    std::vector<Outcome> outcomes(users);
+
+    auto probe_of = [&dataset](size_t user) -> const Faceprints& {
+        return dataset.probes[user % dataset.probes.size()];
+    };
+
+    // the former MatchFaceprints(): the existing faceprints are copied into a single element array.
+    auto array_match = [&thresholds](const Faceprints& probe, const Faceprints& existing, Faceprints& updated) {
+        std::vector<ExtendedFaceprints> array(1);
+        array[0].faceprints = existing;
+        auto result = Matcher::MatchFaceprintsToArray(probe, array, updated, thresholds);
+        MatchResultInternal match_result;
+        match_result.score = result.maxScore;
+        match_result.confidence = result.confidence;
+        match_result.success = result.isSame;
+        match_result.should_update = result.should_update;
+        return match_result;
+    };
+
+    auto pair_match = [&thresholds](const Faceprints& probe, const Faceprints& existing, Faceprints& updated) {
+        return Matcher::MatchFaceprints(probe, existing, updated, thresholds);
+    };
+
+    auto descriptor_match = [&thresholds](const Faceprints& probe, const Faceprints& existing, Faceprints& updated) {
+        return Matcher::MatchDescriptors(&probe.adaptiveDescriptorWithoutMask[0],
+                                         &existing.adaptiveDescriptorWithoutMask[0],
+                                         &existing.enrollmentDescriptor[0], &updated.adaptiveDescriptorWithoutMask[0],
+                                         thresholds);
+    };
+
+    std::printf("users: %zu, probes: %zu\n\n", users, dataset.probes.size());
+    std::printf("%-18s %12s %14s %12s\n", "path", "ns/match", "allocs/match", "mismatches");
+
+    size_t total_mismatches = 0;
+    auto run = [&](const char* name, std::vector<Outcome>& out, auto match) {
+        const size_t allocations = s_allocations.load();
+        auto start = bench_clock::now();
+        for (size_t user = 0; user < users; user++)
+        {
+            out[user].result = match(probe_of(user), dataset.gallery.GetFaceprints(user), out[user].updated);
+        }
+        const double elapsed_us = ElapsedUs(start);
+        const size_t loop_allocations = s_allocations.load() - allocations;
+
+        size_t mismatches = 0;
+        for (size_t user = 0; user < users && &out != &expected; user++)
+        {
+            const auto& a = expected[user];
+            const auto& b = out[user];
+            if (a.result.score != b.result.score || a.result.confidence != b.result.confidence ||
+                a.result.success != b.result.success || a.result.should_update != b.result.should_update ||
+                (a.result.should_update &&
+                 std::memcmp(a.updated.adaptiveDescriptorWithoutMask, b.updated.adaptiveDescriptorWithoutMask,
+                             RSID_NUMBER_OF_RECOGNITION_FACEPRINTS_MATCHER * sizeof(feature_t)) != 0))
+            {
+                mismatches++;
+            }
+        }
+        total_mismatches += mismatches;
+
+        std::printf("%-18s %12.1f %14.2f %12zu\n", name, 1000.0 * elapsed_us / users,
+                    static_cast<double>(loop_allocations) / users, mismatches);
+        return loop_allocations;
+    };
+
+    run("array (former)", expected, array_match);
+    size_t allocations = run("MatchFaceprints", outcomes, pair_match);
+    allocations += run("MatchDescriptors", outcomes, descriptor_match);
+
+    std::printf("\nheap allocations in single-pair loops: %zu\n", allocations);
+    return (total_mismatches == 0 && allocations == 0) ? 0 : 1;
+}
+
+static int RunNumaBenchmark(const CommandLineArgs& args)
+{
+    Dataset dataset;
+    MakeDataset(args, dataset);
+    const Thresholds thresholds = Matcher::GetDefaultThresholds();
+    const size_t users = dataset.gallery.Size();
+
+    const auto topology = DiscoverNumaNodes();
+    size_t cpus = 0;
+    for (const auto& node : topology)
+    {
+        cpus += node.cpus.size();
+    }
+
+    // one client per node, so replicas can serve queries in parallel. full scans, which are memory bound.
+    const size_t clients = topology.size();
+    const MatchSearchMode mode = MatchSearchMode::Exhaustive;
+
+    std::printf("users: %zu, queries: %zu, nodes: %zu, cpus: %zu, clients: %zu\n", users, dataset.probes.size(),
+                topology.size(), cpus, clients);
+    std::printf("search data: %.1f MB\n\n", users * Gallery::SearchBytesPerUser() / 1e6);
+
+    // queries/s of search(probe, result) with all clients, results stored by probe.
+    auto throughput = [&](std::vector<ExtendedMatchResult>& results, auto search) {
+        results.assign(dataset.probes.size(), ExtendedMatchResult());
+        std::atomic<size_t> next(0);
+        auto start = bench_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t c = 0; c < clients; c++)
+        {
+            threads.emplace_back([&] {
+                for (size_t q = next++; q < dataset.probes.size(); q = next++)
+                {
+                    Faceprints updated;
+                    results[q] = search(dataset.probes[q], updated);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        return dataset.probes.size() / (ElapsedUs(start) / 1e6);
+    };
+
+    std::vector<ExtendedMatchResult> expected;
+    double baseline_qps;
+    {
+        ParallelMatcher parallel(cpus);
+        baseline_qps = throughput(expected, [&](const Faceprints& probe, Faceprints& updated) {
+            return parallel.Match(probe, dataset.gallery, updated, thresholds, mode);
+        });
+    }
+
+    struct Placement
+    {
+        const char* name;
+        NumaMode mode;
+        HugePages huge_pages;
+    };
+    const Placement placements[] = {
+        {"partition", NumaMode::Partition, HugePages::None},
+        {"partition+thp", NumaMode::Partition, HugePages::Transparent},
+        {"partition+2MB", NumaMode::Partition, HugePages::Explicit2MB},
+        {"partition+1GB", NumaMode::Partition, HugePages::Explicit1GB},
+        {"replicate+thp", NumaMode::Replicate, HugePages::Transparent},
+        {"replicate+2MB", NumaMode::Replicate, HugePages::Explicit2MB},
+    };
+
+    std::printf("%-16s %10s %8s %10s %-28s %10s\n", "placement", "queries/s", "speedup", "build ms",
+                "obtained (node:backing)", "mismatches");
+    std::printf("%-16s %10.1f %8.2f %10s %-28s %10s\n", "heap (parallel)", baseline_qps, 1.0, "-", "-", "-");
+
+    size_t total_mismatches = 0;
+    for (const auto& placement : placements)
+    {
+        NumaGallery::Config config;
+        config.mode = placement.mode;
+        config.huge_pages = placement.huge_pages;
+        NumaGallery numa(config);
+
+        auto start = bench_clock::now();
+        if (!numa.Build(dataset.gallery))
+        {
+            std::printf("%-16s failed to allocate\n", placement.name);
+            total_mismatches++;
+            continue;
+        }
+        const double build_ms = ElapsedUs(start) / 1000;
+
+        std::vector<ExtendedMatchResult> results;
+        const double qps = throughput(results, [&](const Faceprints& probe, Faceprints& updated) {
+            return numa.Match(probe, dataset.gallery, updated, thresholds, mode);
+        });
+
+        size_t mismatches = 0;
+        for (size_t q = 0; q < results.size(); q++)
+        {
+            if (results[q].userId != expected[q].userId || results[q].maxScore != expected[q].maxScore ||
+                results[q].isSame != expected[q].isSame)
+            {
+                mismatches++;
+            }
+        }
+        total_mismatches += mismatches;
+
+        std::string obtained;
+        for (const auto& node : numa.Nodes())
+        {
+            obtained += (obtained.empty() ? "" : " ") + std::to_string(node.node) + ":" + HugePagesName(node.backing);
+            obtained += node.bound ? "" : "(unbound)";
+            obtained += (node.pinned_threads == node.threads) ? "" : "(unpinned)";
+        }
+
+        std::printf("%-16s %10.1f %8.2f %10.1f %-28s %10zu\n", placement.name, qps, qps / baseline_qps, build_ms,
+                    obtained.c_str(), mismatches);
+    }
+
+    std::printf("\nmismatches: %zu\n", total_mismatches);
+    return total_mismatches == 0 ? 0 : 1;
+}
+
+static int RunSuite(const CommandLineArgs& args)
+{
+    Bench::SuiteConfig config;
+    config.max_users = args.users;
+    config.queries = args.queries;
+    config.faceprints = args.faceprints;
+
+    bool passed;
+    if (args.json_path.empty())
+    {
+        passed = Bench::RunMatcherSuite(config, std::cout);
+    }
+    else
+    {
+        std::ofstream out(args.json_path);
+        if (!out)
+        {
+            std::cout << "failed to open " << args.json_path << "\n";
+            return 1;
+        }
+        passed = Bench::RunMatcherSuite(config, out);
+    }
+
+    if (!passed)
+    {
+        std::cerr << "accuracy cross-check failed\n";
+    }
+    return passed ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    auto args = ParseCommandLineArgs(argc, argv);
+    if (!args.is_valid)
+    {
+        return 1;
+    }
+
+    if (args.benchmark == "ivf")
+    {
+        return RunIvfBenchmark(args);
+    }
+
+    if (args.benchmark == "prefilter")
+    {
+        return RunPrefilterBenchmark(args);
+    }
+
+    if (args.benchmark == "pq")
+    {
+        return RunPqBenchmark(args);
+    }
+
+    if (args.benchmark == "mmap")
+    {
+        return RunMmapBenchmark(args);
+    }
+
+    if (args.benchmark == "rcu")
+    {
+        return RunRcuBenchmark(args);
+    }
+
+    if (args.benchmark == "bounds")
+    {
+        return RunBoundsBenchmark(args);
+    }
+
+    if (args.benchmark == "dedup")
+    {
+        return RunDedupBenchmark(args);
+    }
+
+    if (args.benchmark == "hitorder")
+    {
+        return RunHitOrderBenchmark(args);
+    }
+
+    if (args.benchmark == "multidesc")
+    {
+        return RunMultiDescriptorBenchmark(args);
+    }
+
+    if (args.benchmark == "filter")
+    {
+        return RunFilterBenchmark(args);
+    }
+
+    if (args.benchmark == "match1to1")
+    {
+        return RunMatch1to1Benchmark(args);
+    }
+
+    if (args.benchmark == "numa")
+    {
+        return RunNumaBenchmark(args);
+    }
+
+    if (args.benchmark == "suite")
+    {
+        return RunSuite(args);
+    }
+
+    std::cout << "unknown benchmark " << args.benchmark << "\n";
+    PrintUsage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,826 @@
+// License: Apache 2.0. See LICENSE file in root directory.
+// Copyright(c) 2020-2021 Intel Corporation. All Rights Reserved.
+
+// Serial packet receive benchmark over a pseudo-terminal pair: a device thread sends packets on the master side, the
+// host receives them with LinuxSerial + PacketSender on the slave side. Also times host packet sends (the device
+// receives and checks them), compares the event-driven and VTIME receive modes (latency, timeout precision, cancel of
+// a blocked receive), times operations with a new session each vs. resumed sessions against a simulated device, and
+// checks and times the packet crc.
+// Usage: rsid-serial-bench [--packets N] [--round-trips N] [--seed N]
+
+#include "PacketSender.h"
+#include "LinuxSerial.h"
+#include "NonSecureSession.h"
+#include "SerialConnection.h"
+#include "SerialPacket.h"
+#include "Crc16.h"
+#include "Timer.h"
+#ifdef RSID_SECURE
+#include "MbedtlsWrapper.h"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace RealSenseID::PacketManager;
+
+struct CommandLineArgs
+{
+    bool is_valid = false;
+    size_t packets = 20000;
+    size_t round_trips = 2000;
+    uint32_t seed = 1;
+};
+
+static void PrintUsage(const char* exe)
+{
+    std::cout << "usage: " << exe << " [--packets N] [--round-trips N] [--seed N]\n"
+              << "  --packets      packets streamed by the device for the throughput test\n"
+              << "  --round-trips  request/response exchanges for the latency test\n";
+}
+
+static CommandLineArgs ParseCommandLineArgs(int argc, char* argv[])
+{
+    CommandLineArgs args;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--packets") == 0 && i + 1 < argc)
+        {
+            args.packets = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--round-trips") == 0 && i + 1 < argc)
+        {
+            args.round_trips = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            args.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            std::cout << "unknown option " << argv[i] << "\n";
+            PrintUsage(argv[0]);
+            return args;
+        }
+    }
+
+    args.is_valid = args.packets > 0 && args.round_trips > 0;
+    return args;
+}
+
+// device side of the pseudo-terminal.
+class PtyDevice : public SerialConnection
+{
+public:
+    explicit PtyDevice(int master) : _master {master}
+    {
+    }
+
+    SerialStatus SendBytes(const char* buffer, size_t n_bytes) override
+    {
+        while (n_bytes > 0)
+        {
+            auto rv = ::write(_master, buffer, n_bytes);
+            if (rv <= 0)
+            {
+                return SerialStatus::SendFailed;
+            }
+            buffer += rv;
+            n_bytes -= static_cast<size_t>(rv);
+        }
+        return SerialStatus::Ok;
+    }
+
+protected:
+    SerialStatus ReadBytes(char* buffer, size_t n_bytes) override
+    {
+        while (n_bytes > 0)
+        {
+            auto rv = ::read(_master, buffer, n_bytes);
+            if (rv <= 0)
+            {
+                return SerialStatus::RecvFailed;
+            }
+            buffer += rv;
+            n_bytes -= static_cast<size_t>(rv);
+        }
+        return SerialStatus::Ok;
+    }
+
+    SerialStatus ReadAvailable(char* buffer, size_t max_bytes, size_t& n_read, const Timer&) override
+    {
+        auto rv = ::read(_master, buffer, max_bytes);
+        n_read = rv > 0 ? static_cast<size_t>(rv) : 0;
+        return rv > 0 ? SerialStatus::Ok : SerialStatus::RecvFailed;
+    }
+
+private:
+    int _master;
+};
+
+// the former PacketSender::Recv(): one read per sync byte, then protocol byte, header, payload and hmac+crc reads.
+static SerialStatus LegacyRecv(SerialConnection& serial, SerialPacket& target)
+{
+    Timer timer {std::chrono::milliseconds {5000}};
+    ::memset(reinterpret_cast<char*>(&target), 0, sizeof(target));
+
+    bool synced = false;
+    while (!synced && !timer.ReachedTimeout())
+    {
+        auto status = serial.RecvBytes(reinterpret_cast<char*>(&target.header.sync1), 1);
+        if (status == SerialStatus::Ok && target.header.sync1 == SyncByte::Sync1)
+        {
+            status = serial.RecvBytes(reinterpret_cast<char*>(&target.header.sync2), 1);
+            synced = (status == SerialStatus::Ok && target.header.sync2 == SyncByte::Sync2);
+        }
+    }
+    if (!synced)
+    {
+        return SerialStatus::RecvTimeout;
+    }
+
+    auto status = serial.RecvBytes((char*)&target.header.protocol_ver, 1);
+    if (status != SerialStatus::Ok || target.header.protocol_ver != ProtocolVer)
+    {
+        return SerialStatus::VersionMismatch;
+    }
+    status = serial.RecvBytes(reinterpret_cast<char*>(&target) + 3, sizeof(target.header) - 3);
+    if (status != SerialStatus::Ok || target.header.payload_size > sizeof(SerialPacket::payload))
+    {
+        return SerialStatus::RecvFailed;
+    }
+    status = serial.RecvBytes(reinterpret_cast<char*>(&target.payload), target.header.payload_size);
+    if (status != SerialStatus::Ok)
+    {
+        return status;
+    }
+    status = serial.RecvBytes(target.hmac, sizeof(target.hmac));
+    if (status != SerialStatus::Ok)
+    {
+        return status;
+    }
+    status = serial.RecvBytes(reinterpret_cast<char*>(&target.crc), sizeof(target.crc));
+    if (status != SerialStatus::Ok)
+    {
+        return status;
+    }
+
+    auto crc = Crc16(reinterpret_cast<const char*>(&target), sizeof(target) - sizeof(target.crc));
+    return crc == target.crc ? SerialStatus::Ok : SerialStatus::CrcError;
+}
+
+// packet number n of the stream: sequence number n, deterministic payload of random size.
+static DataPacket MakePacket(uint32_t n, size_t payload_size)
+{
+    DataPacket packet {MsgId::GetUserFeatures};
+    packet.header.payload_size = static_cast<uint16_t>(payload_size);
+    packet.payload.sequence_number = n;
+    for (size_t i = sizeof(uint32_t); i < payload_size; i++)
+    {
+        reinterpret_cast<char*>(&packet.payload)[i] = static_cast<char>((n + i) * 31);
+    }
+    return packet;
+}
+
+static bool IsExpectedPacket(const SerialPacket& packet, uint32_t n)
+{
+    if (packet.payload.sequence_number != n)
+    {
+        return false;
+    }
+    for (size_t i = sizeof(uint32_t); i < packet.header.payload_size; i++)
+    {
+        if (reinterpret_cast<const char*>(&packet.payload)[i] != static_cast<char>((n + i) * 31))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// read ("syscr:") or write ("syscw:") syscalls of the process so far.
+static uint64_t CountSyscalls(const char* counter)
+{
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    uint64_t value = 0;
+    while (io >> key >> value)
+    {
+        if (key == counter)
+        {
+            return value;
+        }
+    }
+    return 0;
+}
+
+static uint64_t ReadSyscalls()
+{
+    return CountSyscalls("syscr:");
+}
+
+using bench_clock = std::chrono::steady_clock;
+
+// bit-at-a-time crc-16/aug-ccitt reference.
+static uint16_t ReferenceCrc16(uint16_t crc, const char* buffer, size_t n_bytes)
+{
+    for (size_t i = 0; i < n_bytes; i++)
+    {
+        crc ^= static_cast<uint16_t>(static_cast<unsigned char>(buffer[i]) << 8);
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+// the former Crc16(): one table lookup per byte.
+static uint16_t BytewiseCrc16(uint16_t crc, const char* buffer, size_t n_bytes)
+{
+    static uint16_t table[256];
+    if (table[1] == 0)
+    {
+        for (unsigned int b = 0; b < 256; b++)
+        {
+            char byte = static_cast<char>(b);
+            table[b] = ReferenceCrc16(0, &byte, 1);
+        }
+    }
+
+    unsigned int value = crc;
+    for (size_t i = 0; i < n_bytes; i++)
+    {
+        value = (table[((value >> 8) ^ static_cast<unsigned char>(buffer[i])) & 0xff] ^ (value << 8)) & 0xffff;
+    }
+    return static_cast<uint16_t>(value);
+}
+
+// Crc16/Crc16Zeros vs. the reference on random lengths and contents, then cpu time per packet crc.
+static bool RunCrc(const CommandLineArgs& args)
+{
+    std::mt19937 rng(args.seed);
+    std::vector<char> data(8192);
+    for (auto& byte : data)
+    {
+        byte = static_cast<char>(rng());
+    }
+
+    size_t mismatches = 0;
+    std::vector<char> zeros(data.size(), 0);
+    for (int i = 0; i < 2000; i++)
+    {
+        const size_t offset = rng() % 64;
+        const size_t length = rng() % (data.size() - 64);
+        const uint16_t initial = static_cast<uint16_t>(rng());
+        mismatches += Crc16(initial, &data[offset], length) != ReferenceCrc16(initial, &data[offset], length);
+        mismatches += Crc16Zeros(initial, length) != ReferenceCrc16(initial, zeros.data(), length);
+    }
+
+    std::printf("crc: %zu mismatches vs. bitwise reference\n", mismatches);
+    std::printf("%-10s %8s %16s %16s %8s\n", "payload", "packets", "former ns/crc", "new ns/crc", "speedup");
+
+    const size_t iterations = args.packets * 10;
+    volatile unsigned int sink = 0; // keeps the timed loops
+    for (size_t payload_size : {static_cast<size_t>(16), static_cast<size_t>(256), sizeof(SerialPacket::payload)})
+    {
+        DataPacket packet = MakePacket(1, payload_size);
+        const char* bytes = reinterpret_cast<const char*>(&packet);
+
+        // the former packet crc: every byte but the crc field.
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            sink = sink + BytewiseCrc16(0x1d0f, bytes, sizeof(packet) - sizeof(packet.crc));
+        }
+        const double former_ns = std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+
+        // transmitted bytes with slicing-by-8, zero payload tail folded in.
+        start = bench_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            auto crc = Crc16(bytes, sizeof(packet.header) + payload_size);
+            crc = Crc16Zeros(crc, sizeof(packet.payload) - payload_size);
+            sink = sink + Crc16(crc, packet.hmac, sizeof(packet.hmac));
+        }
+        const double fast_ns = std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+
+        auto expected = BytewiseCrc16(0x1d0f, bytes, sizeof(packet) - sizeof(packet.crc));
+        auto crc = Crc16Zeros(Crc16(bytes, sizeof(packet.header) + payload_size), sizeof(packet.payload) - payload_size);
+        mismatches += Crc16(crc, packet.hmac, sizeof(packet.hmac)) != expected;
+
+        std::printf("%-10zu %8zu %16.1f %16.1f %8.1f\n", payload_size, iterations, former_ns / iterations,
+                    fast_ns / iterations, former_ns / fast_ns);
+    }
+
+    std::printf("\n");
+    return mismatches == 0;
+}
+
+using RecvFunction = SerialStatus (*)(SerialConnection&, SerialPacket&);
+using SendFunction = SerialStatus (*)(LinuxSerial&, SerialPacket&);
+
+// the former PacketSender::SendBinary(): preamble, header + payload, hmac and crc writes, each followed by tcdrain.
+static SerialStatus LegacySend(LinuxSerial& serial, SerialPacket& packet)
+{
+    ::memset(reinterpret_cast<char*>(&packet.payload) + packet.header.payload_size, 0,
+             sizeof(packet.payload) - packet.header.payload_size);
+    auto crc = Crc16(reinterpret_cast<const char*>(&packet), sizeof(packet) - sizeof(packet.crc));
+    const SendBuffer buffers[] = {
+        {Commands::face_api, ::strlen(Commands::face_api)},
+        {reinterpret_cast<const char*>(&packet), sizeof(packet.header) + packet.header.payload_size},
+        {packet.hmac, sizeof(packet.hmac)},
+        {reinterpret_cast<const char*>(&crc), sizeof(crc)}};
+    for (const auto& buffer : buffers)
+    {
+        auto status = serial.SendBytes(buffer.data, buffer.size);
+        if (status == SerialStatus::Ok)
+        {
+            status = serial.Drain();
+        }
+        if (status != SerialStatus::Ok)
+        {
+            return status;
+        }
+    }
+    return SerialStatus::Ok;
+}
+
+static SerialStatus GatherSend(LinuxSerial& serial, SerialPacket& packet)
+{
+    PacketSender sender {&serial};
+    return sender.SendBinary(packet);
+}
+
+static SerialStatus BufferedRecv(SerialConnection& serial, SerialPacket& target)
+{
+    PacketSender sender {&serial};
+    return sender.Recv(target);
+}
+
+struct Pty
+{
+    int master = -1;
+    std::string slave;
+};
+
+static bool OpenPty(Pty& pty)
+{
+    pty.master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty.master < 0 || ::grantpt(pty.master) != 0 || ::unlockpt(pty.master) != 0)
+    {
+        std::cout << "failed to open a pseudo-terminal\n";
+        return false;
+    }
+    pty.slave = ::ptsname(pty.master);
+    return true;
+}
+
+// device streams packets (with log text between some of them), host receives them all.
+static bool RunThroughput(const char* name, RecvFunction recv, const CommandLineArgs& args)
+{
+    Pty pty;
+    if (!OpenPty(pty))
+    {
+        return false;
+    }
+
+    SerialConfig config;
+    config.port = pty.slave.c_str();
+    LinuxSerial host {config};
+    PtyDevice device {pty.master};
+
+    std::mt19937 rng(args.seed);
+    std::uniform_int_distribution<size_t> payload_size(sizeof(uint32_t), sizeof(SerialPacket::payload));
+    std::vector<size_t> sizes(args.packets);
+    size_t bytes = 0;
+    for (auto& size : sizes)
+    {
+        size = payload_size(rng);
+        bytes += sizeof(SerialPacket::header) + size + sizeof(SerialPacket::hmac) + sizeof(SerialPacket::crc);
+    }
+
+    std::thread device_thread([&] {
+        static const char* log_line = "\r\n[fw] frame processed\r\n";
+        for (size_t n = 0; n < args.packets; n++)
+        {
+            if (n % 10 == 0)
+            {
+                (void)device.SendBytes(log_line, ::strlen(log_line));
+            }
+            DataPacket packet = MakePacket(static_cast<uint32_t>(n), sizes[n]);
+            PacketSender sender {&device};
+            if (sender.Send(packet) != SerialStatus::Ok)
+            {
+                return;
+            }
+        }
+    });
+
+    const uint64_t syscalls = ReadSyscalls();
+    size_t errors = 0;
+    auto start = bench_clock::now();
+    for (size_t n = 0; n < args.packets; n++)
+    {
+        SerialPacket packet;
+        if (recv(host, packet) != SerialStatus::Ok || !IsExpectedPacket(packet, static_cast<uint32_t>(n)))
+        {
+            errors++;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    const uint64_t reads = ReadSyscalls() - syscalls;
+    device_thread.join();
+    ::close(pty.master);
+
+    std::printf("%-10s %12.0f %10.1f %14.2f %8zu\n", name, args.packets / seconds, bytes / seconds / 1e6,
+                static_cast<double>(reads) / args.packets, errors);
+    return errors == 0;
+}
+
+// host sends packets, the device receives and checks them all. a pseudo-terminal has no baud rate, so tcdrain only
+// waits for the device to read - on a real uart each drain also waits for the bytes to leave the wire.
+static bool RunSend(const char* name, SendFunction send, bool drain_after_send, const CommandLineArgs& args)
+{
+    Pty pty;
+    if (!OpenPty(pty))
+    {
+        return false;
+    }
+
+    SerialConfig config;
+    config.port = pty.slave.c_str();
+    config.drain_after_send = drain_after_send;
+    LinuxSerial host {config};
+
+    std::mt19937 rng(args.seed);
+    std::uniform_int_distribution<size_t> payload_size(sizeof(uint32_t), sizeof(SerialPacket::payload));
+    std::vector<size_t> sizes(args.packets);
+    for (auto& size : sizes)
+    {
+        size = payload_size(rng);
+    }
+
+    std::atomic<size_t> errors {0};
+    std::thread device_thread([&] {
+        PtyDevice device {pty.master};
+        PacketSender receiver {&device};
+        for (size_t n = 0; n < args.packets; n++)
+        {
+            SerialPacket packet;
+            if (receiver.Recv(packet) != SerialStatus::Ok || !IsExpectedPacket(packet, static_cast<uint32_t>(n)))
+            {
+                errors++;
+            }
+        }
+    });
+
+    const uint64_t syscalls = CountSyscalls("syscw:");
+    auto start = bench_clock::now();
+    for (size_t n = 0; n < args.packets; n++)
+    {
+        DataPacket packet = MakePacket(static_cast<uint32_t>(n), sizes[n]);
+        if (send(host, packet) != SerialStatus::Ok)
+        {
+            errors++;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    const uint64_t writes = CountSyscalls("syscw:") - syscalls;
+    device_thread.join();
+    ::close(pty.master);
+
+    std::printf("%-14s %12.0f %12.2f %15.2f %8zu\n", name, args.packets / seconds, seconds * 1e6 / args.packets,
+                static_cast<double>(writes) / args.packets, errors.load());
+    return errors == 0;
+}
+
+// host sends a request byte, the device answers with a packet. round trip latency in us.
+static bool RunLatency(const char* name, RecvFunction recv, size_t payload_size, const CommandLineArgs& args)
+{
+    Pty pty;
+    if (!OpenPty(pty))
+    {
+        return false;
+    }
+
+    SerialConfig config;
+    config.port = pty.slave.c_str();
+    LinuxSerial host {config};
+
+    std::thread device_thread([&] {
+        for (size_t n = 0; n < args.round_trips; n++)
+        {
+            char request;
+            if (::read(pty.master, &request, 1) != 1)
+            {
+                return;
+            }
+            DataPacket packet = MakePacket(static_cast<uint32_t>(n), payload_size);
+            PtyDevice device {pty.master};
+            PacketSender sender {&device};
+            if (sender.Send(packet) != SerialStatus::Ok)
+            {
+                return;
+            }
+        }
+    });
+
+    std::vector<double> latencies;
+    size_t errors = 0;
+    for (size_t n = 0; n < args.round_trips; n++)
+    {
+        auto start = bench_clock::now();
+        SerialPacket packet;
+        if (host.SendBytes("r", 1) != SerialStatus::Ok || recv(host, packet) != SerialStatus::Ok ||
+            !IsExpectedPacket(packet, static_cast<uint32_t>(n)))
+        {
+            errors++;
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(bench_clock::now() - start).count());
+    }
+    device_thread.join();
+    ::close(pty.master);
+
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%-10s %8zu %10.1f %10.1f %10.1f %8zu\n", name, payload_size, latencies[latencies.size() / 2],
+                latencies[latencies.size() * 99 / 100], latencies.back(), errors);
+    return errors == 0;
+}
+
+static double Percentile(std::vector<double>& values, size_t percent)
+{
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, values.size() * percent / 100)];
+}
+
+// round trips, timeouts of a 1 byte RecvBytes() with no data, and InterruptRecv() of a receive blocked with no data,
+// in event-driven or VTIME receive mode.
+static bool RunRecvMode(const char* name, bool event_driven, const CommandLineArgs& args)
+{
+    Pty pty;
+    if (!OpenPty(pty))
+    {
+        return false;
+    }
+
+    SerialConfig config;
+    config.port = pty.slave.c_str();
+    config.event_driven = event_driven;
+    LinuxSerial host {config};
+
+    // round trips: the device answers each request byte with a 64 bytes packet
+    std::thread device_thread([&] {
+        PtyDevice device {pty.master};
+        for (size_t n = 0; n < args.round_trips; n++)
+        {
+            char request;
+            if (::read(pty.master, &request, 1) != 1)
+            {
+                return;
+            }
+            DataPacket packet = MakePacket(static_cast<uint32_t>(n), 64);
+            PacketSender sender {&device};
+            if (sender.Send(packet) != SerialStatus::Ok)
+            {
+                return;
+            }
+        }
+    });
+
+    std::vector<double> round_trips;
+    size_t errors = 0;
+    for (size_t n = 0; n < args.round_trips; n++)
+    {
+        auto start = bench_clock::now();
+        SerialPacket packet;
+        if (host.SendBytes("r", 1) != SerialStatus::Ok || BufferedRecv(host, packet) != SerialStatus::Ok ||
+            !IsExpectedPacket(packet, static_cast<uint32_t>(n)))
+        {
+            errors++;
+        }
+        round_trips.push_back(std::chrono::duration<double, std::micro>(bench_clock::now() - start).count());
+    }
+    device_thread.join();
+    const auto wakeups = host.GetWakeupStats();
+
+    // timeouts: RecvBytes(1) waits 204ms
+    std::vector<double> timeouts;
+    for (int i = 0; i < 3; i++)
+    {
+        char byte;
+        auto start = bench_clock::now();
+        if (host.RecvBytes(&byte, 1) != SerialStatus::RecvTimeout)
+        {
+            errors++;
+        }
+        timeouts.push_back(std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+    }
+
+    // cancel: interrupt a packet receive (5s timeout) 20ms after it started waiting
+    std::vector<double> cancels;
+    for (int i = 0; i < 10; i++)
+    {
+        std::atomic<int64_t> interrupted_at {0};
+        std::thread cancel_thread([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds {20});
+            interrupted_at = bench_clock::now().time_since_epoch().count();
+            host.InterruptRecv();
+        });
+        SerialPacket packet;
+        if (BufferedRecv(host, packet) != SerialStatus::RecvInterrupted)
+        {
+            errors++;
+        }
+        auto returned_at = bench_clock::now();
+        cancel_thread.join();
+        auto interrupted = bench_clock::time_point {bench_clock::duration {interrupted_at.load()}};
+        cancels.push_back(std::chrono::duration<double, std::milli>(returned_at - interrupted).count());
+    }
+    ::close(pty.master);
+
+    const double wakeup_mean = wakeups.wakeups ? wakeups.total_ns / 1e3 / wakeups.wakeups : 0;
+    const double rtt_p50 = Percentile(round_trips, 50);
+    const double rtt_p99 = Percentile(round_trips, 99);
+    const double timeout_p50 = Percentile(timeouts, 50);
+    const double timeout_max = Percentile(timeouts, 100);
+    const double cancel_p50 = Percentile(cancels, 50);
+    const double cancel_max = Percentile(cancels, 100);
+    std::printf("%-8s %8.1f %8.1f %11.1f %11.1f %10.2f %10.2f %12.2f %10.2f %8s %8zu\n", name, rtt_p50, rtt_p99,
+                timeout_p50, timeout_max, cancel_p50, cancel_max, wakeup_mean, wakeups.max_ns / 1e3,
+                host.IsLowLatency() ? "yes" : "no", errors);
+    return errors == 0;
+}
+
+// simulated device of the session test: answers StartSession and each request with a packet of the same id, sequence
+// numbers restart with each session like the firmware. with lose_session_every, the device loses its session (like
+// after a reboot) every that many requests. returns when the host closes its side.
+static void RunSessionDevice(int master, size_t lose_session_every, std::atomic<size_t>& handshakes)
+{
+    PtyDevice device {master};
+    PacketSender sender {&device};
+    uint32_t sequence_number = 0;
+    for (size_t n = 1;; n++)
+    {
+        if (lose_session_every > 0 && n % lose_session_every == 0)
+        {
+            sequence_number = 0;
+        }
+        DataPacket packet {MsgId::None};
+        if (sender.Recv(packet) != SerialStatus::Ok)
+        {
+            return;
+        }
+        DataPacket reply {packet.header.id};
+        if (packet.header.id == MsgId::StartSession)
+        {
+            sequence_number = 0;
+            handshakes++;
+        }
+        else
+        {
+            reply.payload.sequence_number = ++sequence_number;
+        }
+        if (sender.SendBinary(reply) != SerialStatus::Ok)
+        {
+            return;
+        }
+    }
+}
+
+// operations (session start or resume, request, reply) under a session policy. us per operation.
+static bool RunSession(const char* name, const SessionPolicy& policy, size_t lose_session_every,
+                       const CommandLineArgs& args)
+{
+    Pty pty;
+    if (!OpenPty(pty))
+    {
+        return false;
+    }
+
+    std::atomic<size_t> handshakes {0};
+    std::thread device_thread(RunSessionDevice, pty.master, lose_session_every, std::ref(handshakes));
+
+    std::vector<double> latencies;
+    size_t errors = 0;
+    {
+        SerialConfig config;
+        config.port = pty.slave.c_str();
+        LinuxSerial host {config};
+        NonSecureSession session;
+        for (size_t n = 0; n < args.round_trips; n++)
+        {
+            auto start = bench_clock::now();
+            DataPacket packet {MsgId::GetNumberOfUsers};
+            if (session.Resume(&host, policy) != SerialStatus::Ok || session.SendPacket(packet) != SerialStatus::Ok ||
+                session.RecvDataPacket(packet) != SerialStatus::Ok || packet.header.id != MsgId::GetNumberOfUsers)
+            {
+                errors++;
+            }
+            latencies.push_back(std::chrono::duration<double, std::micro>(bench_clock::now() - start).count());
+        }
+    } // closing the host side ends the device
+
+    device_thread.join();
+    ::close(pty.master);
+
+    const double p50 = Percentile(latencies, 50);
+    const double p99 = Percentile(latencies, 99);
+    std::printf("%-22s %10.1f %10.1f %12zu %8zu\n", name, p50, p99, handshakes.load(), errors);
+    return errors == 0;
+}
+
+#ifdef RSID_SECURE
+// host and device crypto of one secure session handshake: each side generates a signed ecdh key, verifies the other
+// side's key and derives the session keys (signatures are not checked here).
+static double SecureHandshakeCryptoUs(size_t iterations)
+{
+    auto sign = [](const unsigned char*, const unsigned int, unsigned char* sig) {
+        ::memset(sig, 0, ECC_P256_SIG_SIZE_BYTES);
+        return true;
+    };
+    auto verify = [](const unsigned char*, const unsigned int, const unsigned char*, const unsigned int) {
+        return true;
+    };
+
+    auto start = bench_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        MbedtlsWrapper host;
+        MbedtlsWrapper device;
+        const unsigned char* host_key = host.GetSignedEcdhPubkey(sign);
+        const unsigned char* device_key = device.GetSignedEcdhPubkey(sign);
+        if (host_key == nullptr || device_key == nullptr || !device.VerifyEcdhSignedKey(host_key, verify) ||
+            !host.VerifyEcdhSignedKey(device_key, verify))
+        {
+            return -1;
+        }
+    }
+    return std::chrono::duration<double, std::micro>(bench_clock::now() - start).count() / iterations;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    auto args = ParseCommandLineArgs(argc, argv);
+    if (!args.is_valid)
+    {
+        return 1;
+    }
+
+    bool ok = RunCrc(args);
+    std::printf("throughput: %zu packets, random payload sizes, log text before every 10th packet\n", args.packets);
+    std::printf("%-10s %12s %10s %14s %8s\n", "recv", "packets/s", "MB/s", "reads/packet", "errors");
+    ok = RunThroughput("legacy", LegacyRecv, args) && ok;
+    ok = RunThroughput("buffered", BufferedRecv, args) && ok;
+
+    std::printf("\nsend: %zu packets with the __FACE_API__ preamble, random payload sizes\n", args.packets);
+    std::printf("%-14s %12s %12s %15s %8s\n", "send", "packets/s", "us/packet", "writes/packet", "errors");
+    ok = RunSend("legacy", LegacySend, false, args) && ok;
+    ok = RunSend("gather", GatherSend, false, args) && ok;
+    ok = RunSend("gather+drain", GatherSend, true, args) && ok;
+
+    std::printf("\nrecv mode: %zu round trips (64 bytes), RecvBytes timeout (204ms), cancel of a blocked receive\n",
+                args.round_trips);
+    std::printf("%-8s %8s %8s %11s %11s %10s %10s %12s %10s %8s %8s\n", "mode", "rtt p50", "rtt p99", "timeout ms",
+                "timeout max", "cancel ms", "cancel max", "wakeup us", "wakeup max", "lowlat", "errors");
+    ok = RunRecvMode("vtime", false, args) && ok;
+    ok = RunRecvMode("event", true, args) && ok;
+
+    std::printf("\nsessions: %zu operations (session start or resume, request, reply) with a simulated device\n",
+                args.round_trips);
+    std::printf("%-22s %10s %10s %12s %8s\n", "session", "op us p50", "op us p99", "handshakes", "errors");
+    SessionPolicy policy;
+    ok = RunSession("new per op", policy, 0, args) && ok;
+    policy.resume = true;
+    policy.max_operations = 100;
+    ok = RunSession("resume, 100 ops", policy, 0, args) && ok;
+    policy.max_operations = 0;
+    ok = RunSession("resume", policy, 0, args) && ok;
+    ok = RunSession("resume, device resets", policy, 250, args) && ok;
+#ifdef RSID_SECURE
+    std::printf("secure handshake crypto (host + device side, on this cpu): %.0f us\n", SecureHandshakeCryptoUs(20));
+#endif
+
+    std::printf("\nround trip latency (us): %zu request/response exchanges\n", args.round_trips);
+    std::printf("%-10s %8s %10s %10s %10s %8s\n", "recv", "payload", "p50", "p99", "max", "errors");
+    for (size_t payload_size : {static_cast<size_t>(64), sizeof(SerialPacket::payload)})
+    {
+        ok = RunLatency("legacy", LegacyRecv, payload_size, args) && ok;
+        ok = RunLatency("buffered", BufferedRecv, payload_size, args) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
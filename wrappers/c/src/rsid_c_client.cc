@@ -523,27 +523,6 @@ rsid_status rsid_authenticate(rsid_authenticator* authenticator, const rsid_auth
 }
 
 
-static RealSenseID::Faceprints convert_to_cpp_faceprints(rsid_faceprints* rsid_faceprints_instance)
-{
-    RealSenseID::Faceprints faceprints;
-    faceprints.version = rsid_faceprints_instance->version;
-    faceprints.featuresType = (RealSenseID::FaceprintsTypeEnum)rsid_faceprints_instance->featuresType;
-
-    static_assert(sizeof(faceprints.adaptiveDescriptorWithoutMask) == sizeof(rsid_faceprints_instance->adaptive_without_mask_descriptor), "updated faceprints (without mask) sizes does not match");
-    ::memcpy(&faceprints.adaptiveDescriptorWithoutMask[0], &rsid_faceprints_instance->adaptive_without_mask_descriptor[0],
-             sizeof(faceprints.adaptiveDescriptorWithoutMask));
-
-    static_assert(sizeof(faceprints.adaptiveDescriptorWithMask) == sizeof(rsid_faceprints_instance->adaptive_with_mask_descriptor), "updated faceprints (with mask) sizes does not match");
-    ::memcpy(&faceprints.adaptiveDescriptorWithMask[0], &rsid_faceprints_instance->adaptive_with_mask_descriptor[0],
-             sizeof(faceprints.adaptiveDescriptorWithMask));
-
-    static_assert(sizeof(faceprints.enrollmentDescriptor) == sizeof(rsid_faceprints_instance->enrollement_descriptor), "enrollment faceprints sizes does not match");
-    ::memcpy(&faceprints.enrollmentDescriptor[0], &rsid_faceprints_instance->enrollement_descriptor[0],
-             sizeof(faceprints.enrollmentDescriptor));
-
-    return faceprints;
-}
-
 rsid_status rsid_extract_faceprints_for_enroll(rsid_authenticator* authenticator, rsid_enroll_ext_args* args)
 {
     auto* auth_impl = get_auth_impl(authenticator);
@@ -573,13 +552,34 @@ rsid_match_result rsid_match_faceprints(rsid_authenticator* authenticator, rsid_
 {
     auto* auth_impl = get_auth_impl(authenticator);
 
-    Faceprints new_faceprints = convert_to_cpp_faceprints(&args->new_faceprints);
-    Faceprints existing_faceprints = convert_to_cpp_faceprints(&args->existing_faceprints);
-    Faceprints updated_faceprints = convert_to_cpp_faceprints(&args->updated_faceprints);
+    rsid_match_result match_result;
+    match_result.should_update = 0;
+    match_result.success = 0;
+    match_result.score = 0;
+    match_result.confidence = 0;
+
+    const rsid_faceprints* new_faceprints = &args->new_faceprints;
+    const rsid_faceprints* existing_faceprints = &args->existing_faceprints;
+    if (new_faceprints->version != existing_faceprints->version)
+    {
+        // same as MatchFaceprints() - vectors of different versions are not matched.
+        return match_result;
+    }
 
-    auto result = auth_impl->MatchFaceprints(new_faceprints, existing_faceprints, updated_faceprints);
+    // match the descriptors in place. the updated adaptive descriptor is written straight to args->updated_faceprints
+    // so Authenticator.cs will have the updated vector (it is written only if should_update).
+    rsid_faceprints* rsid_updated_faceprints = &args->updated_faceprints;
+
+    // TODO yossidan - handle with/without mask vectors properly (if/as needed).
+
+    static_assert(sizeof(rsid_updated_faceprints->adaptive_without_mask_descriptor) == sizeof(Faceprints::adaptiveDescriptorWithoutMask),"adaptive faceprints (without mask) sizes does not match");
+    static_assert(sizeof(rsid_updated_faceprints->enrollement_descriptor) == sizeof(Faceprints::enrollmentDescriptor),"enrollment faceprints sizes does not match");
+
+    auto result = auth_impl->MatchDescriptors(&new_faceprints->adaptive_without_mask_descriptor[0],
+                                              &existing_faceprints->adaptive_without_mask_descriptor[0],
+                                              &existing_faceprints->enrollement_descriptor[0],
+                                              &rsid_updated_faceprints->adaptive_without_mask_descriptor[0]);
 
-    rsid_match_result match_result;
     match_result.should_update = result.should_update;
     match_result.success = result.success;
     match_result.score = (int)result.score;
@@ -588,16 +588,8 @@ rsid_match_result rsid_match_faceprints(rsid_authenticator* authenticator, rsid_
     // save the updated vector to your DB here.
     if (result.success && result.should_update)
     {
-        // write the updated avg faceprints on the args->updated_faceprints so Authenticator.cs will have the updated vector!
-        rsid_faceprints* rsid_updated_faceprints = &args->updated_faceprints;
-
-        // TODO yossidan - handle with/without mask vectors properly (if/as needed).
-        
-        static_assert(sizeof(rsid_updated_faceprints->adaptive_without_mask_descriptor) == sizeof(updated_faceprints.adaptiveDescriptorWithoutMask),"adaptive faceprints (without mask) sizes does not match");
-        ::memcpy(&rsid_updated_faceprints->adaptive_without_mask_descriptor[0], &updated_faceprints.adaptiveDescriptorWithoutMask[0], sizeof(updated_faceprints.adaptiveDescriptorWithoutMask));
-        
-        static_assert(sizeof(rsid_updated_faceprints->enrollement_descriptor) == sizeof(updated_faceprints.enrollmentDescriptor),"enrollment faceprints sizes does not match");
-        ::memcpy(&rsid_updated_faceprints->enrollement_descriptor[0], &updated_faceprints.enrollmentDescriptor[0], sizeof(updated_faceprints.enrollmentDescriptor));
+        ::memcpy(&rsid_updated_faceprints->enrollement_descriptor[0], &existing_faceprints->enrollement_descriptor[0],
+                 sizeof(existing_faceprints->enrollement_descriptor));
     }
 
     return match_result;